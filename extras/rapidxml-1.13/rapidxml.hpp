@@ -120,9 +120,17 @@ namespace rapidxml
     // Size of dynamic memory block of memory_pool.
     // Define RAPIDXML_DYNAMIC_POOL_SIZE before including rapidxml.hpp if you want to override the default value.
     // After the static block is exhausted, dynamic blocks with approximately this size are allocated by memory_pool.
+    // This is the default of memory_pool_config::block_size, which can be changed at runtime.
     #define RAPIDXML_DYNAMIC_POOL_SIZE (64 * 1024)
 #endif
 
+#if !defined(RAPIDXML_NO_HUGE_PAGES) && defined(__linux__)
+    // Dynamic blocks of memory_pool may be backed by transparent huge pages (see memory_pool_config::huge_pages).
+    // Define RAPIDXML_NO_HUGE_PAGES before including rapidxml.hpp to always allocate blocks with new[].
+    #define RAPIDXML_HUGE_PAGES
+    #include <sys/mman.h>
+#endif
+
 #ifndef RAPIDXML_ALIGNMENT
     // Memory allocation alignment.
     // Define RAPIDXML_ALIGNMENT before including rapidxml.hpp if you want to override the default value, which is the size of pointer.
@@ -131,6 +139,42 @@ namespace rapidxml
     #define RAPIDXML_ALIGNMENT sizeof(void *)
 #endif
 
+///////////////////////////////////////////////////////////////////////////
+// Vectorized scanning
+
+#if !defined(RAPIDXML_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    // Runs of characters are classified 16 or 32 at a time by SSE2, SSSE3 or AVX2 kernels.
+    // The best kernel supported by the executing cpu is selected at runtime.
+    // Define RAPIDXML_NO_SIMD before including rapidxml.hpp to use the scalar lookup tables only.
+    // Define RAPIDXML_NO_SSSE3 or RAPIDXML_NO_AVX2 to leave out the respective kernels.
+    #define RAPIDXML_SIMD
+    #include <emmintrin.h>
+    #ifndef RAPIDXML_NO_SSSE3
+        #include <tmmintrin.h>
+    #endif
+    #ifndef RAPIDXML_NO_AVX2
+        #include <immintrin.h>
+    #endif
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+    #if defined(__GNUC__) || defined(__clang__)
+        #define RAPIDXML_TARGET(isa) __attribute__((target(isa)))
+    #else
+        #define RAPIDXML_TARGET(isa)
+    #endif
+#endif
+
+///////////////////////////////////////////////////////////////////////////
+// Parse statistics
+
+#ifdef RAPIDXML_PARSE_STATISTICS
+    // Define RAPIDXML_PARSE_STATISTICS before including rapidxml.hpp to let xml_document::parse() fill in a parse_statistics collector.
+    // It changes the layout of memory_pool and xml_document, so it must be defined alike in all translation units.
+    // Without it, no counting or timing code is compiled.
+    #include <chrono>
+#endif
+
 namespace rapidxml
 {
     // Forward declarations
@@ -246,6 +290,17 @@ namespace rapidxml
     //! See xml_document::parse() function.
     const int parse_normalize_whitespace = 0x800;
 
+    //! Parse flag instructing the parser to resolve namespace prefixes of element names.
+    //! Every element gets the id of its namespace URI (see xml_node::namespace_id()), 
+    //! and the document keeps the table of URIs (see xml_document::namespace_uri()).
+    //! Declarations stay in place as ordinary xmlns attributes; attribute names are not resolved.
+    //! A prefix without a declaration in scope is an error.
+    //! By default, namespaces are not resolved.
+    //! Can be combined with other flags by use of | operator.
+    //! <br><br>
+    //! See xml_document::parse() function.
+    const int parse_namespaces = 0x1000;
+
     // Compound flags
     
     //! Parse flags which represent default behaviour of the parser. 
@@ -335,9 +390,545 @@ namespace rapidxml
             }
             return true;
         }
+
+#ifdef RAPIDXML_SIMD
+
+        // Instruction sets of the vectorized scanners
+        enum simd_level
+        {
+            simd_sse2,
+            simd_ssse3,
+            simd_avx2
+        };
+
+        // Set of ASCII characters classified by the vectorized scanners.
+        // Character c < 0x80 is a member if lo[c & 0xF] & hi[c >> 4] is non-zero, characters >= 0x80 never are.
+        // Scanners stop at the first member, or at the first non-member if negate is set.
+        struct simd_charset
+        {
+            unsigned char lo[16];       // Member bits indexed by low nibble
+            unsigned char hi[16];       // Bit of each high nibble, zero for non-ASCII
+            unsigned char chars[16];    // Members listed one by one
+            int count;                  // Number of members
+            bool negate;                // Stop at non-members instead of members
+            bool usable;                // False if members do not fit the scanners, callers then use scalar loop
+
+            // Build set stopping exactly where predicate stops
+            template<class Pred, class Ch>
+            static simd_charset from_pred()
+            {
+                unsigned char table[256];
+                for (int c = 0; c < 256; ++c)
+                    table[c] = Pred::test(static_cast<Ch>(c));
+                return from_table(table);
+            }
+
+            // Build set stopping exactly where lookup table yields 0
+            static simd_charset from_table(const unsigned char *table)
+            {
+                simd_charset set;
+                set.count = 0;
+                set.negate = table[0x80] == 0;
+                set.usable = true;
+                for (int i = 0; i < 16; ++i)
+                {
+                    set.lo[i] = 0;
+                    set.hi[i] = static_cast<unsigned char>(i < 8 ? 1 << i : 0);
+                }
+                for (int c = 0; c < 256; ++c)
+                {
+                    if ((table[c] == 0) == set.negate)
+                        continue;
+                    if (c >= 0x80 || set.count == 16)       // Members must be a few ASCII characters
+                    {
+                        set.usable = false;
+                        break;
+                    }
+                    set.lo[c & 0xF] |= static_cast<unsigned char>(1 << (c >> 4));
+                    set.chars[set.count++] = static_cast<unsigned char>(c);
+                }
+                return set;
+            }
+        };
+
+        // Kernel scanning from a 16 byte aligned position, returns first stop position
+        typedef const char *(simd_scan_func)(const char *, const simd_charset &);
+
+        inline unsigned int simd_first_bit(unsigned int mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned int>(index);
+#else
+            return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+        }
+
+        // Compare each byte against all members
+        inline const char *simd_scan_sse2(const char *text, const simd_charset &set)
+        {
+            const unsigned int flip = set.negate ? 0xFFFFu : 0u;
+            for (const __m128i *block = reinterpret_cast<const __m128i *>(text); ; ++block)
+            {
+                __m128i data = _mm_load_si128(block);
+                __m128i member = _mm_setzero_si128();
+                for (int i = 0; i < set.count; ++i)
+                    member = _mm_or_si128(member, _mm_cmpeq_epi8(data, _mm_set1_epi8(static_cast<char>(set.chars[i]))));
+                unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(member)) ^ flip;
+                if (mask)
+                    return reinterpret_cast<const char *>(block) + simd_first_bit(mask);
+            }
+        }
+
+#ifndef RAPIDXML_NO_SSSE3
+
+        // Classify 16 bytes by nibble lookup, returns bit mask of non-members
+        RAPIDXML_TARGET("ssse3")
+        inline unsigned int simd_classify_ssse3(const __m128i *block, __m128i lo, __m128i hi)
+        {
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+            __m128i data = _mm_load_si128(block);
+            __m128i lo_bits = _mm_shuffle_epi8(lo, _mm_and_si128(data, nibble));
+            __m128i hi_bits = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(data, 4), nibble));
+            __m128i outside = _mm_cmpeq_epi8(_mm_and_si128(lo_bits, hi_bits), _mm_setzero_si128());
+            return static_cast<unsigned int>(_mm_movemask_epi8(outside));
+        }
+
+        RAPIDXML_TARGET("ssse3")
+        inline const char *simd_scan_ssse3(const char *text, const simd_charset &set)
+        {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.hi));
+            const unsigned int flip = set.negate ? 0u : 0xFFFFu;
+            for (const __m128i *block = reinterpret_cast<const __m128i *>(text); ; ++block)
+            {
+                unsigned int mask = simd_classify_ssse3(block, lo, hi) ^ flip;
+                if (mask)
+                    return reinterpret_cast<const char *>(block) + simd_first_bit(mask);
+            }
+        }
+
+#endif
+
+#ifndef RAPIDXML_NO_AVX2
+
+        RAPIDXML_TARGET("avx2")
+        inline const char *simd_scan_avx2(const char *text, const simd_charset &set)
+        {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.hi));
+
+            // Classify one 16 byte block to reach 32 byte alignment
+            if (reinterpret_cast<std::size_t>(text) & 31)
+            {
+                unsigned int mask = simd_classify_ssse3(reinterpret_cast<const __m128i *>(text), lo, hi) ^ (set.negate ? 0u : 0xFFFFu);
+                if (mask)
+                    return text + simd_first_bit(mask);
+                text += 16;
+            }
+
+            const __m256i lo_wide = _mm256_broadcastsi128_si256(lo);
+            const __m256i hi_wide = _mm256_broadcastsi128_si256(hi);
+            const __m256i nibble = _mm256_set1_epi8(0x0F);
+            const unsigned int flip = set.negate ? 0u : 0xFFFFFFFFu;
+            for (const __m256i *block = reinterpret_cast<const __m256i *>(text); ; ++block)
+            {
+                __m256i data = _mm256_load_si256(block);
+                __m256i lo_bits = _mm256_shuffle_epi8(lo_wide, _mm256_and_si256(data, nibble));
+                __m256i hi_bits = _mm256_shuffle_epi8(hi_wide, _mm256_and_si256(_mm256_srli_epi16(data, 4), nibble));
+                __m256i outside = _mm256_cmpeq_epi8(_mm256_and_si256(lo_bits, hi_bits), _mm256_setzero_si256());
+                unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(outside)) ^ flip;
+                if (mask)
+                    return reinterpret_cast<const char *>(block) + simd_first_bit(mask);
+            }
+        }
+
+#endif
+
+        // Kernel finding first stop position in [text, end), returns end if there is none.
+        // Used where the text has no terminating zero; whole aligned blocks around the range are read,
+        // which never cross a page boundary.
+        typedef const char *(simd_find_func)(const char *, const char *, const simd_charset &);
+
+        inline const char *simd_found(const char *block, unsigned int mask, const char *end)
+        {
+            const char *found = block + simd_first_bit(mask);
+            return found < end ? found : end;
+        }
+
+        inline unsigned int simd_members_sse2(const __m128i *block, const simd_charset &set)
+        {
+            __m128i data = _mm_load_si128(block);
+            __m128i member = _mm_setzero_si128();
+            for (int i = 0; i < set.count; ++i)
+                member = _mm_or_si128(member, _mm_cmpeq_epi8(data, _mm_set1_epi8(static_cast<char>(set.chars[i]))));
+            return static_cast<unsigned int>(_mm_movemask_epi8(member));
+        }
+
+        inline const char *simd_find_sse2(const char *text, const char *end, const simd_charset &set)
+        {
+            if (text >= end)
+                return end;
+            const unsigned int flip = set.negate ? 0xFFFFu : 0u;
+            const std::size_t offset = reinterpret_cast<std::size_t>(text) & 15;
+            const __m128i *block = reinterpret_cast<const __m128i *>(text - offset);
+            unsigned int mask = (simd_members_sse2(block, set) ^ flip) & (0xFFFFu << offset);
+            while (!mask)
+            {
+                if (reinterpret_cast<const char *>(++block) >= end)
+                    return end;
+                mask = simd_members_sse2(block, set) ^ flip;
+            }
+            return simd_found(reinterpret_cast<const char *>(block), mask, end);
+        }
+
+#ifndef RAPIDXML_NO_SSSE3
+
+        RAPIDXML_TARGET("ssse3")
+        inline const char *simd_find_ssse3(const char *text, const char *end, const simd_charset &set)
+        {
+            if (text >= end)
+                return end;
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.hi));
+            const unsigned int flip = set.negate ? 0u : 0xFFFFu;
+            const std::size_t offset = reinterpret_cast<std::size_t>(text) & 15;
+            const __m128i *block = reinterpret_cast<const __m128i *>(text - offset);
+            unsigned int mask = (simd_classify_ssse3(block, lo, hi) ^ flip) & (0xFFFFu << offset);
+            while (!mask)
+            {
+                if (reinterpret_cast<const char *>(++block) >= end)
+                    return end;
+                mask = simd_classify_ssse3(block, lo, hi) ^ flip;
+            }
+            return simd_found(reinterpret_cast<const char *>(block), mask, end);
+        }
+
+#endif
+
+#ifndef RAPIDXML_NO_AVX2
+
+        RAPIDXML_TARGET("avx2")
+        inline unsigned int simd_classify_avx2(const __m256i *block, __m256i lo, __m256i hi)
+        {
+            const __m256i nibble = _mm256_set1_epi8(0x0F);
+            __m256i data = _mm256_load_si256(block);
+            __m256i lo_bits = _mm256_shuffle_epi8(lo, _mm256_and_si256(data, nibble));
+            __m256i hi_bits = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(data, 4), nibble));
+            __m256i outside = _mm256_cmpeq_epi8(_mm256_and_si256(lo_bits, hi_bits), _mm256_setzero_si256());
+            return static_cast<unsigned int>(_mm256_movemask_epi8(outside));
+        }
+
+        RAPIDXML_TARGET("avx2")
+        inline const char *simd_find_avx2(const char *text, const char *end, const simd_charset &set)
+        {
+            if (text >= end)
+                return end;
+            const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo)));
+            const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(set.hi)));
+            const unsigned int flip = set.negate ? 0u : 0xFFFFFFFFu;
+            const std::size_t offset = reinterpret_cast<std::size_t>(text) & 31;
+            const __m256i *block = reinterpret_cast<const __m256i *>(text - offset);
+            unsigned int mask = (simd_classify_avx2(block, lo, hi) ^ flip) & (0xFFFFFFFFu << offset);
+            while (!mask)
+            {
+                if (reinterpret_cast<const char *>(++block) >= end)
+                    return end;
+                mask = simd_classify_avx2(block, lo, hi) ^ flip;
+            }
+            return simd_found(reinterpret_cast<const char *>(block), mask, end);
+        }
+
+#endif
+
+        // Check if executing cpu supports given kernel
+        inline bool simd_supported(simd_level level)
+        {
+            switch (level)
+            {
+            case simd_sse2:
+                return true;
+#ifndef RAPIDXML_NO_SSSE3
+            case simd_ssse3:
+  #if defined(__GNUC__) || defined(__clang__)
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("ssse3") != 0;
+  #elif defined(_MSC_VER)
+                {
+                    int info[4];
+                    __cpuid(info, 1);
+                    return (info[2] & (1 << 9)) != 0;
+                }
+  #endif
+#endif
+#ifndef RAPIDXML_NO_AVX2
+            case simd_avx2:
+  #if defined(__GNUC__) || defined(__clang__)
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") != 0;
+  #elif defined(_MSC_VER)
+                {
+                    int info[4];
+                    __cpuid(info, 1);
+                    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)   // OSXSAVE and AVX
+                        return false;
+                    if ((_xgetbv(0) & 6) != 6)                                      // OS saves YMM registers
+                        return false;
+                    __cpuidex(info, 7, 0);
+                    return (info[1] & (1 << 5)) != 0;
+                }
+  #endif
+#endif
+            default:
+                return false;
+            }
+        }
+
+        inline simd_scan_func *simd_kernel(simd_level level)
+        {
+            switch (level)
+            {
+#ifndef RAPIDXML_NO_AVX2
+            case simd_avx2: return &simd_scan_avx2;
+#endif
+#ifndef RAPIDXML_NO_SSSE3
+            case simd_ssse3: return &simd_scan_ssse3;
+#endif
+            default: return &simd_scan_sse2;
+            }
+        }
+
+        inline simd_find_func *simd_find_kernel(simd_level level)
+        {
+            switch (level)
+            {
+#ifndef RAPIDXML_NO_AVX2
+            case simd_avx2: return &simd_find_avx2;
+#endif
+#ifndef RAPIDXML_NO_SSSE3
+            case simd_ssse3: return &simd_find_ssse3;
+#endif
+            default: return &simd_find_sse2;
+            }
+        }
+
+        inline simd_level simd_detect()
+        {
+            if (simd_supported(simd_avx2))
+                return simd_avx2;
+            if (simd_supported(simd_ssse3))
+                return simd_ssse3;
+            return simd_sse2;
+        }
+
+        // Kernel used by the parser, selected on first use
+        inline simd_scan_func *&simd_scanner()
+        {
+            static simd_scan_func *scanner = simd_kernel(simd_detect());
+            return scanner;
+        }
+
+        // Bounded kernel used by the printer, selected on first use
+        inline simd_find_func *&simd_finder()
+        {
+            static simd_find_func *finder = simd_find_kernel(simd_detect());
+            return finder;
+        }
+
+        // Force a kernel, falls back to the best supported one below it.
+        // Not synchronized with running parsers; meant for testing and benchmarking.
+        inline simd_level simd_select(simd_level level)
+        {
+            while (level != simd_sse2 && !simd_supported(level))
+                level = static_cast<simd_level>(level - 1);
+            simd_scanner() = simd_kernel(level);
+            simd_finder() = simd_find_kernel(level);
+            return level;
+        }
+
+#endif
+
+    }
+    //! \endcond
+
+    ///////////////////////////////////////////////////////////////////////
+    // Memory pool configuration
+
+    //! Interface of upstream arenas supplying the dynamic blocks of a memory_pool.
+    //! Arenas shared by documents used on several threads (e.g. by rxml::parallel_document) must be thread-safe.
+    class memory_arena
+    {
+
+    public:
+
+        //! Allocates a block of memory.
+        //! Like user-defined allocation functions, this must not return 0 but throw or stop the program on failure.
+        //! \param size Size of block, in bytes.
+        //! \return Pointer to block.
+        virtual void *allocate(std::size_t size) = 0;
+
+        //! Frees a block returned by allocate().
+        //! \param memory Pointer to block.
+        //! \param size Size of block, as passed to allocate().
+        virtual void deallocate(void *memory, std::size_t size) = 0;
+
+    protected:
+
+        ~memory_arena()
+        {
+        }
+
+    };
+
+    //! Runtime configuration of the dynamic blocks of memory_pool, see memory_pool::configure().
+    //! The defaults reproduce the fixed block size of RAPIDXML_DYNAMIC_POOL_SIZE.
+    struct memory_pool_config
+    {
+        //! Constructs default configuration.
+        memory_pool_config()
+            : block_size(RAPIDXML_DYNAMIC_POOL_SIZE)
+            , growth(1)
+            , max_block_size(0)
+            , huge_pages(false)
+            , arena(0)
+        {
+        }
+
+        std::size_t block_size;         //!< Size of the first dynamic block, in bytes.
+        double growth;                  //!< Factor by which every further block grows; 1 keeps all blocks at block_size.
+        std::size_t max_block_size;     //!< Size at which growth stops, in bytes, or 0 for no limit.
+        bool huge_pages;                //!< Back blocks by 2 MiB transparent huge pages, where supported; rounds block sizes up to 2 MiB.
+        memory_arena *arena;            //!< Arena supplying the blocks, or 0 to use the allocation functions of the pool.
+    };
+
+#ifdef RAPIDXML_PARSE_STATISTICS
+
+    ///////////////////////////////////////////////////////////////////////
+    // Parse statistics
+
+    //! Allocation counters of a memory_pool, see memory_pool::allocation_statistics().
+    //! Only available if RAPIDXML_PARSE_STATISTICS is defined.
+    struct pool_statistics
+    {
+        //! Constructs counters set to zero.
+        pool_statistics()
+        {
+            reset();
+        }
+
+        //! Sets all counters to zero.
+        void reset()
+        {
+            for (std::size_t i = 0; i < sizeof(nodes) / sizeof(nodes[0]); ++i)
+                nodes[i] = 0;
+            attributes = 0;
+            blocks = 0;
+            block_bytes = 0;
+            allocated_bytes = 0;
+            padding_bytes = 0;
+        }
+
+        std::size_t nodes[node_pi + 1];     //!< Nodes allocated, indexed by node_type.
+        std::size_t attributes;             //!< Attributes allocated.
+        std::size_t blocks;                 //!< Dynamic blocks taken into use, including blocks reused after memory_pool::rewind().
+        std::size_t block_bytes;            //!< Size of these blocks, in bytes.
+        std::size_t allocated_bytes;        //!< Bytes handed out for nodes, attributes and strings.
+        std::size_t padding_bytes;          //!< Bytes skipped to align allocations to RAPIDXML_ALIGNMENT.
+    };
+
+    //! Statistics of a single call to xml_document::parse(), see xml_document::collect_statistics().
+    //! Only available if RAPIDXML_PARSE_STATISTICS is defined.
+    //! If parse() throws, the statistics describe the part of the text parsed before the error.
+    struct parse_statistics
+    {
+        //! Constructs statistics set to zero.
+        parse_statistics()
+        {
+            reset();
+        }
+
+        //! Sets all statistics to zero.
+        void reset()
+        {
+            bytes_scanned = 0;
+            entity_expansions = 0;
+            max_depth = 0;
+            pool.reset();
+            total_ns = 0;
+            attribute_ns = 0;
+            data_ns = 0;
+        }
+
+        //! Calls a visitor with name and value of every statistic, e.g. to export them to a metrics system.
+        //! Names are lower case and dot separated, e.g. <code>nodes.element</code> or <code>time.attribute_ns</code>.
+        //! \param visitor Function object callable as <code>visitor(const char *name, unsigned long long value)</code>.
+        template<class Visitor>
+        void visit(Visitor visitor) const
+        {
+            static const char *const node_names[] =
+            {
+                "nodes.document", "nodes.element", "nodes.data", "nodes.cdata",
+                "nodes.comment", "nodes.declaration", "nodes.doctype", "nodes.pi"
+            };
+            visitor("bytes_scanned", static_cast<unsigned long long>(bytes_scanned));
+            for (std::size_t i = 0; i < sizeof(node_names) / sizeof(node_names[0]); ++i)
+                visitor(node_names[i], static_cast<unsigned long long>(pool.nodes[i]));
+            visitor("attributes", static_cast<unsigned long long>(pool.attributes));
+            visitor("entity_expansions", static_cast<unsigned long long>(entity_expansions));
+            visitor("max_depth", static_cast<unsigned long long>(max_depth));
+            visitor("pool.blocks", static_cast<unsigned long long>(pool.blocks));
+            visitor("pool.block_bytes", static_cast<unsigned long long>(pool.block_bytes));
+            visitor("pool.allocated_bytes", static_cast<unsigned long long>(pool.allocated_bytes));
+            visitor("pool.padding_bytes", static_cast<unsigned long long>(pool.padding_bytes));
+            visitor("time.total_ns", total_ns);
+            visitor("time.attribute_ns", attribute_ns);
+            visitor("time.data_ns", data_ns);
+        }
+
+        std::size_t bytes_scanned;          //!< Size of the parsed text up to its terminating zero, in bytes.
+        std::size_t entity_expansions;      //!< Character and entity references replaced in data and attribute values.
+        std::size_t max_depth;              //!< Deepest nesting of elements; 1 if the root element has no child elements.
+        pool_statistics pool;               //!< Nodes, attributes and memory allocated by the parse.
+        unsigned long long total_ns;        //!< Time spent in parse(), in nanoseconds.
+        unsigned long long attribute_ns;    //!< Part of total_ns spent parsing attributes, including their entity translation.
+        unsigned long long data_ns;         //!< Part of total_ns spent parsing data, including its entity translation and whitespace normalization.
+    };
+
+    //! \cond internal
+    namespace internal
+    {
+
+        // Adds the lifetime of the timer to a nanosecond counter, unless the counter is 0
+        class phase_timer
+        {
+        public:
+            explicit phase_timer(unsigned long long *counter)
+                : m_counter(counter)
+            {
+                if (m_counter)
+                    m_start = std::chrono::steady_clock::now();
+            }
+
+            ~phase_timer()
+            {
+                if (m_counter)
+                    *m_counter += static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+            }
+
+        private:
+            phase_timer(const phase_timer &);
+            phase_timer &operator =(const phase_timer &);
+
+            unsigned long long *m_counter;
+            std::chrono::steady_clock::time_point m_start;
+        };
+
     }
     //! \endcond
 
+#endif
+
     ///////////////////////////////////////////////////////////////////////
     // Memory pool
     
@@ -374,6 +965,11 @@ namespace rapidxml
     //! If required, you can tweak <code>RAPIDXML_STATIC_POOL_SIZE</code>, <code>RAPIDXML_DYNAMIC_POOL_SIZE</code> and <code>RAPIDXML_ALIGNMENT</code> 
     //! to obtain best wasted memory to performance compromise.
     //! To do it, define their values before rapidxml.hpp file is included.
+    //! <code>RAPIDXML_STATIC_POOL_SIZE</code> may be 0 to keep documents small and allocate all memory dynamically.
+    //! <br><br>
+    //! Size, growth and backing of the dynamic blocks can also be set at runtime by configure().
+    //! For large documents, geometrically growing blocks need few allocations, 
+    //! and blocks backed by huge pages cause fewer TLB misses when the tree is walked.
     //! \param Ch Character type of created nodes. 
     template<class Ch = char>
     class memory_pool
@@ -390,6 +986,7 @@ namespace rapidxml
         memory_pool()
             : m_alloc_func(0)
             , m_free_func(0)
+            , m_retained(0)
         {
             init();
         }
@@ -418,6 +1015,9 @@ namespace rapidxml
         {
             void *memory = allocate_aligned(sizeof(xml_node<Ch>));
             xml_node<Ch> *node = new(memory) xml_node<Ch>(type);
+#ifdef RAPIDXML_PARSE_STATISTICS
+            ++m_statistics.nodes[type];
+#endif
             if (name)
             {
                 if (name_size > 0)
@@ -449,6 +1049,9 @@ namespace rapidxml
         {
             void *memory = allocate_aligned(sizeof(xml_attribute<Ch>));
             xml_attribute<Ch> *attribute = new(memory) xml_attribute<Ch>;
+#ifdef RAPIDXML_PARSE_STATISTICS
+            ++m_statistics.attributes;
+#endif
             if (name)
             {
                 if (name_size > 0)
@@ -526,16 +1129,70 @@ namespace rapidxml
         {
             while (m_begin != m_static_memory)
             {
-                char *previous_begin = reinterpret_cast<header *>(align(m_begin))->previous_begin;
-                if (m_free_func)
-                    m_free_func(m_begin);
-                else
-                    delete[] m_begin;
+                header *block = reinterpret_cast<header *>(align(m_begin));
+                char *previous_begin = block->previous_begin;
+                free_raw(m_begin, block->size, block->source);
+                m_begin = previous_begin;
+            }
+            free_retained(m_retained);
+            m_retained = 0;
+            init();
+        }
+
+        //! Rewinds the pool to its beginning, keeping dynamic blocks for reuse instead of freeing them.
+        //! Like clear(), this invalidates all nodes and strings allocated from the pool.
+        //! Subsequent allocations fill the static memory and the kept blocks in their original order
+        //! before any new block is allocated, so a pool used for similar documents stops allocating.
+        //! \param max_retained Maximum total size of kept blocks, in bytes; blocks beyond are freed.
+        void rewind(std::size_t max_retained = ~std::size_t(0))
+        {
+            // Put used blocks in front of blocks kept before, oldest first
+            while (m_begin != m_static_memory)
+            {
+                header *block = reinterpret_cast<header *>(align(m_begin));
+                char *previous_begin = block->previous_begin;
+                block->previous_begin = m_retained;
+                m_retained = m_begin;
                 m_begin = previous_begin;
             }
+
+            // Free blocks exceeding the limit
+            std::size_t retained = 0;
+            for (char **link = &m_retained; *link; )
+            {
+                header *block = reinterpret_cast<header *>(align(*link));
+                if (retained + block->size > max_retained)
+                {
+                    free_retained(*link);
+                    *link = 0;
+                    break;
+                }
+                retained += block->size;
+                link = &block->previous_begin;
+            }
             init();
         }
 
+        //! Gets the total size of dynamic blocks held by the pool, whether in use or kept by rewind().
+        //! \return Size in bytes.
+        std::size_t capacity() const
+        {
+            std::size_t size = 0;
+            for (char *begin = m_begin; begin != m_static_memory; )
+            {
+                const header *block = reinterpret_cast<const header *>(align(begin));
+                size += block->size;
+                begin = block->previous_begin;
+            }
+            for (char *begin = m_retained; begin; )
+            {
+                const header *block = reinterpret_cast<const header *>(align(begin));
+                size += block->size;
+                begin = block->previous_begin;
+            }
+            return size;
+        }
+
         //! Sets or resets the user-defined memory allocation functions for the pool.
         //! This can only be called when no memory is allocated from the pool yet, otherwise results are undefined.
         //! Allocation function must not return invalid pointer on failure. It should either throw,
@@ -551,42 +1208,104 @@ namespace rapidxml
         //! \param ff Free function, or 0 to restore default function
         void set_allocator(alloc_func *af, free_func *ff)
         {
-            assert(m_begin == m_static_memory && m_ptr == align(m_begin));    // Verify that no memory is allocated yet
+            assert(m_begin == m_static_memory && m_ptr == align(m_begin) && !m_retained);    // Verify that no memory is allocated yet
             m_alloc_func = af;
             m_free_func = ff;
         }
 
+        //! Sets the runtime configuration of dynamic blocks.
+        //! This can only be called when no memory is allocated from the pool yet, otherwise results are undefined.
+        //! An arena in the configuration takes precedence over allocation functions set by set_allocator().
+        //! \param config Configuration to use; the arena, if any, must outlive the memory allocated from it.
+        void configure(const memory_pool_config &config)
+        {
+            assert(m_begin == m_static_memory && m_ptr == align(m_begin) && !m_retained);    // Verify that no memory is allocated yet
+            assert(config.block_size > 0 && config.growth >= 1);
+            m_config = config;
+            m_next_block_size = config.block_size;
+        }
+
+        //! Gets the runtime configuration of dynamic blocks.
+        //! \return Configuration set by configure(), or default configuration.
+        const memory_pool_config &config() const
+        {
+            return m_config;
+        }
+
+#ifdef RAPIDXML_PARSE_STATISTICS
+        //! Gets the allocation counters of the pool.
+        //! Counters are cumulative over the lifetime of the pool; they are not reset by clear() or rewind().
+        //! Only available if RAPIDXML_PARSE_STATISTICS is defined.
+        //! \return Counters of all allocations so far.
+        const pool_statistics &allocation_statistics() const
+        {
+            return m_statistics;
+        }
+#endif
+
     private:
 
+        // Source of a dynamic block, determining how it is freed
+        enum block_source
+        {
+            block_new,
+            block_alloc_func,
+            block_arena,
+            block_huge_pages
+        };
+
         struct header
         {
             char *previous_begin;
+            std::size_t size;
+            block_source source;
         };
 
         void init()
         {
             m_begin = m_static_memory;
             m_ptr = align(m_begin);
-            m_end = m_static_memory + sizeof(m_static_memory);
+            m_end = m_static_memory + RAPIDXML_STATIC_POOL_SIZE;
+            m_next_block_size = m_config.block_size;
         }
         
-        char *align(char *ptr)
+        static char *align(char *ptr)
         {
             std::size_t alignment = ((RAPIDXML_ALIGNMENT - (std::size_t(ptr) & (RAPIDXML_ALIGNMENT - 1))) & (RAPIDXML_ALIGNMENT - 1));
             return ptr + alignment;
         }
         
-        char *allocate_raw(std::size_t size)
+        // Allocates a dynamic block; size may be rounded up
+        char *allocate_raw(std::size_t &size, block_source &source)
         {
             // Allocate
             void *memory;   
-            if (m_alloc_func)   // Allocate memory using either user-specified allocation function or global operator new[]
+            if (m_config.arena)     // Allocate memory using the arena, user-specified allocation function, huge pages or global operator new[]
             {
+                source = block_arena;
+                memory = m_config.arena->allocate(size);
+                assert(memory); // Arena is not allowed to return 0, on failure it must either throw, stop the program or use longjmp
+            }
+            else if (m_alloc_func)
+            {
+                source = block_alloc_func;
                 memory = m_alloc_func(size);
                 assert(memory); // Allocator is not allowed to return 0, on failure it must either throw, stop the program or use longjmp
             }
             else
             {
+#ifdef RAPIDXML_HUGE_PAGES
+                if (m_config.huge_pages)
+                {
+                    char *huge = allocate_huge_pages(size);
+                    if (huge)
+                    {
+                        source = block_huge_pages;
+                        return huge;
+                    }
+                }
+#endif
+                source = block_new;
                 memory = new char[size];
 #ifdef RAPIDXML_NO_EXCEPTIONS
                 if (!memory)            // If exceptions are disabled, verify memory allocation, because new will not be able to throw bad_alloc
@@ -595,6 +1314,66 @@ namespace rapidxml
             }
             return static_cast<char *>(memory);
         }
+
+        // Frees a list of blocks kept by rewind()
+        void free_retained(char *begin)
+        {
+            while (begin)
+            {
+                header *block = reinterpret_cast<header *>(align(begin));
+                char *next = block->previous_begin;
+                free_raw(begin, block->size, block->source);
+                begin = next;
+            }
+        }
+
+        void free_raw(char *memory, std::size_t size, block_source source)
+        {
+            switch (source)
+            {
+            case block_arena:
+                m_config.arena->deallocate(memory, size);
+                break;
+            case block_alloc_func:
+                m_free_func(memory);
+                break;
+#ifdef RAPIDXML_HUGE_PAGES
+            case block_huge_pages:
+                munmap(memory, size);
+                break;
+#endif
+            default:
+                delete[] memory;
+            }
+        }
+
+#ifdef RAPIDXML_HUGE_PAGES
+        // Maps a block aligned to and rounded up to 2 MiB, so the kernel can back it by huge pages; returns 0 on failure
+        static char *allocate_huge_pages(std::size_t &size)
+        {
+            const std::size_t huge_page_size = 2 * 1024 * 1024;
+            const std::size_t rounded = (size + huge_page_size - 1) & ~(huge_page_size - 1);
+            const std::size_t mapped = rounded + huge_page_size;
+
+            void *memory = mmap(0, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED)
+                return 0;
+
+            // Cut off the unaligned head and the tail
+            char *begin = static_cast<char *>(memory);
+            char *aligned = reinterpret_cast<char *>((std::size_t(begin) + huge_page_size - 1) & ~(huge_page_size - 1));
+            if (aligned != begin)
+                munmap(begin, aligned - begin);
+            if (aligned + rounded != begin + mapped)
+                munmap(aligned + rounded, begin + mapped - (aligned + rounded));
+
+#ifdef MADV_HUGEPAGE
+            madvise(aligned, rounded, MADV_HUGEPAGE);
+#endif
+            size = rounded;
+            return aligned;
+        }
+#endif
         
         void *allocate_aligned(std::size_t size)
         {
@@ -604,28 +1383,60 @@ namespace rapidxml
             // If not enough memory left in current pool, allocate a new pool
             if (result + size > m_end)
             {
-                // Calculate required pool size (may be bigger than RAPIDXML_DYNAMIC_POOL_SIZE)
-                std::size_t pool_size = RAPIDXML_DYNAMIC_POOL_SIZE;
+                // Calculate required pool size (may be bigger than the configured block size)
+                std::size_t pool_size = m_next_block_size;
                 if (pool_size < size)
                     pool_size = size;
                 
                 // Allocate
                 std::size_t alloc_size = sizeof(header) + (2 * RAPIDXML_ALIGNMENT - 2) + pool_size;     // 2 alignments required in worst case: one for header, one for actual allocation
-                char *raw_memory = allocate_raw(alloc_size);
+                block_source source;
+                char *raw_memory;
+                header *retained = m_retained ? reinterpret_cast<header *>(align(m_retained)) : 0;
+                if (retained && retained->size >= alloc_size)
+                {
+                    // Reuse block kept by rewind()
+                    raw_memory = m_retained;
+                    m_retained = retained->previous_begin;
+                    alloc_size = retained->size;
+                    source = retained->source;
+                }
+                else
+                    raw_memory = allocate_raw(alloc_size, source);
                     
                 // Setup new pool in allocated memory
                 char *pool = align(raw_memory);
                 header *new_header = reinterpret_cast<header *>(pool);
                 new_header->previous_begin = m_begin;
+                new_header->size = alloc_size;
+                new_header->source = source;
                 m_begin = raw_memory;
                 m_ptr = pool + sizeof(header);
                 m_end = raw_memory + alloc_size;
+#ifdef RAPIDXML_PARSE_STATISTICS
+                ++m_statistics.blocks;
+                m_statistics.block_bytes += alloc_size;
+#endif
 
                 // Calculate aligned pointer again using new pool
                 result = align(m_ptr);
+
+                // Grow next block
+                if (m_config.growth > 1)
+                {
+                    std::size_t next_size = static_cast<std::size_t>(m_next_block_size * m_config.growth);
+                    if (m_config.max_block_size && next_size > m_config.max_block_size)
+                        next_size = m_config.max_block_size;
+                    if (next_size > m_next_block_size)
+                        m_next_block_size = next_size;
+                }
             }
 
             // Update pool and return aligned pointer
+#ifdef RAPIDXML_PARSE_STATISTICS
+            m_statistics.allocated_bytes += size;
+            m_statistics.padding_bytes += result - m_ptr;
+#endif
             m_ptr = result + size;
             return result;
         }
@@ -633,9 +1444,15 @@ namespace rapidxml
         char *m_begin;                                      // Start of raw memory making up current pool
         char *m_ptr;                                        // First free byte in current pool
         char *m_end;                                        // One past last available byte in current pool
-        char m_static_memory[RAPIDXML_STATIC_POOL_SIZE];    // Static raw memory
+        char m_static_memory[RAPIDXML_STATIC_POOL_SIZE > 0 ? RAPIDXML_STATIC_POOL_SIZE : 1];    // Static raw memory
         alloc_func *m_alloc_func;                           // Allocator function, or 0 if default is to be used
         free_func *m_free_func;                             // Free function, or 0 if default is to be used
+        memory_pool_config m_config;                        // Runtime configuration of dynamic blocks
+        std::size_t m_next_block_size;                      // Size of the next dynamic block
+        char *m_retained;                                   // First of the blocks kept by rewind() for reuse, or 0 if none
+#ifdef RAPIDXML_PARSE_STATISTICS
+        pool_statistics m_statistics;                       // Cumulative allocation counters
+#endif
     };
 
     ///////////////////////////////////////////////////////////////////////////
@@ -875,6 +1692,31 @@ namespace rapidxml
     
     };
 
+    ///////////////////////////////////////////////////////////////////////////
+    // XML node loader
+
+    //! Interface of objects parsing the children of a node on first access.
+    //! A node with a loader calls it from every function reading or changing its children or its value,
+    //! so the loader must tolerate concurrent and recursive calls (see rxml::lazy_document).
+    //! \param Ch Character type to use.
+    template<class Ch = char>
+    class xml_node_loader
+    {
+
+    public:
+
+        //! Parses children and value of node, unless this was already done.
+        //! \param node Node the loader is attached to.
+        virtual void load(xml_node<Ch> *node) = 0;
+
+    protected:
+
+        ~xml_node_loader()
+        {
+        }
+
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     // XML node
 
@@ -900,8 +1742,10 @@ namespace rapidxml
         //! \param type Type of node to construct.
         xml_node(node_type type)
             : m_type(type)
+            , m_namespace(0)
             , m_first_node(0)
             , m_first_attribute(0)
+            , m_loader(0)
         {
         }
 
@@ -915,6 +1759,38 @@ namespace rapidxml
             return m_type;
         }
 
+        //! Gets namespace of element, as resolved by parsing with rapidxml::parse_namespaces.
+        //! \return Id of namespace URI in the table of the document (see xml_document::namespace_uri()), or 0 if element has no namespace.
+        unsigned namespace_id() const
+        {
+            return m_namespace;
+        }
+
+        using xml_base<Ch>::value;
+
+        //! Gets value of node, loading the children of the node first if it has a loader.
+        //! \return Value of node, or empty string if node has no value.
+        Ch *value() const
+        {
+            load();
+            return xml_base<Ch>::value();
+        }
+
+        //! Gets size of node value, loading the children of the node first if it has a loader.
+        //! \return Size of node value, in characters.
+        std::size_t value_size() const
+        {
+            load();
+            return xml_base<Ch>::value_size();
+        }
+
+        //! Gets loader parsing the children of the node on first access.
+        //! \return Pointer to loader, or 0 if the node is complete.
+        xml_node_loader<Ch> *loader() const
+        {
+            return m_loader;
+        }
+
         ///////////////////////////////////////////////////////////////////////////
         // Related nodes access
     
@@ -935,6 +1811,7 @@ namespace rapidxml
         //! \return Pointer to found child, or 0 if not found.
         xml_node<Ch> *first_node(const Ch *name = 0, std::size_t name_size = 0, bool case_sensitive = true) const
         {
+            load();
             if (name)
             {
                 if (name_size == 0)
@@ -957,6 +1834,7 @@ namespace rapidxml
         //! \return Pointer to found child, or 0 if not found.
         xml_node<Ch> *last_node(const Ch *name = 0, std::size_t name_size = 0, bool case_sensitive = true) const
         {
+            load();
             assert(m_first_node);  // Cannot query for last child if node has no children
             if (name)
             {
@@ -1060,6 +1938,13 @@ namespace rapidxml
         ///////////////////////////////////////////////////////////////////////////
         // Node modification
     
+        //! Sets namespace of element.
+        //! \param id Id of namespace URI in the table of the document, or 0 for no namespace.
+        void namespace_id(unsigned id)
+        {
+            m_namespace = id;
+        }
+
         //! Sets type of node.
         //! \param type Type of node to set.
         void type(node_type type)
@@ -1067,6 +1952,14 @@ namespace rapidxml
             m_type = type;
         }
 
+        //! Sets loader parsing the children of the node on first access.
+        //! The loader must stay valid as long as the node is used.
+        //! \param loader Loader to set, or 0 if the node is complete.
+        void loader(xml_node_loader<Ch> *loader)
+        {
+            m_loader = loader;
+        }
+
         ///////////////////////////////////////////////////////////////////////////
         // Node manipulation
 
@@ -1120,6 +2013,7 @@ namespace rapidxml
         {
             assert(!where || where->parent() == this);
             assert(child && !child->parent() && child->type() != node_document);
+            load();
             if (where == m_first_node)
                 prepend_node(child);
             else if (where == 0)
@@ -1139,6 +2033,7 @@ namespace rapidxml
         //! Use first_node() to test if node has children.
         void remove_first_node()
         {
+            load();
             assert(first_node());
             xml_node<Ch> *child = m_first_node;
             m_first_node = child->m_next_sibling;
@@ -1154,6 +2049,7 @@ namespace rapidxml
         //! Use first_node() to test if node has children.
         void remove_last_node()
         {
+            load();
             assert(first_node());
             xml_node<Ch> *child = m_last_node;
             if (child->m_prev_sibling)
@@ -1171,6 +2067,7 @@ namespace rapidxml
         void remove_node(xml_node<Ch> *where)
         {
             assert(where && where->parent() == this);
+            load();
             assert(first_node());
             if (where == m_first_node)
                 remove_first_node();
@@ -1321,6 +2218,13 @@ namespace rapidxml
         // No copying
         xml_node(const xml_node &);
         void operator =(const xml_node &);
+
+        // Let the loader complete the node, if any
+        void load() const
+        {
+            if (m_loader)
+                m_loader->load(const_cast<xml_node<Ch> *>(this));
+        }
     
         ///////////////////////////////////////////////////////////////////////////
         // Data members
@@ -1335,12 +2239,14 @@ namespace rapidxml
         // 3. prev_sibling and next_sibling are valid only if node has a parent, otherwise they contain garbage
 
         node_type m_type;                       // Type of node; always valid
+        unsigned m_namespace;                   // Id of namespace URI, or 0 if none; fills the padding after m_type
         xml_node<Ch> *m_first_node;             // Pointer to first child node, or 0 if none; always valid
         xml_node<Ch> *m_last_node;              // Pointer to last child node, or 0 if none; this value is only valid if m_first_node is non-zero
         xml_attribute<Ch> *m_first_attribute;   // Pointer to first attribute of node, or 0 if none; always valid
         xml_attribute<Ch> *m_last_attribute;    // Pointer to last attribute of node, or 0 if none; this value is only valid if m_first_attribute is non-zero
         xml_node<Ch> *m_prev_sibling;           // Pointer to previous sibling of node, or 0 if none; this value is only valid if m_parent is non-zero
         xml_node<Ch> *m_next_sibling;           // Pointer to next sibling of node, or 0 if none; this value is only valid if m_parent is non-zero
+        xml_node_loader<Ch> *m_loader;          // Pointer to loader parsing children on first access, or 0 if none; always valid
 
     };
 
@@ -1363,9 +2269,82 @@ namespace rapidxml
         //! Constructs empty XML document
         xml_document()
             : xml_node<Ch>(node_document)
+            , m_parse_flags(0)
+            , m_namespaces(0)
+            , m_namespace_count(0)
+            , m_namespace_capacity(0)
+            , m_namespace_scope(0)
+        {
+#ifdef RAPIDXML_PARSE_STATISTICS
+            m_collector = 0;
+            m_statistics = 0;
+            m_depth = 0;
+#endif
+        }
+
+        //! Gets flags used by the last call to parse().
+        //! Accessors use them to decide whether values still contain entity references,
+        //! e.g. after parsing with rapidxml::parse_non_destructive.
+        //! \return Parse flags, or 0 if document was not parsed.
+        int parse_flags() const
+        {
+            return m_parse_flags;
+        }
+
+        //! Gets number of namespace URIs found by the last call to parse() with rapidxml::parse_namespaces.
+        //! Ids of the URIs range from 1 to this number.
+        //! \return Number of distinct URIs declared in the document.
+        unsigned namespace_count() const
+        {
+            return m_namespace_count;
+        }
+
+        //! Gets namespace URI with given id.
+        //! The URI points into the parsed text; it is not zero-terminated if rapidxml::parse_no_string_terminators was used,
+        //! and still contains entity references if rapidxml::parse_no_entity_translation was used.
+        //! \param id Id of URI, from 1 to namespace_count().
+        //! \return Pointer to URI.
+        Ch *namespace_uri(unsigned id) const
+        {
+            assert(id > 0 && id <= m_namespace_count);
+            return m_namespaces[id - 1].uri;
+        }
+
+        //! Gets size of namespace URI with given id.
+        //! \param id Id of URI, from 1 to namespace_count().
+        //! \return Size of URI, in characters.
+        std::size_t namespace_uri_size(unsigned id) const
+        {
+            assert(id > 0 && id <= m_namespace_count);
+            return m_namespaces[id - 1].size;
+        }
+
+        //! Finds id of namespace URI.
+        //! \param uri URI to find; this string doesn't have to be zero-terminated if uri_size is non-zero.
+        //! \param uri_size Size of URI, in characters, or 0 to have size calculated automatically from string.
+        //! \return Id of URI, or 0 if no element of the document declared it.
+        unsigned find_namespace(const Ch *uri, std::size_t uri_size = 0) const
         {
+            if (uri_size == 0)
+                uri_size = internal::measure(uri);
+            for (unsigned id = 1; id <= m_namespace_count; ++id)
+                if (internal::compare(m_namespaces[id - 1].uri, m_namespaces[id - 1].size, uri, uri_size, true))
+                    return id;
+            return 0;
         }
 
+#ifdef RAPIDXML_PARSE_STATISTICS
+        //! Sets the collector filled in by every following call to parse().
+        //! Each call resets the collector first, so it always describes the last parse.
+        //! Nodes parsed later on first access, e.g. by rxml::lazy_document, are not included.
+        //! Only available if RAPIDXML_PARSE_STATISTICS is defined.
+        //! \param statistics Collector, or 0 to stop collecting; it must outlive the calls to parse().
+        void collect_statistics(parse_statistics *statistics)
+        {
+            m_collector = statistics;
+        }
+#endif
+
         //! Parses zero-terminated XML string according to given flags.
         //! Passed string will be modified by the parser, unless rapidxml::parse_non_destructive flag is used.
         //! The string must persist for the lifetime of the document.
@@ -1385,6 +2364,11 @@ namespace rapidxml
             // Remove current contents
             this->remove_all_nodes();
             this->remove_all_attributes();
+            m_parse_flags = Flags;
+            reset_namespaces();
+#ifdef RAPIDXML_PARSE_STATISTICS
+            statistics_scope statistics(*this, text);
+#endif
             
             // Parse BOM, if any
             parse_bom<Flags>(text);
@@ -1416,10 +2400,11 @@ namespace rapidxml
         {
             this->remove_all_nodes();
             this->remove_all_attributes();
+            reset_namespaces();
             memory_pool<Ch>::clear();
         }
         
-    private:
+    protected:
 
         ///////////////////////////////////////////////////////////////////////
         // Internal character utility functions
@@ -1558,6 +2543,26 @@ namespace rapidxml
         static void skip(Ch *&text)
         {
             Ch *tmp = text;
+#ifdef RAPIDXML_SIMD
+            if (sizeof(Ch) == 1)
+            {
+                // Use lookup table up to next 16 byte boundary, then classify whole aligned blocks.
+                // Aligned blocks never cross a page boundary and every predicate stops at the terminating zero,
+                // so no page past the end of the text is touched.
+                while (reinterpret_cast<std::size_t>(tmp) & 15)
+                {
+                    if (!StopPred::test(*tmp))
+                    {
+                        text = tmp;
+                        return;
+                    }
+                    ++tmp;
+                }
+                static const internal::simd_charset charset = internal::simd_charset::from_pred<StopPred, Ch>();
+                if (charset.usable)
+                    tmp = reinterpret_cast<Ch *>(const_cast<char *>(internal::simd_scanner()(reinterpret_cast<const char *>(tmp), charset)));
+            }
+#endif
             while (StopPred::test(*tmp))
                 ++tmp;
             text = tmp;
@@ -1567,12 +2572,12 @@ namespace rapidxml
         // - replacing XML character entity references with proper characters (&apos; &amp; &quot; &lt; &gt; &#...;)
         // - condensing whitespace sequences to single space character
         template<class StopPred, class StopPredPure, int Flags>
-        static Ch *skip_and_expand_character_refs(Ch *&text)
+        Ch *skip_and_expand_character_refs(Ch *&text)
         {
-            // If entity translation, whitespace condense and whitespace trimming is disabled, use plain skip
+            // If entity translation and whitespace condense is disabled, use plain skip.
+            // Trimming only moves the end of the value, so the text is never written to (required for read-only input).
             if (Flags & parse_no_entity_translation && 
-                !(Flags & parse_normalize_whitespace) &&
-                !(Flags & parse_trim_whitespace))
+                !(Flags & parse_normalize_whitespace))
             {
                 skip<StopPred, Flags>(text);
                 return text;
@@ -1601,6 +2606,7 @@ namespace rapidxml
                             {
                                 *dest = Ch('&');
                                 ++dest;
+                                count_entity_expansion();
                                 src += 5;
                                 continue;
                             }
@@ -1608,6 +2614,7 @@ namespace rapidxml
                             {
                                 *dest = Ch('\'');
                                 ++dest;
+                                count_entity_expansion();
                                 src += 6;
                                 continue;
                             }
@@ -1619,6 +2626,7 @@ namespace rapidxml
                             {
                                 *dest = Ch('"');
                                 ++dest;
+                                count_entity_expansion();
                                 src += 6;
                                 continue;
                             }
@@ -1630,6 +2638,7 @@ namespace rapidxml
                             {
                                 *dest = Ch('>');
                                 ++dest;
+                                count_entity_expansion();
                                 src += 4;
                                 continue;
                             }
@@ -1641,6 +2650,7 @@ namespace rapidxml
                             {
                                 *dest = Ch('<');
                                 ++dest;
+                                count_entity_expansion();
                                 src += 4;
                                 continue;
                             }
@@ -1680,6 +2690,7 @@ namespace rapidxml
                                 ++src;
                             else
                                 RAPIDXML_PARSE_ERROR("expected ;", src);
+                            count_entity_expansion();
                             continue;
 
                         // Something else
@@ -1717,6 +2728,168 @@ namespace rapidxml
 
         }
 
+#ifdef RAPIDXML_PARSE_STATISTICS
+        // Activates the collector, if any, for the duration of a parse() call and fills in its totals afterwards
+        class statistics_scope
+        {
+        public:
+            statistics_scope(xml_document &document, Ch *&text)
+                : m_document(document)
+                , m_text(text)
+                , m_begin(text)
+                , m_pool(document.allocation_statistics())
+                , m_timer(document.m_collector ? &document.m_collector->total_ns : 0)
+            {
+                m_document.m_statistics = m_document.m_collector;
+                m_document.m_depth = 0;
+                if (m_document.m_statistics)
+                    m_document.m_statistics->reset();
+            }
+
+            ~statistics_scope()
+            {
+                if (parse_statistics *statistics = m_document.m_statistics)
+                {
+                    const pool_statistics &pool = m_document.allocation_statistics();
+                    statistics->bytes_scanned = (m_text - m_begin) * sizeof(Ch);
+                    for (std::size_t i = 0; i < sizeof(pool.nodes) / sizeof(pool.nodes[0]); ++i)
+                        statistics->pool.nodes[i] = pool.nodes[i] - m_pool.nodes[i];
+                    statistics->pool.attributes = pool.attributes - m_pool.attributes;
+                    statistics->pool.blocks = pool.blocks - m_pool.blocks;
+                    statistics->pool.block_bytes = pool.block_bytes - m_pool.block_bytes;
+                    statistics->pool.allocated_bytes = pool.allocated_bytes - m_pool.allocated_bytes;
+                    statistics->pool.padding_bytes = pool.padding_bytes - m_pool.padding_bytes;
+                }
+                m_document.m_statistics = 0;
+            }
+
+        private:
+            statistics_scope(const statistics_scope &);
+            statistics_scope &operator =(const statistics_scope &);
+
+            xml_document &m_document;
+            Ch *&m_text;
+            Ch *m_begin;
+            pool_statistics m_pool;             // Counters of the pool before the parse
+            internal::phase_timer m_timer;
+        };
+#endif
+
+        // Namespace URI in the table of the document
+        struct namespace_entry
+        {
+            Ch *uri;
+            std::size_t size;
+        };
+
+        // Prefix declared by an element that is being parsed
+        struct namespace_binding
+        {
+            const Ch *prefix;
+            std::size_t prefix_size;
+            unsigned id;                        // 0 if the declaration removes the default namespace
+            namespace_binding *previous;        // Binding declared before, or 0
+        };
+
+        // Allocates uninitialized memory for records from the pool; strings are aligned like nodes
+        template<class T>
+        T *allocate_records(std::size_t count)
+        {
+            return reinterpret_cast<T *>(this->allocate_string(0, (count * sizeof(T) + sizeof(Ch) - 1) / sizeof(Ch)));
+        }
+
+        // Forgets URIs and bindings of the previous parse
+        void reset_namespaces()
+        {
+            m_namespaces = 0;
+            m_namespace_count = 0;
+            m_namespace_capacity = 0;
+            m_namespace_scope = 0;
+        }
+
+        // Returns id of URI, adding it to the table if necessary
+        unsigned intern_namespace(Ch *uri, std::size_t size)
+        {
+            if (unsigned id = find_namespace(uri, size))
+                return id;
+            if (m_namespace_count == m_namespace_capacity)
+            {
+                unsigned capacity = m_namespace_capacity ? 2 * m_namespace_capacity : 8;
+                namespace_entry *entries = allocate_records<namespace_entry>(capacity);
+                for (unsigned i = 0; i < m_namespace_count; ++i)
+                    entries[i] = m_namespaces[i];
+                m_namespaces = entries;
+                m_namespace_capacity = capacity;
+            }
+            m_namespaces[m_namespace_count].uri = uri;
+            m_namespaces[m_namespace_count].size = size;
+            return ++m_namespace_count;
+        }
+
+        // Puts the declarations of element in scope and sets the namespace of element
+        void resolve_namespace(xml_node<Ch> *element)
+        {
+            static const Ch xmlns[] = { Ch('x'), Ch('m'), Ch('l'), Ch('n'), Ch('s') };
+            static const char xml_uri[] = "http://www.w3.org/XML/1998/namespace";
+
+            // Bind xmlns and xmlns:prefix attributes
+            for (xml_attribute<Ch> *attribute = element->first_attribute(); attribute; attribute = attribute->next_attribute())
+            {
+                const Ch *name = attribute->name();
+                std::size_t size = attribute->name_size();
+                if (size < 5 || !internal::compare(name, 5, xmlns, 5, true) || (size > 5 && (name[5] != Ch(':') || size == 6)))
+                    continue;
+                namespace_binding *binding = allocate_records<namespace_binding>(1);
+                binding->prefix = size > 5 ? name + 6 : name + 5;
+                binding->prefix_size = size > 5 ? size - 6 : 0;
+                binding->id = attribute->value_size() ? intern_namespace(attribute->value(), attribute->value_size()) : 0;
+                binding->previous = m_namespace_scope;
+                m_namespace_scope = binding;
+            }
+
+            // Split prefix off the name
+            Ch *name = element->name();
+            std::size_t prefix_size = 0;
+            while (prefix_size < element->name_size() && name[prefix_size] != Ch(':'))
+                ++prefix_size;
+            const bool prefixed = prefix_size < element->name_size();
+            if (!prefixed)
+                prefix_size = 0;
+
+            // Innermost declaration wins
+            for (namespace_binding *binding = m_namespace_scope; binding; binding = binding->previous)
+            {
+                if (internal::compare(binding->prefix, binding->prefix_size, name, prefix_size, true))
+                {
+                    element->namespace_id(binding->id);
+                    return;
+                }
+            }
+            if (!prefixed)
+                return;
+
+            // The xml prefix is bound without declaration
+            if (prefix_size == 3 && name[0] == Ch('x') && name[1] == Ch('m') && name[2] == Ch('l'))
+            {
+                const std::size_t uri_size = sizeof(xml_uri) - 1;
+                Ch *uri = this->allocate_string(0, uri_size);
+                for (std::size_t i = 0; i < uri_size; ++i)
+                    uri[i] = Ch(xml_uri[i]);
+                element->namespace_id(intern_namespace(uri, uri_size));
+                return;
+            }
+            RAPIDXML_PARSE_ERROR("unbound namespace prefix", name);
+        }
+
+        // Counts an expanded character or entity reference
+        void count_entity_expansion()
+        {
+#ifdef RAPIDXML_PARSE_STATISTICS
+            if (m_statistics)
+                ++m_statistics->entity_expansions;
+#endif
+        }
+
         ///////////////////////////////////////////////////////////////////////
         // Internal parsing functions
         
@@ -1939,6 +3112,10 @@ namespace rapidxml
         template<int Flags>
         Ch parse_and_append_data(xml_node<Ch> *node, Ch *&text, Ch *contents_start)
         {
+#ifdef RAPIDXML_PARSE_STATISTICS
+            internal::phase_timer timer(m_statistics ? &m_statistics->data_ns : 0);
+#endif
+
             // Backup to contents start if whitespace trimming is disabled
             if (!(Flags & parse_trim_whitespace))
                 text = contents_start;     
@@ -2038,6 +3215,10 @@ namespace rapidxml
         {
             // Create element node
             xml_node<Ch> *element = this->allocate_node(node_element);
+#ifdef RAPIDXML_PARSE_STATISTICS
+            if (m_statistics && ++m_depth > m_statistics->max_depth)
+                m_statistics->max_depth = m_depth;
+#endif
 
             // Extract element name
             Ch *name = text;
@@ -2052,6 +3233,11 @@ namespace rapidxml
             // Parse attributes, if any
             parse_node_attributes<Flags>(text, element);
 
+            // Resolve namespace; declarations of the element stay in scope until its end
+            namespace_binding *scope = m_namespace_scope;
+            if (Flags & parse_namespaces)
+                resolve_namespace(element);
+
             // Determine ending type
             if (*text == Ch('>'))
             {
@@ -2071,6 +3257,12 @@ namespace rapidxml
             // Place zero terminator after name
             if (!(Flags & parse_no_string_terminators))
                 element->name()[element->name_size()] = Ch('\0');
+            if (Flags & parse_namespaces)
+                m_namespace_scope = scope;
+#ifdef RAPIDXML_PARSE_STATISTICS
+            if (m_statistics)
+                --m_depth;
+#endif
 
             // Return parsed element
             return element;
@@ -2189,25 +3381,7 @@ namespace rapidxml
                     if (text[1] == Ch('/'))
                     {
                         // Node closing
-                        text += 2;      // Skip '</'
-                        if (Flags & parse_validate_closing_tags)
-                        {
-                            // Skip and validate closing tag name
-                            Ch *closing_name = text;
-                            skip<node_name_pred, Flags>(text);
-                            if (!internal::compare(node->name(), node->name_size(), closing_name, text - closing_name, true))
-                                RAPIDXML_PARSE_ERROR("invalid closing tag name", text);
-                        }
-                        else
-                        {
-                            // No validation, just skip name
-                            skip<node_name_pred, Flags>(text);
-                        }
-                        // Skip remaining whitespace after node name
-                        skip<whitespace_pred, Flags>(text);
-                        if (*text != Ch('>'))
-                            RAPIDXML_PARSE_ERROR("expected >", text);
-                        ++text;     // Skip '>'
+                        parse_closing_tag<Flags>(text, node);
                         return;     // Node closed, finished parsing contents
                     }
                     else
@@ -2232,10 +3406,39 @@ namespace rapidxml
             }
         }
         
+        // Parse closing tag of the node; text points to '</'
+        template<int Flags>
+        void parse_closing_tag(Ch *&text, xml_node<Ch> *node)
+        {
+            text += 2;      // Skip '</'
+            if (Flags & parse_validate_closing_tags)
+            {
+                // Skip and validate closing tag name
+                Ch *closing_name = text;
+                skip<node_name_pred, Flags>(text);
+                if (!internal::compare(node->name(), node->name_size(), closing_name, text - closing_name, true))
+                    RAPIDXML_PARSE_ERROR("invalid closing tag name", text);
+            }
+            else
+            {
+                // No validation, just skip name
+                skip<node_name_pred, Flags>(text);
+            }
+            // Skip remaining whitespace after node name
+            skip<whitespace_pred, Flags>(text);
+            if (*text != Ch('>'))
+                RAPIDXML_PARSE_ERROR("expected >", text);
+            ++text;     // Skip '>'
+        }
+
         // Parse XML attributes of the node
         template<int Flags>
         void parse_node_attributes(Ch *&text, xml_node<Ch> *node)
         {
+#ifdef RAPIDXML_PARSE_STATISTICS
+            internal::phase_timer timer(m_statistics && attribute_name_pred::test(*text) ? &m_statistics->attribute_ns : 0);
+#endif
+
             // For all attributes 
             while (attribute_name_pred::test(*text))
             {
@@ -2297,6 +3500,17 @@ namespace rapidxml
             }
         }
 
+        int m_parse_flags;      // Flags of last parse() call
+        namespace_entry *m_namespaces;          // Table of namespace URIs, allocated from the pool
+        unsigned m_namespace_count;             // Number of URIs in the table
+        unsigned m_namespace_capacity;          // Number of URIs the table has room for
+        namespace_binding *m_namespace_scope;   // Innermost binding of the element being parsed, or 0
+#ifdef RAPIDXML_PARSE_STATISTICS
+        parse_statistics *m_collector;      // Collector set by collect_statistics(), or 0
+        parse_statistics *m_statistics;     // Collector filled in by the running parse(), or 0
+        std::size_t m_depth;                // Element nesting at the current parse position
+#endif
+
     };
 
     //! \cond internal
@@ -7,6 +7,7 @@
 //! \file rapidxml_print.hpp This file contains rapidxml printer implementation
 
 #include "rapidxml.hpp"
+#include <cstring>
 
 // Only include streams if not disabled
 #ifndef RAPIDXML_NO_STREAMS
@@ -41,41 +42,85 @@ namespace rapidxml
             return out;
         }
         
+        // Copy characters from given range to given pointer in one block
+        template<class Ch>
+        inline Ch *copy_chars(const Ch *begin, const Ch *end, Ch *out)
+        {
+            if (begin != end)
+                std::memcpy(out, begin, (end - begin) * sizeof(Ch));
+            return out + (end - begin);
+        }
+
+        // Check if character is expanded into a reference by copy_and_expand_chars
+        template<class Ch>
+        inline bool is_expanded_char(Ch ch, Ch noexpand)
+        {
+            return ch != noexpand && (ch == Ch('<') || ch == Ch('>') || ch == Ch('\'') || ch == Ch('"') || ch == Ch('&'));
+        }
+
+#ifdef RAPIDXML_SIMD
+        // Set of characters expanded by copy_and_expand_chars, except noexpand
+        inline simd_charset expanded_charset(char noexpand)
+        {
+            unsigned char table[256];
+            for (int c = 0; c < 256; ++c)
+                table[c] = !is_expanded_char(static_cast<char>(c), noexpand);
+            return simd_charset::from_table(table);
+        }
+#endif
+
+        // Find first character in given range expanded by copy_and_expand_chars, or end
+        template<class Ch>
+        inline const Ch *find_expanded_char(const Ch *begin, const Ch *end, Ch noexpand)
+        {
+#ifdef RAPIDXML_SIMD
+            // Short runs are found faster by the plain loop
+            if (sizeof(Ch) == 1 && end - begin >= 16)
+            {
+                static const simd_charset all = expanded_charset(0);
+                static const simd_charset no_quot = expanded_charset('"');
+                static const simd_charset no_apos = expanded_charset('\'');
+                const simd_charset *set = noexpand == Ch('"') ? &no_quot : noexpand == Ch('\'') ? &no_apos : &all;
+                if (set->usable && (set != &all || !is_expanded_char(noexpand, Ch(0))))
+                    return reinterpret_cast<const Ch *>(simd_finder()(reinterpret_cast<const char *>(begin), reinterpret_cast<const char *>(end), *set));
+            }
+#endif
+            while (begin != end && !is_expanded_char(*begin, noexpand))
+                ++begin;
+            return begin;
+        }
+
         // Copy characters from given range to given output iterator and expand
-        // characters into references (&lt; &gt; &apos; &quot; &amp;)
+        // characters into references (&lt; &gt; &apos; &quot; &amp;).
+        // Runs of characters without expansion are found by vectorized scanning where available.
         template<class OutIt, class Ch>
         inline OutIt copy_and_expand_chars(const Ch *begin, const Ch *end, Ch noexpand, OutIt out)
         {
             while (begin != end)
             {
-                if (*begin == noexpand)
+                const Ch *run = find_expanded_char(begin, end, noexpand);
+                out = copy_chars(begin, run, out);
+                if (run == end)
+                    break;
+                switch (*run)
                 {
-                    *out++ = *begin;    // No expansion, copy character
+                case Ch('<'):
+                    *out++ = Ch('&'); *out++ = Ch('l'); *out++ = Ch('t'); *out++ = Ch(';');
+                    break;
+                case Ch('>'): 
+                    *out++ = Ch('&'); *out++ = Ch('g'); *out++ = Ch('t'); *out++ = Ch(';');
+                    break;
+                case Ch('\''): 
+                    *out++ = Ch('&'); *out++ = Ch('a'); *out++ = Ch('p'); *out++ = Ch('o'); *out++ = Ch('s'); *out++ = Ch(';');
+                    break;
+                case Ch('"'): 
+                    *out++ = Ch('&'); *out++ = Ch('q'); *out++ = Ch('u'); *out++ = Ch('o'); *out++ = Ch('t'); *out++ = Ch(';');
+                    break;
+                default:    // Ampersand
+                    *out++ = Ch('&'); *out++ = Ch('a'); *out++ = Ch('m'); *out++ = Ch('p'); *out++ = Ch(';'); 
+                    break;
                 }
-                else
-                {
-                    switch (*begin)
-                    {
-                    case Ch('<'):
-                        *out++ = Ch('&'); *out++ = Ch('l'); *out++ = Ch('t'); *out++ = Ch(';');
-                        break;
-                    case Ch('>'): 
-                        *out++ = Ch('&'); *out++ = Ch('g'); *out++ = Ch('t'); *out++ = Ch(';');
-                        break;
-                    case Ch('\''): 
-                        *out++ = Ch('&'); *out++ = Ch('a'); *out++ = Ch('p'); *out++ = Ch('o'); *out++ = Ch('s'); *out++ = Ch(';');
-                        break;
-                    case Ch('"'): 
-                        *out++ = Ch('&'); *out++ = Ch('q'); *out++ = Ch('u'); *out++ = Ch('o'); *out++ = Ch('t'); *out++ = Ch(';');
-                        break;
-                    case Ch('&'): 
-                        *out++ = Ch('&'); *out++ = Ch('a'); *out++ = Ch('m'); *out++ = Ch('p'); *out++ = Ch(';'); 
-                        break;
-                    default:
-                        *out++ = *begin;    // No expansion, copy character
-                    }
-                }
-                ++begin;    // Step to next character
+                begin = run + 1;    // Step to next character
             }
             return out;
         }
@@ -101,6 +146,17 @@ namespace rapidxml
 
         ///////////////////////////////////////////////////////////////////////////
         // Internal printing operations
+
+        // Printing functions call each other, so they have to be declared before
+        // the first use to be found by two-phase name lookup
+        template<class OutIt, class Ch> inline OutIt print_children(OutIt out, const xml_node<Ch> *node, int flags, int indent);
+        template<class OutIt, class Ch> inline OutIt print_element_node(OutIt out, const xml_node<Ch> *node, int flags, int indent);
+        template<class OutIt, class Ch> inline OutIt print_data_node(OutIt out, const xml_node<Ch> *node, int flags, int indent);
+        template<class OutIt, class Ch> inline OutIt print_cdata_node(OutIt out, const xml_node<Ch> *node, int flags, int indent);
+        template<class OutIt, class Ch> inline OutIt print_declaration_node(OutIt out, const xml_node<Ch> *node, int flags, int indent);
+        template<class OutIt, class Ch> inline OutIt print_comment_node(OutIt out, const xml_node<Ch> *node, int flags, int indent);
+        template<class OutIt, class Ch> inline OutIt print_doctype_node(OutIt out, const xml_node<Ch> *node, int flags, int indent);
+        template<class OutIt, class Ch> inline OutIt print_pi_node(OutIt out, const xml_node<Ch> *node, int flags, int indent);
     
         // Print node
         template<class OutIt, class Ch>
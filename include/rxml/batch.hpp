@@ -0,0 +1,290 @@
+#pragma once
+#ifndef _RXML_BATCH_HPP
+#define _RXML_BATCH_HPP
+
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "error.hpp"
+#include "document_pool.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### batch_entry ###########################################
+template<typename _Ch = char>
+class batch_entry
+{
+	template<typename> friend class document_batch;
+public:
+	typedef rapidxml::xml_document<_Ch> document_type;
+
+	batch_entry(batch_entry&& other)
+		: m_filename(std::move(other.m_filename))
+		, m_document(std::move(other.m_document))
+		, m_text(other.m_text)
+		, m_error(std::move(other.m_error))
+	{
+	}
+
+	const std::string& filename() const
+	{
+		return m_filename;
+	}
+
+	// the parsed document, or nullptr if reading or parsing failed
+	document_type* document() const
+	{
+		return m_error? nullptr : m_document.get();
+	}
+
+	// the exception thrown while reading or parsing, if any
+	std::exception_ptr error() const
+	{
+		return m_error;
+	}
+
+	// the parsed document, rethrows the error otherwise
+	document_type& get() const
+	{
+		if(m_error)
+			std::rethrow_exception(m_error);
+		return *m_document;
+	}
+
+	explicit operator bool() const
+	{
+		return !m_error;
+	}
+
+private:
+	explicit batch_entry(const std::string& filename)
+		: m_filename(filename)
+		, m_text(nullptr)
+	{
+	}
+
+	batch_entry(const batch_entry&);
+	batch_entry& operator =(const batch_entry&);
+
+	std::string m_filename;
+	typename document_pool<_Ch>::handle m_document;
+	_Ch* m_text;
+	std::exception_ptr m_error;
+};
+
+
+// ########################################### document_batch ###########################################
+/*
+ * Parses many files at once: the calling thread reads them in input order while worker threads
+ * parse the files read so far, staying at most read_ahead files behind.
+ *
+ * Every file is read into the memory pool of its own document, which is taken from a document_pool,
+ * so parsing the next batch reuses the blocks of the documents of the last one. Errors are captured per
+ * file; the other files are parsed regardless. Entries keep the input order.
+ *
+ * Documents and texts are owned by the batch and live until the next parse() or its destruction.
+ */
+template<typename _Ch = char>
+class document_batch
+{
+public:
+	typedef batch_entry<_Ch> entry_type;
+	typedef rapidxml::xml_document<_Ch> document_type;
+	typedef typename std::vector<entry_type>::const_iterator const_iterator;
+
+	static const std::size_t read_ahead = 16;	// per worker thread
+
+	explicit document_batch(const rapidxml::memory_pool_config& config = rapidxml::memory_pool_config(), std::size_t max_retained = 1 << 20)
+		: m_pool(new document_pool<_Ch>(max_retained, 4, 64, config))
+	{
+	}
+
+	// threads is the number of parsing threads, 0 for one per core;
+	// if no thread can be started, the calling thread parses every file right after reading it
+	template<int _Flags>
+	void parse(const std::vector<std::string>& filenames, unsigned threads = 0)
+	{
+		m_entries.clear();
+		m_entries.reserve(filenames.size());
+		for(auto& filename : filenames)
+			m_entries.push_back(entry_type(filename));
+
+		if(!threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+
+		std::mutex mutex;
+		std::condition_variable ready, progress;
+		std::size_t loaded = 0, next = 0, parsed = 0;
+		const std::size_t count = m_entries.size();
+
+		auto work = [&]()
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while(true)
+				{
+					ready.wait(lock, [&]() { return next < loaded || next == count; });
+					if(next == count)
+						return;
+					entry_type& entry = m_entries[next++];
+
+					lock.unlock();
+					parse_entry<_Flags>(entry);
+					lock.lock();
+
+					++parsed;
+					progress.notify_one();
+				}
+			};
+
+		std::vector<std::thread> workers;
+		for(unsigned i = 0; i < threads && count; ++i)
+		{
+			try
+			{
+				workers.push_back(std::thread(work));
+			}catch(const std::system_error&)
+			{
+				break;
+			}
+		}
+
+		const std::size_t window = read_ahead * workers.size();
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			if(!workers.empty())
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				progress.wait(lock, [&]() { return i - parsed < window; });
+			}
+
+			load_entry(m_entries[i]);
+
+			if(workers.empty())
+			{
+				parse_entry<_Flags>(m_entries[i]);
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			++loaded;
+			ready.notify_one();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ready.notify_all();
+		}
+		for(auto& worker : workers)
+			worker.join();
+	}
+
+	// returns the documents to the pool
+	void clear()
+	{
+		m_entries.clear();
+	}
+
+	std::size_t size() const						{ return m_entries.size(); }
+	bool empty() const								{ return m_entries.empty(); }
+	const entry_type& operator [](std::size_t i) const	{ return m_entries[i]; }
+	const_iterator begin() const					{ return m_entries.begin(); }
+	const_iterator end() const						{ return m_entries.end(); }
+
+	// number of entries that failed to read or parse
+	std::size_t failures() const
+	{
+		std::size_t result = 0;
+		for(auto& entry : m_entries)
+		{
+			if(!entry)
+				++result;
+		}
+		return result;
+	}
+
+private:
+	struct file_closer
+	{
+		void operator ()(std::FILE* file) const
+		{
+			std::fclose(file);
+		}
+	};
+
+	// reads the file into the pool of a document taken from the pool
+	void load_entry(entry_type& entry)
+	{
+		try
+		{
+			std::unique_ptr<std::FILE, file_closer> file(std::fopen(entry.m_filename.c_str(), "rb"));
+			if(!file)
+				throw std::runtime_error("cannot open file " + entry.m_filename);
+
+			long size = -1;
+			if(std::fseek(file.get(), 0, SEEK_END) == 0)
+				size = std::ftell(file.get());
+			if(size < 0 || std::fseek(file.get(), 0, SEEK_SET) != 0)
+				throw std::runtime_error("cannot read file " + entry.m_filename);
+			if(size % sizeof(_Ch))
+				throw std::runtime_error("file size is not a multiple of the character size " + entry.m_filename);
+
+			const std::size_t length = static_cast<std::size_t>(size) / sizeof(_Ch);
+			entry.m_document = m_pool->acquire();
+			entry.m_text = entry.m_document->allocate_string(nullptr, length + 1);
+			if(std::fread(entry.m_text, sizeof(_Ch), length, file.get()) != length)
+				throw std::runtime_error("cannot read file " + entry.m_filename);
+			entry.m_text[length] = _Ch('\0');
+		}catch(...)
+		{
+			entry.m_error = std::current_exception();
+			entry.m_document.reset();
+		}
+	}
+
+	template<int _Flags>
+	static void parse_entry(entry_type& entry)
+	{
+		if(entry.m_error)
+			return;
+
+		try
+		{
+			entry.m_document->template parse<_Flags>(entry.m_text);
+		}catch(...)
+		{
+			entry.m_error = std::current_exception();
+			entry.m_document.reset();
+		}
+	}
+
+	// declared first, so entries return their documents before the pool is destroyed
+	std::unique_ptr<document_pool<_Ch>> m_pool;
+	std::vector<entry_type> m_entries;
+};
+
+
+template<int _Flags, typename _Ch = char>
+document_batch<_Ch> parse_batch(const std::vector<std::string>& filenames, unsigned threads = 0)
+{
+	document_batch<_Ch> batch;
+	batch.template parse<_Flags>(filenames, threads);
+	return batch;
+}
+
+
+}
+
+
+
+#endif
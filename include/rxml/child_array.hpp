@@ -0,0 +1,217 @@
+#pragma once
+#ifndef _RXML_CHILD_ARRAY_HPP
+#define _RXML_CHILD_ARRAY_HPP
+
+#include <rapidxml.hpp>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include "error.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### node_span ###########################################
+/*
+ * Contiguous view over materialized node pointers.
+ * The iterators are plain pointers, so every random access algorithm (and every parallel algorithm) can be used.
+ * Reordering the span only reorders the pointers, the children inside the dom stay untouched.
+ */
+template<typename _Entity>
+class node_span
+{
+public:
+	typedef _Entity*			value_type;
+	typedef _Entity*&			reference;
+	typedef _Entity**			iterator;
+	typedef _Entity* const*		const_iterator;
+	typedef std::size_t			size_type;
+
+	node_span()
+		: m_begin(nullptr)
+		, m_end(nullptr)
+	{
+	}
+
+	node_span(_Entity** begin, _Entity** end)
+		: m_begin(begin)
+		, m_end(end)
+	{
+	}
+
+	iterator begin() const	{ return m_begin; }
+	iterator end() const	{ return m_end; }
+	_Entity** data() const	{ return m_begin; }
+
+	size_type size() const	{ return m_end - m_begin; }
+	bool empty() const		{ return m_begin == m_end; }
+
+	reference operator [](size_type idx) const
+	{
+		rxml_assert(idx < size());
+		return m_begin[idx];
+	}
+
+	reference at(size_type idx) const
+	{
+		if(idx >= size())
+			throw std::out_of_range("child index out of range");
+		return m_begin[idx];
+	}
+
+	reference front() const	{ return (*this)[0]; }
+	reference back() const	{ return (*this)[size() - 1]; }
+
+private:
+	_Entity** m_begin;
+	_Entity** m_end;
+};
+
+
+namespace detail {
+
+	template<typename _Entity>
+	void materialize_children(_Entity* node, std::vector<_Entity*>& storage)
+	{
+		rxml_assert(node);
+		storage.clear();
+
+		for(_Entity* child = node->first_node();
+			child;
+			child = child->next_sibling())
+		{
+			storage.push_back(child);
+		}
+	}
+
+	template<typename _Entity>
+	node_span<_Entity> make_span(std::vector<_Entity*>& storage)
+	{
+		if(storage.empty())
+			return node_span<_Entity>();
+		return node_span<_Entity>(&storage.front(), &storage.front() + storage.size());
+	}
+}
+
+
+// ########################################### child_array ###########################################
+template<typename _Ch>
+std::vector<rapidxml::xml_node<_Ch>*> child_array(rapidxml::xml_node<_Ch>* node)
+{
+	std::vector<rapidxml::xml_node<_Ch>*> result;
+	detail::materialize_children(node, result);
+	return result;
+}
+
+template<typename _Ch>
+std::vector<const rapidxml::xml_node<_Ch>*> child_array(const rapidxml::xml_node<_Ch>* node)
+{
+	std::vector<const rapidxml::xml_node<_Ch>*> result;
+	detail::materialize_children(node, result);
+	return result;
+}
+
+template<typename _Ch>
+std::vector<rapidxml::xml_node<_Ch>*> child_array(rapidxml::xml_node<_Ch>& node)
+{
+	return rxml::child_array(&node);
+}
+
+template<typename _Ch>
+std::vector<const rapidxml::xml_node<_Ch>*> child_array(const rapidxml::xml_node<_Ch>& node)
+{
+	return rxml::child_array(&node);
+}
+
+
+// caller storage is reused, so repeated calls do not allocate once the capacity is large enough
+template<typename _Ch>
+node_span<rapidxml::xml_node<_Ch>> child_array(rapidxml::xml_node<_Ch>* node, std::vector<rapidxml::xml_node<_Ch>*>& storage)
+{
+	detail::materialize_children(node, storage);
+	return detail::make_span(storage);
+}
+
+template<typename _Ch>
+node_span<const rapidxml::xml_node<_Ch>> child_array(const rapidxml::xml_node<_Ch>* node, std::vector<const rapidxml::xml_node<_Ch>*>& storage)
+{
+	detail::materialize_children(node, storage);
+	return detail::make_span(storage);
+}
+
+template<typename _Ch>
+node_span<rapidxml::xml_node<_Ch>> child_array(rapidxml::xml_node<_Ch>& node, std::vector<rapidxml::xml_node<_Ch>*>& storage)
+{
+	return rxml::child_array(&node, storage);
+}
+
+template<typename _Ch>
+node_span<const rapidxml::xml_node<_Ch>> child_array(const rapidxml::xml_node<_Ch>& node, std::vector<const rapidxml::xml_node<_Ch>*>& storage)
+{
+	return rxml::child_array(&node, storage);
+}
+
+
+// ########################################### child_table ###########################################
+/*
+ * Side table caching the materialized children of nodes.
+ * The children of a node are collected on the first request only. Returned spans stay valid
+ * until the node is invalidated or the table is cleared.
+ * Call invalidate() after adding or removing children of a cached node.
+ * The table is not synchronized; fill it before sharing it between threads.
+ */
+template<typename _Entity>
+class child_table
+{
+public:
+	typedef node_span<_Entity>	span_type;
+
+	span_type child_array(_Entity* node)
+	{
+		rxml_assert(node);
+		auto it = m_table.find(node);
+
+		if(it == m_table.end())
+		{
+			it = m_table.insert(std::make_pair(static_cast<const _Entity*>(node), std::vector<_Entity*>())).first;
+			detail::materialize_children(node, it->second);
+		}
+
+		return detail::make_span(it->second);
+	}
+
+	span_type child_array(_Entity& node)
+	{
+		return child_array(&node);
+	}
+
+	void invalidate(const _Entity* node)
+	{
+		m_table.erase(node);
+	}
+
+	void invalidate(const _Entity& node)
+	{
+		invalidate(&node);
+	}
+
+	void clear()
+	{
+		m_table.clear();
+	}
+
+	std::size_t size() const
+	{
+		return m_table.size();
+	}
+
+private:
+	std::unordered_map<const _Entity*, std::vector<_Entity*>> m_table;
+};
+
+}
+
+
+
+#endif
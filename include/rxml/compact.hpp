@@ -0,0 +1,477 @@
+#pragma once
+#ifndef _RXML_COMPACT_HPP
+#define _RXML_COMPACT_HPP
+
+#include <rapidxml.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "error.hpp"
+#include "handles.hpp"
+#include "reader.hpp"
+
+
+namespace rxml {
+
+template<typename _Ch> class compact_node;
+template<typename _Ch> class compact_attribute;
+
+
+namespace detail {
+
+	static const std::uint32_t compact_npos = ~std::uint32_t(0);
+	static const std::uint32_t compact_max_attributes = (1u << 24) - 1;		// per element, see attribute_count
+
+	// strings are 32 bit offsets into the text, links are 32 bit indices into the record arrays
+	struct compact_node_record
+	{
+		std::uint32_t name;
+		std::uint32_t name_size;
+		std::uint32_t value;
+		std::uint32_t value_size;
+		std::uint32_t parent;
+		std::uint32_t first_child;
+		std::uint32_t next_sibling;
+		std::uint32_t first_attribute;
+		std::uint32_t attribute_count : 24;
+		std::uint32_t type : 8;
+	};
+
+	// the attributes of a node are stored consecutively
+	struct compact_attribute_record
+	{
+		std::uint32_t name;
+		std::uint32_t name_size;
+		std::uint32_t value;
+		std::uint32_t value_size;
+		std::uint32_t parent;
+	};
+
+	// the records may be owned by a compact_document or lie in a mapped snapshot
+	template<typename _Ch>
+	struct compact_storage
+	{
+		const _Ch* text;
+		const compact_node_record* nodes;
+		const compact_attribute_record* attributes;
+		std::uint32_t node_count;
+		std::uint32_t attribute_count;
+	};
+
+	template<typename _Ch>
+	inline bool compact_name_equals(const _Ch* text, std::uint32_t offset, std::uint32_t size, const _Ch* name, std::size_t name_size, bool case_sensitive)
+	{
+		return rapidxml::internal::compare(text + offset, size, name, name_size, case_sensitive);
+	}
+}
+
+
+// ########################################### compact_entity ###########################################
+/*
+ * Handle to a node or an attribute of a compact_document, the counterpart of rapidxml::xml_base.
+ * Handles are small values; a default constructed handle is null and converts to false.
+ * Names and values point into the parsed text and are not zero terminated.
+ * See handles.hpp for the rxml accessors.
+ */
+template<typename _Ch = char>
+class compact_entity
+{
+public:
+	typedef _Ch char_type;
+	typedef compact_entity<_Ch> handle_entity;
+	typedef compact_node<_Ch> handle_node;
+	typedef compact_attribute<_Ch> handle_attribute;
+
+	compact_entity()
+		: m_storage(nullptr)
+		, m_index(0)
+		, m_attribute(false)
+	{
+	}
+
+	compact_entity(const detail::compact_storage<_Ch>* storage, std::uint32_t index, bool attribute)
+		: m_storage(storage)
+		, m_index(index)
+		, m_attribute(attribute)
+	{
+	}
+
+	const _Ch* name() const
+	{
+		return m_storage->text + (m_attribute? attribute_record().name : node_record().name);
+	}
+
+	std::size_t name_size() const
+	{
+		return m_attribute? attribute_record().name_size : node_record().name_size;
+	}
+
+	// the raw value, entities are not decoded (see rxml::value)
+	const _Ch* value() const
+	{
+		return m_storage->text + (m_attribute? attribute_record().value : node_record().value);
+	}
+
+	std::size_t value_size() const
+	{
+		return m_attribute? attribute_record().value_size : node_record().value_size;
+	}
+
+	compact_node<_Ch> parent() const
+	{
+		const std::uint32_t parent = m_attribute? attribute_record().parent : node_record().parent;
+		return parent == detail::compact_npos? compact_node<_Ch>() : compact_node<_Ch>(m_storage, parent);
+	}
+
+	// the document node comes first
+	compact_node<_Ch> document() const
+	{
+		return compact_node<_Ch>(m_storage, 0);
+	}
+
+	bool is_attribute() const
+	{
+		return m_attribute;
+	}
+
+	std::uint32_t index() const
+	{
+		return m_index;
+	}
+
+	const detail::compact_storage<_Ch>* storage() const
+	{
+		return m_storage;
+	}
+
+	explicit operator bool() const
+	{
+		return m_storage != nullptr;
+	}
+
+	bool operator ==(const compact_entity& other) const
+	{
+		return m_storage == other.m_storage && m_index == other.m_index && m_attribute == other.m_attribute;
+	}
+
+	bool operator !=(const compact_entity& other) const
+	{
+		return !(*this == other);
+	}
+
+protected:
+	const detail::compact_node_record& node_record() const
+	{
+		rxml_assert(m_storage && !m_attribute);
+		return m_storage->nodes[m_index];
+	}
+
+	const detail::compact_attribute_record& attribute_record() const
+	{
+		rxml_assert(m_storage && m_attribute);
+		return m_storage->attributes[m_index];
+	}
+
+	const detail::compact_storage<_Ch>* m_storage;
+	std::uint32_t m_index;
+	bool m_attribute;
+};
+
+
+// ########################################### compact_attribute ###########################################
+template<typename _Ch = char>
+class compact_attribute
+	: public compact_entity<_Ch>
+{
+public:
+	compact_attribute()
+	{
+	}
+
+	compact_attribute(const detail::compact_storage<_Ch>* storage, std::uint32_t index)
+		: compact_entity<_Ch>(storage, index, true)
+	{
+	}
+
+	compact_attribute next_attribute(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		const detail::compact_node_record& parent = this->m_storage->nodes[this->attribute_record().parent];
+		return find(this->m_storage, this->m_index + 1, parent.first_attribute + parent.attribute_count, name, name_size, case_sensitive);
+	}
+
+	const compact_attribute* operator ->() const
+	{
+		return this;
+	}
+
+	// first attribute in [first, last) with the given name
+	static compact_attribute find(const detail::compact_storage<_Ch>* storage, std::uint32_t first, std::uint32_t last,
+									const _Ch* name, std::size_t name_size, bool case_sensitive)
+	{
+		if(name && !name_size)
+			name_size = rapidxml::internal::measure(name);
+
+		for(; first < last; ++first)
+		{
+			const detail::compact_attribute_record& attr = storage->attributes[first];
+			if(!name || detail::compact_name_equals(storage->text, attr.name, attr.name_size, name, name_size, case_sensitive))
+				return compact_attribute(storage, first);
+		}
+		return compact_attribute();
+	}
+};
+
+
+// ########################################### compact_node ###########################################
+/*
+ * Handle to a node of a compact_document, the counterpart of rapidxml::xml_node.
+ * Only forward navigation is supported.
+ */
+template<typename _Ch = char>
+class compact_node
+	: public compact_entity<_Ch>
+{
+public:
+	compact_node()
+	{
+	}
+
+	compact_node(const detail::compact_storage<_Ch>* storage, std::uint32_t index)
+		: compact_entity<_Ch>(storage, index, false)
+	{
+	}
+
+	rapidxml::node_type type() const
+	{
+		return static_cast<rapidxml::node_type>(this->node_record().type);
+	}
+
+	compact_node first_node(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		return find(this->node_record().first_child, name, name_size, case_sensitive);
+	}
+
+	compact_node next_sibling(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		return find(this->node_record().next_sibling, name, name_size, case_sensitive);
+	}
+
+	compact_attribute<_Ch> first_attribute(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		const detail::compact_node_record& record = this->node_record();
+		return compact_attribute<_Ch>::find(this->m_storage, record.first_attribute, record.first_attribute + record.attribute_count,
+											name, name_size, case_sensitive);
+	}
+
+	const compact_node* operator ->() const
+	{
+		return this;
+	}
+
+private:
+	// first node in the sibling chain starting at index with the given name
+	compact_node find(std::uint32_t index, const _Ch* name, std::size_t name_size, bool case_sensitive) const
+	{
+		if(name && !name_size)
+			name_size = rapidxml::internal::measure(name);
+
+		for(; index != detail::compact_npos; index = this->m_storage->nodes[index].next_sibling)
+		{
+			const detail::compact_node_record& node = this->m_storage->nodes[index];
+			if(!name || detail::compact_name_equals(this->m_storage->text, node.name, node.name_size, name, name_size, case_sensitive))
+				return compact_node(this->m_storage, index);
+		}
+		return compact_node();
+	}
+};
+
+
+// ########################################### compact_document ###########################################
+/*
+ * Read-only document storing every node in 36 bytes and every attribute in 20 bytes, instead of the
+ * pointers of xml_node and xml_attribute, by using 32 bit offsets into the text and 32 bit indices
+ * into two record arrays. The text is not modified, must outlive the document and be smaller than 4 GiB,
+ * and elements have less than 2^24 attributes.
+ *
+ * The tree equals the one of xml_document::parse<parse_default | parse_non_destructive>: elements,
+ * data and cdata nodes; element values are the first data child. Values keep their entities,
+ * rxml::value decodes them.
+ */
+template<typename _Ch = char>
+class compact_document
+	: public compact_node<_Ch>
+{
+	typedef detail::compact_node_record node_record;
+	typedef detail::compact_attribute_record attribute_record;
+public:
+	compact_document()
+		: compact_node<_Ch>(&m_storage, 0)
+	{
+		clear();
+	}
+
+	// text must be zero terminated
+	void parse(const _Ch* text)
+	{
+		rxml_assert(text);
+		clear();
+
+		if(rapidxml::internal::measure(text) >= detail::compact_npos)
+			throw std::length_error("text is too large for a compact document");
+		m_storage.text = text;
+
+		try
+		{
+			build(text);
+		}catch(...)
+		{
+			clear();
+			throw;
+		}
+
+		m_nodes.shrink_to_fit();
+		m_attributes.shrink_to_fit();
+		update_storage();
+	}
+
+	void clear()
+	{
+		static const _Ch empty[1] = { _Ch('\0') };
+		m_storage.text = empty;
+		m_nodes.clear();
+		m_attributes.clear();
+
+		node_record document = {};
+		document.parent = document.first_child = document.next_sibling = detail::compact_npos;
+		document.type = rapidxml::node_document;
+		m_nodes.push_back(document);
+		update_storage();
+	}
+
+	std::size_t node_count() const
+	{
+		return m_nodes.size();
+	}
+
+	std::size_t attribute_count() const
+	{
+		return m_attributes.size();
+	}
+
+	// bytes allocated for the records
+	std::size_t memory_size() const
+	{
+		return m_nodes.capacity() * sizeof(node_record) + m_attributes.capacity() * sizeof(attribute_record);
+	}
+
+private:
+	compact_document(const compact_document&);
+	compact_document& operator =(const compact_document&);
+
+	void build(const _Ch* text)
+	{
+		// open elements and their last child
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> open(1, std::make_pair(0u, detail::compact_npos));
+
+		reader<_Ch> cursor(text);
+		while(cursor.next())
+		{
+			switch(cursor.type())
+			{
+			case reader<_Ch>::token_start_element:
+				{
+					const std::uint32_t element = append(open.back(), rapidxml::node_element, cursor.name(), cursor.name_size());
+					node_record& record = m_nodes[element];
+					if(cursor.attributes().size() > detail::compact_max_attributes)
+						throw std::length_error("too many attributes for a compact document");
+					record.first_attribute = static_cast<std::uint32_t>(m_attributes.size());
+					record.attribute_count = static_cast<std::uint32_t>(cursor.attributes().size());
+
+					for(auto& attr : cursor.attributes())
+					{
+						attribute_record a;
+						a.name = offset(attr.name());
+						a.name_size = static_cast<std::uint32_t>(attr.name_size());
+						a.value = offset(attr.raw_value());
+						a.value_size = static_cast<std::uint32_t>(attr.raw_value_size());
+						a.parent = element;
+						m_attributes.push_back(a);
+					}
+					open.push_back(std::make_pair(element, detail::compact_npos));
+				}
+				break;
+
+			case reader<_Ch>::token_end_element:
+				open.pop_back();
+				break;
+
+			case reader<_Ch>::token_text:
+			case reader<_Ch>::token_cdata:
+				{
+					const bool data = cursor.type() == reader<_Ch>::token_text;
+					const std::uint32_t node = append(open.back(), data? rapidxml::node_data : rapidxml::node_cdata, nullptr, 0);
+					node_record& record = m_nodes[node];
+					record.value = offset(cursor.raw_value());
+					record.value_size = static_cast<std::uint32_t>(cursor.raw_value_size());
+
+					node_record& parent = m_nodes[open.back().first];
+					if(data && !parent.value_size)
+					{
+						parent.value = record.value;
+						parent.value_size = record.value_size;
+					}
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	void update_storage()
+	{
+		m_storage.nodes = m_nodes.data();
+		m_storage.attributes = m_attributes.data();
+		m_storage.node_count = static_cast<std::uint32_t>(m_nodes.size());
+		m_storage.attribute_count = static_cast<std::uint32_t>(m_attributes.size());
+	}
+
+	std::uint32_t offset(const _Ch* p) const
+	{
+		return p? static_cast<std::uint32_t>(p - m_storage.text) : 0;
+	}
+
+	// appends a new last child to the open element
+	std::uint32_t append(std::pair<std::uint32_t, std::uint32_t>& parent, rapidxml::node_type type, const _Ch* name, std::size_t name_size)
+	{
+		const std::uint32_t index = static_cast<std::uint32_t>(m_nodes.size());
+
+		node_record record = {};
+		record.name = offset(name);
+		record.name_size = static_cast<std::uint32_t>(name_size);
+		record.parent = parent.first;
+		record.first_child = record.next_sibling = detail::compact_npos;
+		record.type = type;
+		m_nodes.push_back(record);
+
+		if(parent.second == detail::compact_npos)
+			m_nodes[parent.first].first_child = index;
+		else
+			m_nodes[parent.second].next_sibling = index;
+		parent.second = index;
+
+		return index;
+	}
+
+	detail::compact_storage<_Ch> m_storage;
+	std::vector<node_record> m_nodes;
+	std::vector<attribute_record> m_attributes;
+};
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,239 @@
+#pragma once
+#ifndef _RXML_DOCUMENT_POOL_HPP
+#define _RXML_DOCUMENT_POOL_HPP
+
+#include <rapidxml.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "error.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### document_pool ###########################################
+/*
+ * Hands out reusable documents for parsing many small documents at a high rate.
+ *
+ * A returned document is emptied and its memory pool is rewound: its dynamic blocks are kept, up to
+ * max_retained bytes, and refilled by the next parse instead of being freed and allocated again.
+ * Idle documents are cached per thread first (up to thread_capacity), then in a list shared
+ * by all threads (up to shared_capacity); documents beyond are destroyed.
+ *
+ * Documents cached by a thread are owned by that thread and destroyed when it exits, even if the
+ * pool was destroyed before. Handles may be returned on any thread.
+ */
+template<typename _Ch = char>
+class document_pool
+{
+public:
+	typedef rapidxml::xml_document<_Ch> document_type;
+
+	// exclusive ownership of a document, returns it to the pool on destruction
+	class handle
+	{
+	public:
+		handle()
+			: m_pool(nullptr)
+			, m_document(nullptr)
+		{
+		}
+
+		handle(handle&& other)
+			: m_pool(other.m_pool)
+			, m_document(other.m_document)
+		{
+			other.m_document = nullptr;
+		}
+
+		handle& operator =(handle&& other)
+		{
+			if(this != &other)
+			{
+				reset();
+				m_pool = other.m_pool;
+				m_document = other.m_document;
+				other.m_document = nullptr;
+			}
+			return *this;
+		}
+
+		~handle()
+		{
+			reset();
+		}
+
+		// returns the document to the pool
+		void reset()
+		{
+			if(m_document)
+				m_pool->release(m_document);
+			m_document = nullptr;
+		}
+
+		document_type* get() const			{ return m_document; }
+		document_type* operator ->() const	{ return m_document; }
+		document_type& operator *() const	{ return *m_document; }
+		explicit operator bool() const		{ return m_document != nullptr; }
+
+	private:
+		friend class document_pool;
+
+		handle(document_pool* pool, document_type* document)
+			: m_pool(pool)
+			, m_document(document)
+		{
+		}
+
+		handle(const handle&);
+		handle& operator =(const handle&);
+
+		document_pool* m_pool;
+		document_type* m_document;
+	};
+
+	explicit document_pool(std::size_t max_retained = 1 << 20,
+							std::size_t thread_capacity = 4,
+							std::size_t shared_capacity = 64,
+							const rapidxml::memory_pool_config& config = rapidxml::memory_pool_config())
+		: m_id(next_id()++)
+		, m_max_retained(max_retained)
+		, m_thread_capacity(thread_capacity)
+		, m_shared_capacity(shared_capacity)
+		, m_config(config)
+	{
+	}
+
+	// idle documents cached by other threads stay with them until they exit
+	~document_pool()
+	{
+		auto& entries = thread_entries();
+		for(auto it = entries.begin(); it != entries.end(); ++it)
+		{
+			if(it->pool == m_id)
+			{
+				entries.erase(it);
+				break;
+			}
+		}
+	}
+
+	// returns an idle document or a new one
+	handle acquire()
+	{
+		std::vector<std::unique_ptr<document_type>>& cache = local_cache();
+		if(!cache.empty())
+		{
+			document_type* document = cache.back().release();
+			cache.pop_back();
+			return handle(this, document);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if(!m_shared.empty())
+			{
+				document_type* document = m_shared.back().release();
+				m_shared.pop_back();
+				return handle(this, document);
+			}
+		}
+
+		std::unique_ptr<document_type> document(new document_type());
+		document->configure(m_config);
+		return handle(this, document.release());
+	}
+
+	// number of idle documents in the shared list
+	std::size_t shared_size() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_shared.size();
+	}
+
+	// number of idle documents cached by the calling thread
+	std::size_t thread_size()
+	{
+		return local_cache().size();
+	}
+
+	std::size_t max_retained() const
+	{
+		return m_max_retained;
+	}
+
+private:
+	document_pool(const document_pool&);
+	document_pool& operator =(const document_pool&);
+
+	struct cache_entry
+	{
+		std::uint64_t pool;
+		std::vector<std::unique_ptr<document_type>> documents;
+	};
+
+	static std::vector<cache_entry>& thread_entries()
+	{
+		static thread_local std::vector<cache_entry> entries;
+		return entries;
+	}
+
+	static std::atomic<std::uint64_t>& next_id()
+	{
+		static std::atomic<std::uint64_t> id(0);
+		return id;
+	}
+
+	// cache of the calling thread for this pool; ids are never reused, so a new pool at the address
+	// of a destroyed one does not see its documents
+	std::vector<std::unique_ptr<document_type>>& local_cache()
+	{
+		auto& entries = thread_entries();
+		for(auto& entry : entries)
+		{
+			if(entry.pool == m_id)
+				return entry.documents;
+		}
+
+		entries.push_back(cache_entry());
+		entries.back().pool = m_id;
+		return entries.back().documents;
+	}
+
+	void release(document_type* document)
+	{
+		std::unique_ptr<document_type> owned(document);
+		owned->remove_all_nodes();
+		owned->remove_all_attributes();
+		owned->rewind(m_max_retained);
+
+		std::vector<std::unique_ptr<document_type>>& cache = local_cache();
+		if(cache.size() < m_thread_capacity)
+		{
+			cache.push_back(std::move(owned));
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(m_shared.size() < m_shared_capacity)
+			m_shared.push_back(std::move(owned));
+	}
+
+	const std::uint64_t m_id;
+	const std::size_t m_max_retained;
+	const std::size_t m_thread_capacity;
+	const std::size_t m_shared_capacity;
+	const rapidxml::memory_pool_config m_config;
+	mutable std::mutex m_mutex;
+	std::vector<std::unique_ptr<document_type>> m_shared;
+};
+
+
+}
+
+
+
+#endif
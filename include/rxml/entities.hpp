@@ -0,0 +1,139 @@
+#pragma once
+#ifndef _RXML_ENTITIES_HPP
+#define _RXML_ENTITIES_HPP
+
+#include <rapidxml.hpp>
+#include <string>
+
+
+namespace rxml {
+
+
+/*
+ * Entity decoding outside of the rapidxml parser.
+ * Known are the five predefined entities and numeric character references. Narrow characters
+ * get character references encoded as utf-8, wider characters get the code point itself.
+ */
+
+// ########################################### encode_code_point ###########################################
+template<typename _Ch>
+bool encode_code_point(unsigned long code, std::basic_string<_Ch>& out)
+{
+	if(code >= 0x110000)
+		return false;
+
+	if(sizeof(_Ch) > 1)
+	{
+		out.push_back(static_cast<_Ch>(code));
+	}else if(code < 0x80)
+	{
+		out.push_back(static_cast<_Ch>(code));
+	}else if(code < 0x800)
+	{
+		out.push_back(static_cast<_Ch>(0xC0 | (code >> 6)));
+		out.push_back(static_cast<_Ch>(0x80 | (code & 0x3F)));
+	}else if(code < 0x10000)
+	{
+		out.push_back(static_cast<_Ch>(0xE0 | (code >> 12)));
+		out.push_back(static_cast<_Ch>(0x80 | ((code >> 6) & 0x3F)));
+		out.push_back(static_cast<_Ch>(0x80 | (code & 0x3F)));
+	}else
+	{
+		out.push_back(static_cast<_Ch>(0xF0 | (code >> 18)));
+		out.push_back(static_cast<_Ch>(0x80 | ((code >> 12) & 0x3F)));
+		out.push_back(static_cast<_Ch>(0x80 | ((code >> 6) & 0x3F)));
+		out.push_back(static_cast<_Ch>(0x80 | (code & 0x3F)));
+	}
+	return true;
+}
+
+
+// ########################################### decode_entity ###########################################
+/*
+ * Decodes the entity between '&' and ';', i.e. [begin, end) holds "amp" or "#x41".
+ * Appends the result to out and returns false (leaving out untouched) if the entity is unknown.
+ */
+template<typename _Ch>
+bool decode_entity(const _Ch* begin, const _Ch* end, std::basic_string<_Ch>& out)
+{
+	typedef rapidxml::internal::lookup_tables<0> tables;
+
+	const std::size_t size = end - begin;
+	if(size >= 2 && begin[0] == _Ch('#'))
+	{
+		const bool hex = begin[1] == _Ch('x');
+		const _Ch* digit = begin + (hex? 2 : 1);
+		if(digit == end)
+			return false;
+
+		unsigned long code = 0;
+		for(; digit < end; ++digit)
+		{
+			unsigned char d = tables::lookup_digits[static_cast<unsigned char>(*digit)];
+			if(d >= (hex? 16 : 10))
+				return false;
+			code = code * (hex? 16 : 10) + d;
+			if(code >= 0x110000)
+				return false;
+		}
+		return encode_code_point(code, out);
+	}
+
+	const char* names[] = { "amp", "lt", "gt", "quot", "apos" };
+	const char chars[] = { '&', '<', '>', '"', '\'' };
+	for(std::size_t i = 0; i < 5; ++i)
+	{
+		std::size_t n = 0;
+		for(; n < size && names[i][n] && _Ch(names[i][n]) == begin[n]; ++n);
+		if(n == size && !names[i][n])
+		{
+			out.push_back(_Ch(chars[i]));
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// ########################################### decode_entities ###########################################
+// appends [begin, end) to out with all known entities decoded, unknown ones are copied verbatim
+template<typename _Ch>
+void decode_entities(const _Ch* begin, const _Ch* end, std::basic_string<_Ch>& out)
+{
+	while(begin < end)
+	{
+		const _Ch* amp = begin;
+		for(; amp < end && *amp != _Ch('&'); ++amp);
+		out.append(begin, amp);
+		if(amp == end)
+			return;
+
+		const _Ch* semicolon = amp + 1;
+		for(; semicolon < end && *semicolon != _Ch(';'); ++semicolon);
+
+		if(semicolon < end && decode_entity(amp + 1, semicolon, out))
+		{
+			begin = semicolon + 1;
+		}else
+		{
+			out.push_back(_Ch('&'));
+			begin = amp + 1;
+		}
+	}
+}
+
+template<typename _Ch>
+std::basic_string<_Ch> decode_entities(const _Ch* begin, std::size_t size)
+{
+	std::basic_string<_Ch> result;
+	result.reserve(size);
+	decode_entities(begin, begin + size, result);
+	return result;
+}
+
+
+}
+
+
+
+#endif
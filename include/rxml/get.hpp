@@ -4,9 +4,11 @@
 
 #include <type_traits>
 #include <rapidxml.hpp>
+#include <algorithm>
 #include <string>
 #include <cassert>
 #include "error.hpp"
+#include "traits.hpp"
 
 
 namespace rxml {
@@ -72,6 +74,141 @@ namespace detail {
 	};
 
 
+	// ###################### namespaces ######################
+	/*
+	 * Path steps in Clark notation, {uri}local, match elements by the namespace id resolved by parsing
+	 * with rapidxml::parse_namespaces and by the local part of their name; {}local matches elements
+	 * without namespace. Attributes are not resolved by the parser, so their prefix is looked up in the
+	 * xmlns attributes of the element and its ancestors.
+	 */
+	template<typename _Ch>
+	inline std::size_t prefix_size(const _Ch* name, std::size_t name_size)
+	{
+		for(std::size_t i = 0; i < name_size; ++i)
+		{
+			if(name[i] == _Ch(':'))
+				return i;
+		}
+		return 0;
+	}
+
+	template<typename _Ch>
+	inline bool local_name_is(const rapidxml::xml_base<_Ch>* entity, const _Ch* local, std::size_t local_size)
+	{
+		const std::size_t prefix = prefix_size(entity->name(), entity->name_size());
+		const std::size_t offset = prefix? prefix + 1 : 0;
+		return rapidxml::internal::compare(entity->name() + offset, entity->name_size() - offset, local, local_size, true);
+	}
+
+	// ids of the uris of a path, looked up in the document once per call of get
+	template<typename _Ch>
+	class namespace_resolver
+	{
+	public:
+		namespace_resolver()
+			: m_document(nullptr)
+			, m_uri(nullptr)
+			, m_uri_size(0)
+			, m_id(0)
+		{
+		}
+
+		// 0 for the empty uri and for uris the document does not know
+		unsigned resolve(const rapidxml::xml_node<_Ch>* node, const _Ch* uri, std::size_t uri_size)
+		{
+			// find_namespace would measure an empty uri up to the terminating zero
+			if(!uri_size)
+				return 0;
+
+			// consecutive steps mostly repeat the uri
+			if(uri_size == m_uri_size && std::equal(uri, uri + uri_size, m_uri))
+				return m_id;
+
+			if(!m_document)
+				m_document = node->document();
+			m_uri = uri;
+			m_uri_size = uri_size;
+			m_id = m_document? m_document->find_namespace(uri, uri_size) : 0;
+			return m_id;
+		}
+
+	private:
+		const rapidxml::xml_document<_Ch>* m_document;
+		const _Ch* m_uri;
+		std::size_t m_uri_size;
+		unsigned m_id;
+	};
+
+	template<typename _Node, typename _Ch>
+	_Node* first_node_ns(_Node* node, unsigned id, const _Ch* local, std::size_t local_size)
+	{
+		for(_Node* child = node->first_node(); child; child = child->next_sibling())
+		{
+			if(child->type() == rapidxml::node_element && child->namespace_id() == id && local_name_is(child, local, local_size))
+				return child;
+		}
+		return nullptr;
+	}
+
+	// true if prefix is bound to uri at node
+	template<typename _Ch>
+	bool prefix_bound_to(const rapidxml::xml_node<_Ch>* node, const _Ch* prefix, std::size_t prefix_size, const _Ch* uri, std::size_t uri_size)
+	{
+		static const char xml_uri[] = "http://www.w3.org/XML/1998/namespace";
+		static const char xmlns[] = "xmlns:";
+
+		for(; node; node = node->parent())
+		{
+			for(auto* attr = node->first_attribute(); attr; attr = attr->next_attribute())
+			{
+				if(attr->name_size() != prefix_size + 6 || !std::equal(xmlns, xmlns + 6, attr->name()))
+					continue;
+				if(rapidxml::internal::compare(attr->name() + 6, prefix_size, prefix, prefix_size, true))
+					return rapidxml::internal::compare(attr->value(), attr->value_size(), uri, uri_size, true);
+			}
+		}
+
+		// the xml prefix is bound without declaration
+		return prefix_size == 3 && prefix[0] == _Ch('x') && prefix[1] == _Ch('m') && prefix[2] == _Ch('l')
+			&& uri_size == sizeof(xml_uri) - 1 && std::equal(uri, uri + uri_size, xml_uri);
+	}
+
+	template<typename _Node, typename _Ch>
+	auto first_attribute_ns(_Node* node, const _Ch* uri, std::size_t uri_size, const _Ch* local, std::size_t local_size)
+		-> decltype(node->first_attribute())
+	{
+		for(auto* attr = node->first_attribute(); attr; attr = attr->next_attribute())
+		{
+			if(!local_name_is(attr, local, local_size))
+				continue;
+
+			const std::size_t prefix = prefix_size(attr->name(), attr->name_size());
+			if(prefix? prefix_bound_to(node, attr->name(), prefix, uri, uri_size) : !uri_size)
+				return attr;
+		}
+		return nullptr;
+	}
+
+	// paths addressing an attribute contain ':' outside of the uris of their steps
+	template<typename _Ch>
+	bool is_attribute_path(const _Ch* path, std::size_t path_size)
+	{
+		if(!path_size)
+			path_size = rapidxml::internal::measure(path);
+
+		for(const _Ch* end = path + path_size; path < end; ++path)
+		{
+			if(*path == _Ch(':'))
+				return true;
+			if(*path == _Ch('{'))
+			{
+				for(; path + 1 < end && *path != _Ch('}'); ++path);
+			}
+		}
+		return false;
+	}
+
+
 	template<typename _Result, typename _Node, typename _Ch>
 	struct get_impl
 	{
@@ -103,21 +240,37 @@ namespace detail {
 			const char node_delimiter = _Ch('/');
 			const char attr_delimiter = _Ch(':');
 			const char point_char = _Ch('.');
+			const char uri_begin = _Ch('{');
+			const char uri_end = _Ch('}');
 
 			const _Ch* end = path + path_size;
 
-			if(*path == node_delimiter)
+			if(path < end && *path == node_delimiter)
 			{
 				node = getroot(node);
 				++path;
 			}
 
+			namespace_resolver<_Ch> namespaces;
 			node_type* n = node;
 			while(path < end && n)
 			{
 				const _Ch* p = path;
 
-				if(*path != attr_delimiter)
+				if(*path == uri_begin)
+				{
+					// the uri may contain delimiters
+					const _Ch* uri = path + 1;
+					for(p = uri; p < end && *p != uri_end; ++p);
+					rxml_assert(p < end);
+					const _Ch* local = p + 1;
+					for(p = local; p < end && *p != node_delimiter && *p != attr_delimiter; ++p);
+
+					const std::size_t uri_size = local - 1 - uri;
+					const unsigned id = namespaces.resolve(n, uri, uri_size);
+					n = (id || !uri_size)? first_node_ns(n, id, local, p - local) : nullptr;
+					path = p + ((p < end && *p == attr_delimiter)? 0 : 1);
+				}else if(*path != attr_delimiter)
 				{
 					for(;p < end && *p != node_delimiter && *p != attr_delimiter; ++p);
 
@@ -129,11 +282,19 @@ namespace detail {
 						n = n->first_node(path, p - path);
 					}
 
-					path = p + (*p == attr_delimiter? 0 : 1);
+					path = p + ((p < end && *p == attr_delimiter)? 0 : 1);
 				}else{
 					++path;
 					if(extract_attr)
 					{
+						if(n && path < end && *path == uri_begin)
+						{
+							const _Ch* uri = path + 1;
+							const _Ch* local = uri;
+							for(; local < end && *local != uri_end; ++local);
+							rxml_assert(local < end);
+							return return_if<extract_attr>::ret(first_attribute_ns(n, uri, local - uri, local + 1, end - local - 1));
+						}
 						return n? return_if<extract_attr>::ret(n->first_attribute(path, end - path))
 								: nullptr;
 					}
@@ -163,7 +324,10 @@ namespace detail {
 		}
 	};
 
-	template<typename _Result, typename _Node>
+	// only defined for rapidxml nodes, so other node types (e.g. compact_node) can overload the accessors
+	template<	typename _Result,
+				typename _Node,
+				bool = std::is_base_of<rapidxml::xml_base<typename traits::char_type<_Result>::type>, typename std::remove_cv<_Node>::type>::value>
 	struct return_type
 	{
 		typedef typename std::conditional
@@ -175,6 +339,11 @@ namespace detail {
 				_Result
 			>::type type;
 	};
+
+	template<typename _Result, typename _Node>
+	struct return_type<_Result, _Node, false>
+	{
+	};
 }
 
 
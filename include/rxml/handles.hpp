@@ -0,0 +1,476 @@
+#pragma once
+#ifndef _RXML_HANDLES_HPP
+#define _RXML_HANDLES_HPP
+
+#include <rapidxml.hpp>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "error.hpp"
+#include "entities.hpp"
+#include "iterators.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### handles ###########################################
+/*
+ * rxml::get, getnode, getattr, value, name, locate and the iterators for read-only documents
+ * which hand out small handle values instead of rapidxml pointers (compact_document, tape_document).
+ *
+ * A handle type defines handle_entity, handle_node, handle_attribute and char_type, and has
+ *		entities:	name(), name_size(), value(), value_size(), parent(), document(), is_attribute(),
+ *					explicit operator bool (false for the null handle) and ==
+ *		nodes:		type(), first_node(name, size), next_sibling(), first_attribute(name, size)
+ *		attributes:	next_attribute()
+ * Names and values are not zero terminated and may contain entities, rxml::value decodes them.
+ *
+ * As with rapidxml nodes, the accessors taking a pointer return a null handle if the path is not found,
+ * the ones taking a reference throw.
+ */
+namespace detail {
+
+	template<typename _Ty>
+	struct voider
+	{
+		typedef void type;
+	};
+
+	// only defined for handle types, so the accessors do not compete with the rapidxml ones
+	template<typename _Ty, typename = void>
+	struct handle_types
+	{
+	};
+
+	template<typename _Ty>
+	struct handle_types<_Ty, typename voider<typename _Ty::handle_node>::type>
+	{
+		typedef typename _Ty::handle_entity entity;
+		typedef typename _Ty::handle_node node;
+		typedef typename _Ty::handle_attribute attribute;
+		typedef typename _Ty::char_type char_type;
+		typedef std::basic_string<char_type> string;
+	};
+
+	// same walk as get_impl; stops at the ':' of an attribute path
+	template<typename _Node, typename _Ch>
+	_Node handle_walk(_Node n, const _Ch*& path, const _Ch* end)
+	{
+		if(path < end && *path == _Ch('/'))
+		{
+			n = n.document();
+			++path;
+		}
+
+		while(path < end && n && *path != _Ch(':'))
+		{
+			const _Ch* p = path;
+			for(; p < end && *p != _Ch('/') && *p != _Ch(':'); ++p);
+
+			if(p == path + 2 && path[0] == _Ch('.') && path[1] == _Ch('.'))
+			{
+				n = n.parent();
+			}else{
+				rxml_assert(p != path);
+				n = n.first_node(path, p - path);
+			}
+
+			path = (p < end && *p == _Ch(':'))? p : p + 1;
+		}
+
+		return n;
+	}
+
+	template<typename _Node, typename _Ch>
+	typename _Node::handle_attribute handle_attribute_at(const _Node& n, const _Ch* path, const _Ch* end)
+	{
+		if(!n || path >= end || *path != _Ch(':'))
+			return typename _Node::handle_attribute();
+		return n.first_attribute(path + 1, end - path - 1);
+	}
+
+	template<typename _Node, typename _Ch>
+	_Node handle_getnode(const _Node& node, const _Ch* path, std::size_t path_size)
+	{
+		return handle_walk(node, path, path + path_size);
+	}
+
+	template<typename _Node, typename _Ch>
+	typename _Node::handle_attribute handle_getattr(const _Node& node, const _Ch* path, std::size_t path_size)
+	{
+		const _Ch* end = path + path_size;
+		_Node n = handle_walk(node, path, end);
+		return handle_attribute_at(n, path, end);
+	}
+
+	template<typename _Node, typename _Ch>
+	typename _Node::handle_entity handle_get(const _Node& node, const _Ch* path, std::size_t path_size)
+	{
+		const _Ch* end = path + path_size;
+		_Node n = handle_walk(node, path, end);
+		if(n && path < end && *path == _Ch(':'))
+			return handle_attribute_at(n, path, end);
+		return n;
+	}
+
+	template<typename _Entity, typename _Node, typename _Ch, typename _TGen>
+	_Entity handle_found(const _Entity& entity, const _Node& node, const _Ch* path, _TGen throw_notfound)
+	{
+		if(!entity)
+		{
+			throw_notfound(&node, path);
+			rxml_assert(!"An exception should have been thrown!");
+		}
+		return entity;
+	}
+}
+
+
+template<typename _Entity>
+typename detail::handle_types<_Entity>::node getroot(const _Entity& entity)
+{
+	return entity? entity.document() : typename detail::handle_types<_Entity>::node();
+}
+
+template<typename _Entity>
+typename detail::handle_types<_Entity>::string name(const _Entity& entity)
+{
+	return typename detail::handle_types<_Entity>::string(entity.name(), entity.name_size());
+}
+
+
+// ########################################### getnode  ###########################################
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::node getnode(const _Node* node, const _Ch* path, std::size_t path_size = 0)
+{
+	return detail::handle_getnode<typename detail::handle_types<_Node>::node>(*node, path, path_size? path_size : rapidxml::internal::measure(path));
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::node getnode(const _Node* node, const std::basic_string<_Ch>& path)
+{
+	return detail::handle_getnode<typename detail::handle_types<_Node>::node>(*node, path.c_str(), path.size());
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::node getnode(const _Node& node, const _Ch* path, _TGen throw_notfound, std::size_t path_size = 0)
+{
+	return detail::handle_found(rxml::getnode(&node, path, path_size), node, path, throw_notfound);
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::node getnode(const _Node& node, const std::basic_string<_Ch>& path, _TGen throw_notfound)
+{
+	return rxml::getnode(node, path.c_str(), throw_notfound, path.size());
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::node getnode(const _Node& node, const _Ch* path, std::size_t path_size = 0)
+{
+	return rxml::getnode(node, path, defaults::registry<defaults::not_found>::generator(), path_size);
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::node getnode(const _Node& node, const std::basic_string<_Ch>& path)
+{
+	return rxml::getnode(node, path, defaults::registry<defaults::not_found>::generator());
+}
+
+
+// ########################################### getattr  ###########################################
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::attribute getattr(const _Node* node, const _Ch* path, std::size_t path_size = 0)
+{
+	return detail::handle_getattr<typename detail::handle_types<_Node>::node>(*node, path, path_size? path_size : rapidxml::internal::measure(path));
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::attribute getattr(const _Node* node, const std::basic_string<_Ch>& path)
+{
+	return detail::handle_getattr<typename detail::handle_types<_Node>::node>(*node, path.c_str(), path.size());
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::attribute getattr(const _Node& node, const _Ch* path, _TGen throw_notfound, std::size_t path_size = 0)
+{
+	return detail::handle_found(rxml::getattr(&node, path, path_size), node, path, throw_notfound);
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::attribute getattr(const _Node& node, const std::basic_string<_Ch>& path, _TGen throw_notfound)
+{
+	return rxml::getattr(node, path.c_str(), throw_notfound, path.size());
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::attribute getattr(const _Node& node, const _Ch* path, std::size_t path_size = 0)
+{
+	return rxml::getattr(node, path, defaults::registry<defaults::not_found>::generator(), path_size);
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::attribute getattr(const _Node& node, const std::basic_string<_Ch>& path)
+{
+	return rxml::getattr(node, path, defaults::registry<defaults::not_found>::generator());
+}
+
+
+// ########################################### get  ###########################################
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::entity get(const _Node* node, const _Ch* path, std::size_t path_size = 0)
+{
+	return detail::handle_get<typename detail::handle_types<_Node>::node>(*node, path, path_size? path_size : rapidxml::internal::measure(path));
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::entity get(const _Node* node, const std::basic_string<_Ch>& path)
+{
+	return detail::handle_get<typename detail::handle_types<_Node>::node>(*node, path.c_str(), path.size());
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::entity get(const _Node& node, const _Ch* path, _TGen throw_notfound, std::size_t path_size = 0)
+{
+	return detail::handle_found(rxml::get(&node, path, path_size), node, path, throw_notfound);
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::entity get(const _Node& node, const std::basic_string<_Ch>& path, _TGen throw_notfound)
+{
+	return rxml::get(node, path.c_str(), throw_notfound, path.size());
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::entity get(const _Node& node, const _Ch* path, std::size_t path_size = 0)
+{
+	return rxml::get(node, path, defaults::registry<defaults::not_found>::generator(), path_size);
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::entity get(const _Node& node, const std::basic_string<_Ch>& path)
+{
+	return rxml::get(node, path, defaults::registry<defaults::not_found>::generator());
+}
+
+
+// ########################################### value ###########################################
+template<typename _Entity>
+typename detail::handle_types<_Entity>::string value(const _Entity& entity)
+{
+	typedef typename detail::handle_types<_Entity>::char_type char_type;
+
+	// handle documents do not modify the text, so values still contain their entities
+	const char_type* val = entity.value();
+	const std::size_t size = entity.value_size();
+	if(std::char_traits<char_type>::find(val, size, char_type('&')))
+		return decode_entities(val, size);
+	return std::basic_string<char_type>(val, size);
+}
+
+template<typename _Entity>
+typename detail::handle_types<_Entity>::string value(const _Entity* entity)
+{
+	assert(entity && *entity);
+	return rxml::value(*entity);
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::string value(const _Node& node, const _Ch* path, _TGen throw_notfound, std::size_t path_size = 0)
+{
+	return rxml::value(rxml::get(node, path, throw_notfound, path_size));
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::string value(const _Node& node, const _Ch* path, std::size_t path_size = 0)
+{
+	return rxml::value(node, path, defaults::registry<defaults::not_found>::generator(), path_size);
+}
+
+template<typename _Node, typename _Ch, typename _TGen>
+typename detail::handle_types<_Node>::string value(const _Node& node, const std::basic_string<_Ch>& path, _TGen throw_notfound)
+{
+	return rxml::value(node, path.c_str(), throw_notfound, path.size());
+}
+
+template<typename _Node, typename _Ch>
+typename detail::handle_types<_Node>::string value(const _Node& node, const std::basic_string<_Ch>& path)
+{
+	return rxml::value(node, path, defaults::registry<defaults::not_found>::generator());
+}
+
+
+// ########################################### locate ###########################################
+template<typename _Entity>
+typename detail::handle_types<_Entity>::string locate(const _Entity& entity)
+{
+	typedef typename detail::handle_types<_Entity>::char_type char_type;
+	typedef typename detail::handle_types<_Entity>::node node_type;
+
+	std::vector<node_type> parents;
+	for(node_type node = entity.parent(); node; node = node.parent())
+		parents.push_back(node);
+
+	std::basic_string<char_type> result;
+	if(parents.empty())
+	{
+		result.append(1, char_type('/'));
+	}else{
+		for(auto it = parents.rbegin(); it != parents.rend(); ++it)
+		{
+			result.append(it->name(), it->name_size());
+			result.append(1, char_type('/'));
+		}
+	}
+
+	if(entity.is_attribute())
+		result.back() = char_type(':');
+
+	result.append(entity.name(), entity.name_size());
+	return result;
+}
+
+template<typename _Entity>
+typename detail::handle_types<_Entity>::string locate(const _Entity* entity)
+{
+	if(entity && *entity)
+		return locate(*entity);
+	else
+		return typename detail::handle_types<_Entity>::string();
+}
+
+
+// ########################################### iterators ###########################################
+template<typename _Node>
+class handle_node_iterator
+	: public std::iterator<std::forward_iterator_tag, const _Node>
+{
+public:
+	handle_node_iterator()
+		: m_mask(mask_all)
+	{
+	}
+
+	handle_node_iterator(const _Node& node, unsigned int mask = mask_all)
+		: m_node(node.first_node())
+		, m_mask(mask)
+	{
+		select();
+	}
+
+	const _Node& operator *() const		{ return m_node; }
+	const _Node* operator ->() const	{ return &m_node; }
+
+	handle_node_iterator& operator ++()
+	{
+		m_node = m_node.next_sibling();
+		select();
+		return *this;
+	}
+
+	handle_node_iterator operator ++(int)
+	{
+		handle_node_iterator tmp = *this;
+		++*this;
+		return tmp;
+	}
+
+	bool operator ==(const handle_node_iterator& other) const	{ return m_node == other.m_node; }
+	bool operator !=(const handle_node_iterator& other) const	{ return m_node != other.m_node; }
+
+private:
+	void select()
+	{
+		while(m_node && !(m_mask & (1u << m_node.type())))
+			m_node = m_node.next_sibling();
+	}
+
+	_Node m_node;
+	unsigned int m_mask;
+};
+
+template<typename _Node>
+class handle_attribute_iterator
+	: public std::iterator<std::forward_iterator_tag, const typename _Node::handle_attribute>
+{
+	typedef typename _Node::handle_attribute attribute_type;
+public:
+	handle_attribute_iterator()
+	{
+	}
+
+	handle_attribute_iterator(const _Node& node)
+		: m_attribute(node.first_attribute())
+	{
+	}
+
+	const attribute_type& operator *() const	{ return m_attribute; }
+	const attribute_type* operator ->() const	{ return &m_attribute; }
+
+	handle_attribute_iterator& operator ++()
+	{
+		m_attribute = m_attribute.next_attribute();
+		return *this;
+	}
+
+	handle_attribute_iterator operator ++(int)
+	{
+		handle_attribute_iterator tmp = *this;
+		++*this;
+		return tmp;
+	}
+
+	bool operator ==(const handle_attribute_iterator& other) const	{ return m_attribute == other.m_attribute; }
+	bool operator !=(const handle_attribute_iterator& other) const	{ return m_attribute != other.m_attribute; }
+
+private:
+	attribute_type m_attribute;
+};
+
+namespace detail {
+
+	template<typename _Node, typename = void>
+	struct handle_ranges
+	{
+	};
+
+	template<typename _Node>
+	struct handle_ranges<_Node, typename voider<typename _Node::handle_node>::type>
+	{
+		typedef typename handle_types<_Node>::node node_type;
+		typedef simple_range_wrapper<node_type, handle_node_iterator<node_type>> children_type;
+		typedef masked_range_wrapper<node_type, handle_node_iterator<node_type>> masked_children_type;
+		typedef simple_range_wrapper<node_type, handle_attribute_iterator<node_type>> attributes_type;
+	};
+}
+
+template<typename _Node>
+typename detail::handle_ranges<_Node>::children_type children(const _Node& node)
+{
+	return typename detail::handle_ranges<_Node>::children_type(node);
+}
+
+template<typename _Node>
+typename detail::handle_ranges<_Node>::masked_children_type children(const _Node& node, unsigned int mask)
+{
+	return typename detail::handle_ranges<_Node>::masked_children_type(node, mask);
+}
+
+template<typename _Node>
+typename detail::handle_ranges<_Node>::masked_children_type elements(const _Node& node)
+{
+	return typename detail::handle_ranges<_Node>::masked_children_type(node, mask_element);
+}
+
+template<typename _Node>
+typename detail::handle_ranges<_Node>::attributes_type attributes(const _Node& node)
+{
+	return typename detail::handle_ranges<_Node>::attributes_type(node);
+}
+
+
+}
+
+
+
+#endif
@@ -7,8 +7,62 @@
 #include "error.hpp"
 
 
+#if defined(__GNUC__) || defined(__clang__)
+#	define RXML_PREFETCH(_addr)	__builtin_prefetch(static_cast<const void*>(_addr))
+#elif defined(_MSC_VER)
+#	include <xmmintrin.h>
+#	define RXML_PREFETCH(_addr)	_mm_prefetch(reinterpret_cast<const char*>(_addr), _MM_HINT_T0)
+#else
+#	define RXML_PREFETCH(_addr)	((void)0)
+#endif
+
+
 namespace rxml {
 
+
+// ########################################### prefetch policies ###########################################
+// called by node iterators with each node they moved to
+struct no_prefetch
+{
+	template<typename _Entity>
+	void operator ()(_Entity*) const
+	{
+	}
+};
+
+/*
+ * Prefetches the node after the next sibling and the name and value of the next sibling.
+ * Only the next sibling is read, which the step before prefetched, so a walk doing some work
+ * per node finds nodes and strings in the cache even if the pool is fragmented by edits.
+ * Walks doing next to nothing per node are bound by the chain of nodes and gain nothing.
+ */
+struct sibling_prefetch
+{
+	template<typename _Entity>
+	void operator ()(_Entity* entity) const
+	{
+		if(!entity)
+			return;
+		_Entity* next = entity->next_sibling();
+		if(!next)
+			return;
+
+		if(_Entity* after = next->next_sibling())
+			RXML_PREFETCH(after);
+		prefetch_strings(next);
+	}
+
+private:
+	// xml_node::value() would load deferred children (see lazy_document)
+	template<typename _Ch>
+	static void prefetch_strings(const rapidxml::xml_base<_Ch>* entity)
+	{
+		RXML_PREFETCH(entity->name());
+		RXML_PREFETCH(entity->value());
+	}
+};
+
+
 namespace detail {
 
 	
@@ -16,7 +70,8 @@ namespace detail {
 				typename _ValTy,	// type of value to access
 				typename _NextGet,	// type of function getting the next element
 				typename _Select,	// type of function selecting entity
-				typename _ValEx>	// type of function extracting the value
+				typename _ValEx,	// type of function extracting the value
+				typename _Prefetch = no_prefetch>	// type of policy prefetching ahead of the iterator
 	class forward_iterator_base
 	{
 	private:
@@ -24,6 +79,7 @@ namespace detail {
 		typedef _Select		_select_type;
 		typedef _NextGet	_nextget_type;
 		typedef _ValEx		_value_extractor;
+		typedef _Prefetch	_prefetch_type;
 	public:
 
 		typedef _ValTy			value_type;
@@ -35,6 +91,11 @@ namespace detail {
 			, m_value(entity)
 			, m_select(selector)
 		{
+			// move on to the first selected entity
+			if(!m_select(m_entitiy))
+				_next();
+			else
+				_prefetch_type()(m_entitiy);
 		}
 
 		forward_iterator_base(const forward_iterator_base& other)
@@ -91,6 +152,7 @@ namespace detail {
 				m_entitiy = next(m_entitiy);
 
 			} while(!m_select(m_entitiy));
+			_prefetch_type()(m_entitiy);
 			_set();
 		}
 
@@ -111,16 +173,17 @@ namespace detail {
 				typename _NextGet,	// type of function getting the next element
 				typename _PrevGet,	// type of function getting the prev element
 				typename _Select,	// type of function selecting entity
-				typename _ValEx>	// type of function extracting the value
+				typename _ValEx,	// type of function extracting the value
+				typename _Prefetch = no_prefetch>	// type of policy prefetching ahead of the iterator
 	class backward_iterator_base
-		: public forward_iterator_base<_EntTy, _ValTy, _NextGet, _Select, _ValEx>
+		: public forward_iterator_base<_EntTy, _ValTy, _NextGet, _Select, _ValEx, _Prefetch>
 	{
 	private:
 		typedef _EntTy		_entity_type;
 		typedef _PrevGet	_prevget_type;
 		typedef _Select		_select_type;
 	public:
-		typedef forward_iterator_base<_EntTy, _ValTy, _NextGet, _Select, _ValEx>	base_type;
+		typedef forward_iterator_base<_EntTy, _ValTy, _NextGet, _Select, _ValEx, _Prefetch>	base_type;
 		typedef typename base_type::value_type										value_type;
 		typedef typename base_type::reference										reference;
 		typedef typename base_type::pointer											pointer;
@@ -151,6 +214,33 @@ namespace detail {
 		}
 	};
 
+	// selectors have to accept nullptr, which marks the end of the sequence
+	template<typename _Entity>
+	struct element_selector
+	{
+		bool operator ()(_Entity* e)
+		{
+			return !e || e->type() == rapidxml::node_element;
+		}
+	};
+
+	template<typename _Entity>
+	struct node_type_selector
+	{
+		node_type_selector(unsigned int mask)
+			: m_mask(mask)
+		{
+		}
+
+		bool operator ()(_Entity* e)
+		{
+			return !e || (m_mask & (1u << e->type())) != 0;
+		}
+
+	private:
+		unsigned int m_mask;
+	};
+
 	template<typename _Entity>
 	struct trivial_ptr_value
 	{
@@ -219,7 +309,7 @@ namespace detail {
 #define RXML_END_SELECTOR()							};
 
 
-	template<typename _Entity>
+	template<typename _Entity, typename _Prefetch = no_prefetch>
 	RXML_BUILD_ITERATOR_SELECTOR(node_iterator_base, backward_iterator_base
 													<
 														_Entity*,
@@ -227,7 +317,8 @@ namespace detail {
 														trivial_next_node_getter<_Entity>,
 														trivial_prev_node_getter<_Entity>,
 														trivial_everything_selector<_Entity>,
-														trivial_ptr_value<_Entity>
+														trivial_ptr_value<_Entity>,
+														_Prefetch
 													>)
 		node_iterator_base(_Entity* entity)
 			: base_type(entity, trivial_everything_selector<_Entity>())
@@ -235,6 +326,22 @@ namespace detail {
 		}
 	RXML_END_SELECTOR();
 
+	template<typename _Entity, typename _Select>
+	RXML_BUILD_ITERATOR_SELECTOR(selected_node_iterator_base, backward_iterator_base
+													<
+														_Entity*,
+														_Entity,
+														trivial_next_node_getter<_Entity>,
+														trivial_prev_node_getter<_Entity>,
+														_Select,
+														trivial_ptr_value<_Entity>
+													>)
+		selected_node_iterator_base(_Entity* entity, const _Select& selector)
+			: base_type(entity, selector)
+		{
+		}
+	RXML_END_SELECTOR();
+
 	
 	template<typename _Entity>
 	RXML_BUILD_ITERATOR_SELECTOR(attr_iterator_base, backward_iterator_base
@@ -254,43 +361,132 @@ namespace detail {
 }
 
 
+// ########################################### node type masks ###########################################
+enum node_type_mask
+{
+	mask_document		= 1u << rapidxml::node_document,
+	mask_element		= 1u << rapidxml::node_element,
+	mask_data			= 1u << rapidxml::node_data,
+	mask_cdata			= 1u << rapidxml::node_cdata,
+	mask_comment		= 1u << rapidxml::node_comment,
+	mask_declaration	= 1u << rapidxml::node_declaration,
+	mask_doctype		= 1u << rapidxml::node_doctype,
+	mask_pi				= 1u << rapidxml::node_pi,
+
+	mask_text			= mask_data | mask_cdata,
+	mask_all			= ~0u
+};
+
+
 #define RXML_ADD_INC_TO_ITERATOR(_cls)	_cls& operator++()		{ this->_next(); return *this; }	\
 										_cls  operator++(int)	{ auto tmp = std::move(*this); this->_next(); return tmp; }
 #define RXML_ADD_DEC_TO_ITERATOR(_cls)	_cls& operator--()		{ this->_prev(); return *this; }	\
 										_cls  operator--(int)	{ auto tmp = std::move(*this); this->_prev(); return tmp; }
 
 // ########################################### node_iterator ###########################################
-template<typename _Ch = char>
+template<typename _Ch = char, typename _Prefetch = no_prefetch>
 class node_iterator
-	: public detail::node_iterator_base<rapidxml::xml_node<_Ch>>
+	: public detail::node_iterator_base<rapidxml::xml_node<_Ch>, _Prefetch>
 	, public std::iterator<std::bidirectional_iterator_tag, rapidxml::xml_node<_Ch>>
 {
 public:
-	typedef detail::node_iterator_base<rapidxml::xml_node<_Ch>> base_type;
+	typedef detail::node_iterator_base<rapidxml::xml_node<_Ch>, _Prefetch> base_type;
 
 	node_iterator() : base_type(nullptr) {}
 	node_iterator(rapidxml::xml_node<_Ch>* node) : base_type(node->first_node()) {}
 	node_iterator(rapidxml::xml_node<_Ch>& node) : base_type(node.first_node()) {}
 
-	RXML_ADD_INC_TO_ITERATOR(node_iterator<_Ch>);
-	RXML_ADD_DEC_TO_ITERATOR(node_iterator<_Ch>);
+	RXML_ADD_INC_TO_ITERATOR(node_iterator);
+	RXML_ADD_DEC_TO_ITERATOR(node_iterator);
 };
 
 // ########################################### const_node_iterator###########################################
-template<typename _Ch = char>
+template<typename _Ch = char, typename _Prefetch = no_prefetch>
 class const_node_iterator
-	: public detail::node_iterator_base<const rapidxml::xml_node<_Ch>>
+	: public detail::node_iterator_base<const rapidxml::xml_node<_Ch>, _Prefetch>
 	, public std::iterator<std::bidirectional_iterator_tag, const rapidxml::xml_node<_Ch>>
 {
 public:
-	typedef detail::node_iterator_base<const rapidxml::xml_node<_Ch>> base_type;
+	typedef detail::node_iterator_base<const rapidxml::xml_node<_Ch>, _Prefetch> base_type;
 
 	const_node_iterator() : base_type(nullptr) {}
 	const_node_iterator(const rapidxml::xml_node<_Ch>* node) : base_type(node->first_node()) {}
 	const_node_iterator(const rapidxml::xml_node<_Ch>& node) : base_type(node.first_node()) {}
 
-	RXML_ADD_INC_TO_ITERATOR(const_node_iterator<_Ch>);
-	RXML_ADD_DEC_TO_ITERATOR(const_node_iterator<_Ch>);
+	RXML_ADD_INC_TO_ITERATOR(const_node_iterator);
+	RXML_ADD_DEC_TO_ITERATOR(const_node_iterator);
+};
+
+// ########################################### element_iterator ###########################################
+template<typename _Ch = char>
+class element_iterator
+	: public detail::selected_node_iterator_base<rapidxml::xml_node<_Ch>, detail::element_selector<rapidxml::xml_node<_Ch>>>
+	, public std::iterator<std::bidirectional_iterator_tag, rapidxml::xml_node<_Ch>>
+{
+public:
+	typedef detail::element_selector<rapidxml::xml_node<_Ch>> selector_type;
+	typedef detail::selected_node_iterator_base<rapidxml::xml_node<_Ch>, selector_type> base_type;
+
+	element_iterator() : base_type(nullptr, selector_type()) {}
+	element_iterator(rapidxml::xml_node<_Ch>* node) : base_type(node->first_node(), selector_type()) {}
+	element_iterator(rapidxml::xml_node<_Ch>& node) : base_type(node.first_node(), selector_type()) {}
+
+	RXML_ADD_INC_TO_ITERATOR(element_iterator<_Ch>);
+	RXML_ADD_DEC_TO_ITERATOR(element_iterator<_Ch>);
+};
+
+// ########################################### const_element_iterator ###########################################
+template<typename _Ch = char>
+class const_element_iterator
+	: public detail::selected_node_iterator_base<const rapidxml::xml_node<_Ch>, detail::element_selector<const rapidxml::xml_node<_Ch>>>
+	, public std::iterator<std::bidirectional_iterator_tag, const rapidxml::xml_node<_Ch>>
+{
+public:
+	typedef detail::element_selector<const rapidxml::xml_node<_Ch>> selector_type;
+	typedef detail::selected_node_iterator_base<const rapidxml::xml_node<_Ch>, selector_type> base_type;
+
+	const_element_iterator() : base_type(nullptr, selector_type()) {}
+	const_element_iterator(const rapidxml::xml_node<_Ch>* node) : base_type(node->first_node(), selector_type()) {}
+	const_element_iterator(const rapidxml::xml_node<_Ch>& node) : base_type(node.first_node(), selector_type()) {}
+
+	RXML_ADD_INC_TO_ITERATOR(const_element_iterator<_Ch>);
+	RXML_ADD_DEC_TO_ITERATOR(const_element_iterator<_Ch>);
+};
+
+// ########################################### masked_node_iterator ###########################################
+template<typename _Ch = char>
+class masked_node_iterator
+	: public detail::selected_node_iterator_base<rapidxml::xml_node<_Ch>, detail::node_type_selector<rapidxml::xml_node<_Ch>>>
+	, public std::iterator<std::bidirectional_iterator_tag, rapidxml::xml_node<_Ch>>
+{
+public:
+	typedef detail::node_type_selector<rapidxml::xml_node<_Ch>> selector_type;
+	typedef detail::selected_node_iterator_base<rapidxml::xml_node<_Ch>, selector_type> base_type;
+
+	masked_node_iterator() : base_type(nullptr, selector_type(mask_all)) {}
+	masked_node_iterator(rapidxml::xml_node<_Ch>* node, unsigned int mask) : base_type(node->first_node(), selector_type(mask)) {}
+	masked_node_iterator(rapidxml::xml_node<_Ch>& node, unsigned int mask) : base_type(node.first_node(), selector_type(mask)) {}
+
+	RXML_ADD_INC_TO_ITERATOR(masked_node_iterator<_Ch>);
+	RXML_ADD_DEC_TO_ITERATOR(masked_node_iterator<_Ch>);
+};
+
+// ########################################### const_masked_node_iterator ###########################################
+template<typename _Ch = char>
+class const_masked_node_iterator
+	: public detail::selected_node_iterator_base<const rapidxml::xml_node<_Ch>, detail::node_type_selector<const rapidxml::xml_node<_Ch>>>
+	, public std::iterator<std::bidirectional_iterator_tag, const rapidxml::xml_node<_Ch>>
+{
+public:
+	typedef detail::node_type_selector<const rapidxml::xml_node<_Ch>> selector_type;
+	typedef detail::selected_node_iterator_base<const rapidxml::xml_node<_Ch>, selector_type> base_type;
+
+	const_masked_node_iterator() : base_type(nullptr, selector_type(mask_all)) {}
+	const_masked_node_iterator(const rapidxml::xml_node<_Ch>* node, unsigned int mask) : base_type(node->first_node(), selector_type(mask)) {}
+	const_masked_node_iterator(const rapidxml::xml_node<_Ch>& node, unsigned int mask) : base_type(node.first_node(), selector_type(mask)) {}
+
+	RXML_ADD_INC_TO_ITERATOR(const_masked_node_iterator<_Ch>);
+	RXML_ADD_DEC_TO_ITERATOR(const_masked_node_iterator<_Ch>);
 };
 
 // ########################################### attribute_iterator ###########################################
@@ -376,6 +572,34 @@ namespace detail
 	private:
 		_Entity const m_entity;
 	};
+
+	template<typename _Entity, typename Iter>
+	class masked_range_wrapper
+	{
+	public:
+		typedef Iter iterator_type;
+
+		masked_range_wrapper(_Entity entity, unsigned int mask)
+			: m_entity(entity)
+			, m_mask(mask)
+		{
+		}
+
+
+		iterator_type begin()
+		{
+			return iterator_type(m_entity, m_mask);
+		}
+
+		iterator_type end()
+		{
+			return iterator_type();
+		}
+
+	private:
+		_Entity const m_entity;
+		unsigned int const m_mask;
+	};
 }
 
 template<typename _Ch>
@@ -410,6 +634,102 @@ detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_node_iterator
 
 
 
+// children walked with sibling_prefetch, for long sibling lists with some work per node
+template<typename _Ch>
+detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, node_iterator<_Ch, sibling_prefetch>>
+	prefetch_children(rapidxml::xml_node<_Ch>* node)
+{
+	assert(node);
+	return detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, node_iterator<_Ch, sibling_prefetch>>(node);
+}
+
+template<typename _Ch>
+detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_node_iterator<_Ch, sibling_prefetch>>
+	prefetch_children(const rapidxml::xml_node<_Ch>* node)
+{
+	assert(node);
+	return detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_node_iterator<_Ch, sibling_prefetch>>(node);
+}
+
+template<typename _Ch>
+detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, node_iterator<_Ch, sibling_prefetch>>
+	prefetch_children(rapidxml::xml_node<_Ch>& node)
+{
+	return detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, node_iterator<_Ch, sibling_prefetch>>(&node);
+}
+
+template<typename _Ch>
+detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_node_iterator<_Ch, sibling_prefetch>>
+	prefetch_children(const rapidxml::xml_node<_Ch>& node)
+{
+	return detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_node_iterator<_Ch, sibling_prefetch>>(&node);
+}
+
+
+
+template<typename _Ch>
+detail::masked_range_wrapper<rapidxml::xml_node<_Ch>*, masked_node_iterator<_Ch>>
+	children(rapidxml::xml_node<_Ch>* node, unsigned int mask)
+{
+	assert(node);
+	return detail::masked_range_wrapper<rapidxml::xml_node<_Ch>*, masked_node_iterator<_Ch>>(node, mask);
+}
+
+template<typename _Ch>
+detail::masked_range_wrapper<const rapidxml::xml_node<_Ch>*, const_masked_node_iterator<_Ch>>
+	children(const rapidxml::xml_node<_Ch>* node, unsigned int mask)
+{
+	assert(node);
+	return detail::masked_range_wrapper<const rapidxml::xml_node<_Ch>*, const_masked_node_iterator<_Ch>>(node, mask);
+}
+
+template<typename _Ch>
+detail::masked_range_wrapper<rapidxml::xml_node<_Ch>*, masked_node_iterator<_Ch>>
+	children(rapidxml::xml_node<_Ch>& node, unsigned int mask)
+{
+	return detail::masked_range_wrapper<rapidxml::xml_node<_Ch>*, masked_node_iterator<_Ch>>(&node, mask);
+}
+
+template<typename _Ch>
+detail::masked_range_wrapper<const rapidxml::xml_node<_Ch>*, const_masked_node_iterator<_Ch>>
+	children(const rapidxml::xml_node<_Ch>& node, unsigned int mask)
+{
+	return detail::masked_range_wrapper<const rapidxml::xml_node<_Ch>*, const_masked_node_iterator<_Ch>>(&node, mask);
+}
+
+
+
+
+template<typename _Ch>
+detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, element_iterator<_Ch>>
+	elements(rapidxml::xml_node<_Ch>* node)
+{
+	assert(node);
+	return detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, element_iterator<_Ch>>(node);
+}
+
+template<typename _Ch>
+detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_element_iterator<_Ch>>
+	elements(const rapidxml::xml_node<_Ch>* node)
+{
+	assert(node);
+	return detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_element_iterator<_Ch>>(node);
+}
+
+template<typename _Ch>
+detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, element_iterator<_Ch>>
+	elements(rapidxml::xml_node<_Ch>& node)
+{
+	return detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, element_iterator<_Ch>>(&node);
+}
+
+template<typename _Ch>
+detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_element_iterator<_Ch>>
+	elements(const rapidxml::xml_node<_Ch>& node)
+{
+	return detail::simple_range_wrapper<const rapidxml::xml_node<_Ch>*, const_element_iterator<_Ch>>(&node);
+}
+
 
 template<typename _Ch>
 detail::simple_range_wrapper<rapidxml::xml_node<_Ch>*, attribute_iterator<_Ch>>
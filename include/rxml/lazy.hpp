@@ -0,0 +1,278 @@
+#pragma once
+#ifndef _RXML_LAZY_HPP
+#define _RXML_LAZY_HPP
+
+#include <rapidxml.hpp>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include "error.hpp"
+#include "scanner.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### lazy_document ###########################################
+/*
+ * Document parsing only the skeleton of the text up front.
+ *
+ * Elements down to the given depth (the root element has depth 0) are parsed with their start tags,
+ * attributes and closing tags. The content of the elements at that depth is only skipped by scanning for
+ * markup and parsed into the element the first time its children or its value are accessed: through
+ * first_node, last_node, value, the child manipulation functions and everything built on them
+ * (rxml::get, rxml::value, the iterators, printing).
+ *
+ * Deferred parsing is serialized by a mutex of the document, so any number of threads may read the
+ * document concurrently. Changing the document is no more thread-safe than with xml_document.
+ * The resulting tree equals the one of xml_document::parse with the same flags. Errors in deferred content
+ * are thrown as rapidxml::parse_error on the first access; the element stays empty afterwards.
+ *
+ * With rapidxml::parse_namespaces, deferred content is parsed with the declarations of its ancestors in scope.
+ * URIs first declared in deferred content join the table of the document when the content is loaded, so
+ * namespace_count() and find_namespace() may only be used concurrently once all content is loaded.
+ */
+template<typename _Ch = char>
+class lazy_document
+	: public rapidxml::xml_document<_Ch>
+{
+	typedef rapidxml::xml_document<_Ch> base_type;
+	typedef rapidxml::xml_node<_Ch> node_type;
+public:
+	explicit lazy_document(std::size_t depth = 1)
+		: m_depth(depth)
+		, m_end(nullptr)
+		, m_parse_content(nullptr)
+	{
+	}
+
+	template<int _Flags>
+	void parse(_Ch* text)
+	{
+		rxml_assert(text);
+
+		this->remove_all_nodes();
+		this->remove_all_attributes();
+		this->m_parse_flags = _Flags;
+		this->reset_namespaces();
+		m_deferred.clear();
+		m_end = text + rapidxml::internal::measure(text);
+		m_parse_content = &lazy_document::parse_deferred<_Flags>;
+
+		this->template parse_bom<_Flags>(text);
+
+		while(true)
+		{
+			this->template skip<typename base_type::whitespace_pred, _Flags>(text);
+			if(*text == 0)
+				break;
+
+			if(*text != _Ch('<'))
+				throw rapidxml::parse_error("expected <", text);
+			++text;
+
+			if(node_type* node = parse_skeleton_node<_Flags>(text, 0))
+				this->append_node(node);
+		}
+	}
+
+	void clear()
+	{
+		base_type::clear();
+		m_deferred.clear();
+	}
+
+	// depth of the elements whose content is deferred
+	std::size_t depth() const
+	{
+		return m_depth;
+	}
+
+	// number of elements with deferred content
+	std::size_t deferred_count() const
+	{
+		return m_deferred.size();
+	}
+
+	// number of elements whose deferred content was not parsed yet
+	std::size_t pending_count() const
+	{
+		std::size_t count = 0;
+		for(auto& content : m_deferred)
+		{
+			if(!content.loaded.load(std::memory_order_acquire))
+				++count;
+		}
+		return count;
+	}
+
+private:
+	struct deferred_content
+		: public rapidxml::xml_node_loader<_Ch>
+	{
+		deferred_content(lazy_document* document, _Ch* begin, typename base_type::namespace_binding* scope)
+			: document(document)
+			, begin(begin)
+			, scope(scope)
+			, loading(false)
+			, loaded(false)
+		{
+		}
+
+		virtual void load(node_type* node) override
+		{
+			if(!loaded.load(std::memory_order_acquire))
+				document->load(node, *this);
+		}
+
+		lazy_document* document;
+		_Ch* begin;				// first character after the start tag
+		typename base_type::namespace_binding* scope;	// bindings in scope of the content
+		bool loading;			// guarded by the mutex of the document
+		std::atomic<bool> loaded;
+	};
+
+	void load(node_type* node, deferred_content& content)
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+		// the parser itself touches the node while it is loaded
+		if(content.loading || content.loaded.load(std::memory_order_relaxed))
+			return;
+
+		content.loading = true;
+		typename base_type::namespace_binding* scope = this->m_namespace_scope;
+		this->m_namespace_scope = content.scope;
+		try
+		{
+			_Ch* text = content.begin;
+			(this->*m_parse_content)(text, node);
+		}catch(...)
+		{
+			this->m_namespace_scope = scope;
+			node->remove_all_nodes();
+			node->value(nullptr, 0);
+			content.loading = false;
+			content.loaded.store(true, std::memory_order_release);
+			throw;
+		}
+		this->m_namespace_scope = scope;
+		content.loading = false;
+		content.loaded.store(true, std::memory_order_release);
+	}
+
+	template<int _Flags>
+	void parse_deferred(_Ch*& text, node_type* node)
+	{
+		this->template parse_node_contents<_Flags>(text, node);
+	}
+
+	// text points after '<'; same as xml_document::parse_node, but elements use parse_skeleton_contents
+	template<int _Flags>
+	node_type* parse_skeleton_node(_Ch*& text, std::size_t depth)
+	{
+		if(*text == _Ch('?') || *text == _Ch('!'))
+			return this->template parse_node<_Flags>(text);
+
+		node_type* element = this->allocate_node(rapidxml::node_element);
+
+		_Ch* name = text;
+		this->template skip<typename base_type::node_name_pred, _Flags>(text);
+		if(text == name)
+			throw rapidxml::parse_error("expected element name", text);
+		element->name(name, text - name);
+
+		this->template skip<typename base_type::whitespace_pred, _Flags>(text);
+		this->template parse_node_attributes<_Flags>(text, element);
+
+		typename base_type::namespace_binding* scope = this->m_namespace_scope;
+		if(_Flags & rapidxml::parse_namespaces)
+			this->resolve_namespace(element);
+
+		if(*text == _Ch('>'))
+		{
+			++text;
+			if(depth < m_depth)
+				parse_skeleton_contents<_Flags>(text, element, depth);
+			else
+				defer_contents<_Flags>(text, element);
+		}else if(*text == _Ch('/'))
+		{
+			++text;
+			if(*text != _Ch('>'))
+				throw rapidxml::parse_error("expected >", text);
+			++text;
+		}else
+			throw rapidxml::parse_error("expected >", text);
+
+		if(!(_Flags & rapidxml::parse_no_string_terminators))
+			element->name()[element->name_size()] = _Ch('\0');
+		this->m_namespace_scope = scope;
+
+		return element;
+	}
+
+	// same as xml_document::parse_node_contents, but child elements use parse_skeleton_node
+	template<int _Flags>
+	void parse_skeleton_contents(_Ch*& text, node_type* element, std::size_t depth)
+	{
+		while(true)
+		{
+			_Ch* contents_start = text;
+			this->template skip<typename base_type::whitespace_pred, _Flags>(text);
+			_Ch next_char = *text;
+
+			// data may have overwritten the '<' behind it with a terminator
+			if(next_char != _Ch('<') && next_char != _Ch('\0'))
+				next_char = this->template parse_and_append_data<_Flags>(element, text, contents_start);
+
+			if(next_char == _Ch('\0'))
+				throw rapidxml::parse_error("unexpected end of data", text);
+
+			if(text[1] == _Ch('/'))
+			{
+				this->template parse_closing_tag<_Flags>(text, element);
+				return;
+			}
+
+			++text;
+			if(node_type* child = parse_skeleton_node<_Flags>(text, depth + 1))
+				element->append_node(child);
+		}
+	}
+
+	template<int _Flags>
+	void defer_contents(_Ch*& text, node_type* element)
+	{
+		_Ch* close = scan::skip_content(text, m_end);
+		if(!close)
+			throw rapidxml::parse_error("unexpected end of data", m_end);
+
+		// whitespace-only content produces no nodes
+		_Ch* p = text;
+		while(p < close && scan::is_whitespace(*p))
+			++p;
+
+		if(p < close)
+		{
+			m_deferred.emplace_back(this, text, this->m_namespace_scope);
+			element->loader(&m_deferred.back());
+		}
+
+		text = close;
+		this->template parse_closing_tag<_Flags>(text, element);
+	}
+
+	std::size_t m_depth;
+	_Ch* m_end;
+	void (lazy_document::*m_parse_content)(_Ch*&, node_type*);
+	std::deque<deferred_content> m_deferred;
+	std::recursive_mutex m_mutex;
+};
+
+
+}
+
+
+
+#endif
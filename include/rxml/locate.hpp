@@ -53,6 +53,18 @@ namespace detail {
 		}
 	};
 
+	// only defined for rapidxml entities, so other entity types (e.g. compact_entity) can overload locate
+	template<typename _Entity, bool = traits::is_rapidxml_type<_Entity>::value>
+	struct locate_result
+	{
+		typedef std::basic_string<typename traits::char_type<_Entity>::type> type;
+	};
+
+	template<typename _Entity>
+	struct locate_result<_Entity, false>
+	{
+	};
+
 	template<typename _Entity, typename _Ch>
 	std::basic_string<_Ch> locate_imple(const _Entity& entity)
 	{
@@ -126,13 +138,13 @@ std::vector<rapidxml::xml_node<_Ch>*> parents(rapidxml::xml_base<_Ch>* entity, b
 
 
 template<typename _Entity>
-std::basic_string<typename traits::char_type<_Entity>::type> locate(const _Entity& entity)
+typename detail::locate_result<_Entity>::type locate(const _Entity& entity)
 {
 	return detail::locate_imple<_Entity, typename traits::char_type<_Entity>::type>(entity);
 }
 
 template<typename _Entity>
-std::basic_string<typename traits::char_type<_Entity>::type> locate(const _Entity* entity)
+typename detail::locate_result<_Entity>::type locate(const _Entity* entity)
 {
 	if(entity)
 		return locate(*entity);
@@ -0,0 +1,254 @@
+#pragma once
+#ifndef _RXML_MAPPED_FILE_HPP
+#define _RXML_MAPPED_FILE_HPP
+
+#include <rapidxml.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#	include <fstream>
+#	define RXML_MAPPED_FILE_READ
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+
+namespace rxml {
+
+
+// ########################################### mapped_file ###########################################
+/*
+ * Drop-in replacement of rapidxml::file mapping the file instead of copying it.
+ *
+ * The file is mapped private and writable, so in-place parsing only touches copy-on-write pages of this
+ * process and never the file itself. The mapping lies at the beginning of an anonymous reservation that is
+ * at least one character longer than the file, so the text is always followed by a terminating zero:
+ * either in the zero filled tail of the last file page or in the anonymous page behind it.
+ *
+ * With map_read_only the file is mapped shared and read-only instead, so processes mapping the same file
+ * share its page cache pages. Such text can only be parsed with parse_non_destructive (see mapped_document).
+ *
+ * Where mapping is not available (windows) the file is read into memory like rapidxml::file does.
+ */
+template<typename _Ch = char>
+class mapped_file
+{
+public:
+	enum access_hint
+	{
+		access_normal,
+		access_sequential,	// read ahead aggressively and drop pages behind
+		access_random,		// no read ahead
+		access_willneed		// start reading the whole file right away
+	};
+
+	enum map_mode
+	{
+		map_private,		// writable copy-on-write pages
+		map_read_only		// shared read-only pages
+	};
+
+	explicit mapped_file(const char* filename, access_hint hint = access_sequential, map_mode mode = map_private)
+		: m_data(nullptr)
+		, m_size(0)
+		, m_mapped_size(0)
+	{
+		open(filename, hint, mode);
+	}
+
+	explicit mapped_file(const std::string& filename, access_hint hint = access_sequential, map_mode mode = map_private)
+		: m_data(nullptr)
+		, m_size(0)
+		, m_mapped_size(0)
+	{
+		open(filename.c_str(), hint, mode);
+	}
+
+	mapped_file(mapped_file&& other)
+		: m_data(other.m_data)
+		, m_size(other.m_size)
+		, m_mapped_size(other.m_mapped_size)
+#ifdef RXML_MAPPED_FILE_READ
+		, m_buffer(std::move(other.m_buffer))
+#endif
+	{
+		other.m_data = nullptr;
+		other.m_size = 0;
+		other.m_mapped_size = 0;
+	}
+
+	~mapped_file()
+	{
+		close();
+	}
+
+	// zero terminated file contents
+	_Ch* data()
+	{
+		return m_data;
+	}
+
+	const _Ch* data() const
+	{
+		return m_data;
+	}
+
+	// size of the contents in characters, including the terminating zero
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+private:
+	mapped_file(const mapped_file&);
+	mapped_file& operator =(const mapped_file&);
+
+#ifdef RXML_MAPPED_FILE_READ
+
+	void open(const char* filename, access_hint, map_mode)
+	{
+		std::basic_ifstream<_Ch> stream(filename, std::ios::binary);
+		if(!stream)
+			throw std::runtime_error(std::string("cannot open file ") + filename);
+		stream.unsetf(std::ios::skipws);
+
+		stream.seekg(0, std::ios::end);
+		std::size_t size = static_cast<std::size_t>(stream.tellg());
+		stream.seekg(0);
+
+		m_buffer.resize(size + 1);
+		stream.read(&m_buffer.front(), static_cast<std::streamsize>(size));
+		m_buffer[size] = _Ch('\0');
+
+		m_data = &m_buffer.front();
+		m_size = m_buffer.size();
+	}
+
+	void close()
+	{
+	}
+
+	std::vector<_Ch> m_buffer;
+
+#else
+
+	struct file_descriptor
+	{
+		explicit file_descriptor(int fd) : fd(fd) {}
+		~file_descriptor() { if(fd >= 0) ::close(fd); }
+		int fd;
+	};
+
+	void open(const char* filename, access_hint hint, map_mode mode)
+	{
+		file_descriptor file(::open(filename, O_RDONLY));
+		if(file.fd < 0)
+			throw std::runtime_error(std::string("cannot open file ") + filename);
+
+		struct stat info;
+		if(::fstat(file.fd, &info) != 0)
+			throw std::runtime_error(std::string("cannot stat file ") + filename);
+
+		const std::size_t file_size = static_cast<std::size_t>(info.st_size);
+		if(file_size % sizeof(_Ch))
+			throw std::runtime_error(std::string("file size is not a multiple of the character size ") + filename);
+
+		const std::size_t page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		m_mapped_size = (file_size + sizeof(_Ch) + page_size - 1) / page_size * page_size;
+
+		// reserve the whole range zero filled, then put the file over its beginning
+		const int protection = (mode == map_read_only)? PROT_READ : PROT_READ | PROT_WRITE;
+		void* base = ::mmap(nullptr, m_mapped_size, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(base == MAP_FAILED)
+			throw std::runtime_error(std::string("cannot map file ") + filename);
+		m_data = static_cast<_Ch*>(base);
+
+		if(file_size)
+		{
+			const int sharing = (mode == map_read_only)? MAP_SHARED : MAP_PRIVATE;
+			void* mapped = ::mmap(base, file_size, protection, sharing | MAP_FIXED, file.fd, 0);
+			if(mapped == MAP_FAILED)
+			{
+				close();
+				throw std::runtime_error(std::string("cannot map file ") + filename);
+			}
+
+			static const int advice[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED };
+			::madvise(base, file_size, advice[hint]);
+		}
+
+		m_size = file_size / sizeof(_Ch) + 1;
+	}
+
+	void close()
+	{
+		if(m_data)
+			::munmap(m_data, m_mapped_size);
+		m_data = nullptr;
+	}
+
+#endif
+
+	_Ch* m_data;
+	std::size_t m_size;
+	std::size_t m_mapped_size;
+};
+
+
+// ########################################### mapped_document ###########################################
+/*
+ * Document parsed straight from a read-only shared mapping of a file.
+ * Only non destructive parsing is possible: names and values point into the mapping, are not zero terminated
+ * and contain entities as they are in the file. Use the rxml accessors (value, get, ...) which handle both.
+ */
+template<typename _Ch = char>
+class mapped_document
+	: public rapidxml::xml_document<_Ch>
+{
+public:
+	typedef mapped_file<_Ch> file_type;
+
+	explicit mapped_document(const char* filename, typename file_type::access_hint hint = file_type::access_sequential)
+		: m_file(filename, hint, file_type::map_read_only)
+	{
+	}
+
+	explicit mapped_document(const std::string& filename, typename file_type::access_hint hint = file_type::access_sequential)
+		: m_file(filename, hint, file_type::map_read_only)
+	{
+	}
+
+	template<int _Flags>
+	void parse()
+	{
+		static_assert((_Flags & rapidxml::parse_non_destructive) == rapidxml::parse_non_destructive, "read-only text requires parse_non_destructive");
+		static_assert(!(_Flags & rapidxml::parse_normalize_whitespace), "parse_normalize_whitespace modifies the text");
+
+		rapidxml::xml_document<_Ch>::template parse<_Flags>(m_file.data());
+	}
+
+	void parse()
+	{
+		parse<rapidxml::parse_non_destructive>();
+	}
+
+	const file_type& file() const
+	{
+		return m_file;
+	}
+
+private:
+	file_type m_file;
+};
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,301 @@
+#pragma once
+#ifndef _RXML_PARALLEL_HPP
+#define _RXML_PARALLEL_HPP
+
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "error.hpp"
+#include "scanner.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### parallel_document ###########################################
+/*
+ * Document parsing the children of its root element on several threads.
+ *
+ * The prolog and the start tag of the root element are parsed as usual. Then the content of the root
+ * element is pre-scanned for child elements at chunk boundaries, which have to be preceded by whitespace.
+ * Every chunk is parsed into its own document (and thereby its own memory pool) on its own thread,
+ * and the resulting nodes are appended to the root element in order. Nodes of the chunks stay owned
+ * by this document until it is cleared, parsed again or destroyed.
+ *
+ * For well-formed input the tree equals the one of xml_document::parse. Root elements which contain
+ * non-whitespace text directly and documents smaller than two chunks are parsed sequentially.
+ *
+ * Chunk documents use the pool configuration of this document, so a configured arena must be thread-safe.
+ * The parser temporarily writes zero terminators at the chunk ends, even with parse_non_destructive.
+ * The original characters are restored before parse returns.
+ *
+ * With rapidxml::parse_namespaces, chunks are parsed with the declarations of the root element in scope,
+ * and URIs first declared in a chunk are added to the table of this document in chunk order, so the ids
+ * are the same as with xml_document::parse.
+ */
+template<typename _Ch = char>
+class parallel_document
+	: public rapidxml::xml_document<_Ch>
+{
+	typedef rapidxml::xml_document<_Ch> base_type;
+public:
+	static const std::size_t default_min_chunk_size = 1 << 20;
+
+	// threads = 0 uses one thread per hardware thread
+	explicit parallel_document(unsigned threads = 0, std::size_t min_chunk_size = default_min_chunk_size)
+		: m_threads(threads? threads : std::thread::hardware_concurrency())
+		, m_min_chunk_size(min_chunk_size? min_chunk_size : 1)
+	{
+		if(!m_threads)
+			m_threads = 1;
+	}
+
+	template<int _Flags>
+	void parse(_Ch* text)
+	{
+		rxml_assert(text);
+
+		this->remove_all_nodes();
+		this->remove_all_attributes();
+		this->m_parse_flags = _Flags;
+		this->reset_namespaces();
+		m_chunks.clear();
+
+		this->template parse_bom<_Flags>(text);
+
+		bool root_parsed = false;
+		while(true)
+		{
+			this->template skip<typename base_type::whitespace_pred, _Flags>(text);
+			if(*text == 0)
+				break;
+
+			if(*text != _Ch('<'))
+				throw rapidxml::parse_error("expected <", text);
+			++text;
+
+			if(!root_parsed && *text != _Ch('?') && *text != _Ch('!'))
+			{
+				root_parsed = true;
+				this->append_node(parse_root<_Flags>(text));
+			}else if(rapidxml::xml_node<_Ch>* node = this->template parse_node<_Flags>(text))
+			{
+				this->append_node(node);
+			}
+		}
+	}
+
+	void clear()
+	{
+		base_type::clear();
+		m_chunks.clear();
+	}
+
+	// number of chunks the root element was parsed in, 0 if it was parsed sequentially
+	std::size_t chunk_count() const
+	{
+		return m_chunks.size();
+	}
+
+	unsigned threads() const
+	{
+		return m_threads;
+	}
+
+private:
+	typedef typename base_type::namespace_binding namespace_binding;
+
+	// document of one chunk, parsed with the namespaces of the root element
+	class chunk_document
+		: public base_type
+	{
+	public:
+		template<int _Flags>
+		void parse(_Ch* text, const parallel_document& root)
+		{
+			this->m_parse_flags = _Flags;
+
+			// the table of the root is only read, the first URI added copies it into the pool of the chunk
+			this->m_namespaces = root.m_namespaces;
+			this->m_namespace_count = root.m_namespace_count;
+			this->m_namespace_capacity = root.m_namespace_count;
+			this->m_namespace_scope = root.m_namespace_scope;
+
+			while(true)
+			{
+				this->template skip<typename base_type::whitespace_pred, _Flags>(text);
+				if(*text == 0)
+					break;
+
+				if(*text != _Ch('<'))
+					throw rapidxml::parse_error("expected <", text);
+				++text;
+
+				if(rapidxml::xml_node<_Ch>* node = this->template parse_node<_Flags>(text))
+					this->append_node(node);
+			}
+		}
+	};
+
+	// same as xml_document::parse_element, but with parallel content parsing
+	template<int _Flags>
+	rapidxml::xml_node<_Ch>* parse_root(_Ch*& text)
+	{
+		rapidxml::xml_node<_Ch>* element = this->allocate_node(rapidxml::node_element);
+
+		_Ch* name = text;
+		this->template skip<typename base_type::node_name_pred, _Flags>(text);
+		if(text == name)
+			throw rapidxml::parse_error("expected element name", text);
+		element->name(name, text - name);
+
+		this->template skip<typename base_type::whitespace_pred, _Flags>(text);
+		this->template parse_node_attributes<_Flags>(text, element);
+
+		namespace_binding* scope = this->m_namespace_scope;
+		if(_Flags & rapidxml::parse_namespaces)
+			this->resolve_namespace(element);
+
+		if(*text == _Ch('>'))
+		{
+			++text;
+			parse_root_contents<_Flags>(text, element);
+		}else if(*text == _Ch('/'))
+		{
+			++text;
+			if(*text != _Ch('>'))
+				throw rapidxml::parse_error("expected >", text);
+			++text;
+		}else
+			throw rapidxml::parse_error("expected >", text);
+
+		if(!(_Flags & rapidxml::parse_no_string_terminators))
+			element->name()[element->name_size()] = _Ch('\0');
+		this->m_namespace_scope = scope;
+
+		return element;
+	}
+
+	template<int _Flags>
+	void parse_root_contents(_Ch*& text, rapidxml::xml_node<_Ch>* element)
+	{
+		_Ch* limit = text + rapidxml::internal::measure(text);
+		const std::size_t size = limit - text;
+		const std::size_t step = std::max(m_min_chunk_size, size / m_threads);
+
+		scan::content_layout<_Ch> layout;
+		if(m_threads < 2 || size < 2 * m_min_chunk_size || !scan::scan_content(text, limit, step, layout) || layout.splits.empty())
+		{
+			this->template parse_node_contents<_Flags>(text, element);
+			return;
+		}
+
+		std::vector<_Ch*> bounds;
+		bounds.push_back(text);
+		bounds.insert(bounds.end(), layout.splits.begin(), layout.splits.end());
+		bounds.push_back(layout.end);
+
+		// terminate every chunk; all but the last one end with the whitespace in front of the next split
+		const std::size_t count = bounds.size() - 1;
+		std::vector<_Ch> saved(count);
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			_Ch* end = (i + 1 < count)? bounds[i + 1] - 1 : layout.end;
+			saved[i] = *end;
+			*end = _Ch('\0');
+		}
+
+		// chunks allocate their blocks like this document does
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			m_chunks.push_back(std::unique_ptr<chunk_document>(new chunk_document()));
+			m_chunks.back()->configure(this->config());
+		}
+
+		std::vector<std::exception_ptr> errors(count);
+		auto parse_chunk = [&](std::size_t i)
+			{
+				try
+				{
+					m_chunks[i]->template parse<_Flags>(bounds[i], *this);
+				}catch(...)
+				{
+					errors[i] = std::current_exception();
+				}
+			};
+
+		std::vector<std::thread> workers;
+		for(std::size_t i = 1; i < count; ++i)
+		{
+			try
+			{
+				workers.push_back(std::thread(parse_chunk, i));
+			}catch(const std::system_error&)
+			{
+				parse_chunk(i);
+			}
+		}
+		parse_chunk(0);
+
+		for(auto& worker : workers)
+			worker.join();
+
+		for(std::size_t i = 0; i < count; ++i)
+			*((i + 1 < count)? bounds[i + 1] - 1 : layout.end) = saved[i];
+
+		for(auto& error : errors)
+		{
+			if(error)
+				std::rethrow_exception(error);
+		}
+
+		// URIs first declared in a chunk get ids of this document
+		const unsigned known = this->m_namespace_count;
+		for(auto& chunk : m_chunks)
+		{
+			std::vector<unsigned> ids;
+			for(unsigned id = known + 1; id <= chunk->namespace_count(); ++id)
+				ids.push_back(this->intern_namespace(chunk->namespace_uri(id), chunk->namespace_uri_size(id)));
+			if(!ids.empty())
+				renumber_namespaces(chunk.get(), known, ids);
+		}
+
+		for(auto& chunk : m_chunks)
+		{
+			while(rapidxml::xml_node<_Ch>* child = chunk->first_node())
+			{
+				chunk->remove_first_node();
+				element->append_node(child);
+			}
+		}
+
+		// parses the closing tag
+		text = layout.end;
+		this->template parse_node_contents<_Flags>(text, element);
+	}
+
+	static void renumber_namespaces(rapidxml::xml_node<_Ch>* node, unsigned known, const std::vector<unsigned>& ids)
+	{
+		for(rapidxml::xml_node<_Ch>* child = node->first_node(); child; child = child->next_sibling())
+		{
+			if(child->namespace_id() > known)
+				child->namespace_id(ids[child->namespace_id() - known - 1]);
+			renumber_namespaces(child, known, ids);
+		}
+	}
+
+	unsigned m_threads;
+	std::size_t m_min_chunk_size;
+	std::vector<std::unique_ptr<chunk_document>> m_chunks;
+};
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,292 @@
+#pragma once
+#ifndef _RXML_PROJECTION_HPP
+#define _RXML_PROJECTION_HPP
+
+#include <rapidxml.hpp>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include "error.hpp"
+#include "scanner.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### projection ###########################################
+/*
+ * Set of rxml paths compiled into a trie of element names.
+ * A node path ("config/db") requests the element with its whole subtree, an attribute path
+ * ("config/log:level") requests only the element with its attributes. Paths are relative to the
+ * document, a leading '/' is ignored. ".." is not supported.
+ */
+template<typename _Ch = char>
+class projection
+{
+public:
+	static const std::size_t npos = static_cast<std::size_t>(-1);
+
+	projection()
+		: m_nodes(1)
+	{
+	}
+
+	template<typename _It>
+	projection(_It first, _It last)
+		: m_nodes(1)
+	{
+		for(; first != last; ++first)
+			add(*first);
+	}
+
+	projection(std::initializer_list<std::basic_string<_Ch>> paths)
+		: m_nodes(1)
+	{
+		for(auto& path : paths)
+			add(path);
+	}
+
+	void add(const _Ch* path, std::size_t path_size = 0)
+	{
+		if(!path_size)
+			path_size = rapidxml::internal::measure(path);
+
+		const _Ch* end = path + path_size;
+		std::size_t node = 0;
+		bool attribute = false;
+
+		while(path < end && !attribute)
+		{
+			const _Ch* p = path;
+			for(; p < end && *p != _Ch('/') && *p != _Ch(':'); ++p);
+			attribute = p < end && *p == _Ch(':');
+
+			if(p != path)
+			{
+				rxml_assert(!(p == path + 2 && path[0] == _Ch('.') && path[1] == _Ch('.')));
+				node = insert(node, path, p - path);
+			}
+			path = p + 1;
+		}
+
+		if(!attribute)
+			m_nodes[node].whole = true;
+	}
+
+	void add(const std::basic_string<_Ch>& path)
+	{
+		add(path.c_str(), path.size());
+	}
+
+	std::size_t root() const
+	{
+		return 0;
+	}
+
+	// index of the child element of node with the given name or npos if it is not requested
+	std::size_t child(std::size_t node, const _Ch* name, std::size_t name_size) const
+	{
+		for(std::size_t child : m_nodes[node].children)
+		{
+			const std::basic_string<_Ch>& child_name = m_nodes[child].name;
+			if(rapidxml::internal::compare(child_name.data(), child_name.size(), name, name_size, true))
+				return child;
+		}
+		return npos;
+	}
+
+	// true if the whole subtree of node is requested
+	bool whole(std::size_t node) const
+	{
+		return m_nodes[node].whole;
+	}
+
+private:
+	struct trie_node
+	{
+		trie_node()
+			: whole(false)
+		{
+		}
+
+		std::basic_string<_Ch> name;
+		std::vector<std::size_t> children;
+		bool whole;
+	};
+
+	std::size_t insert(std::size_t node, const _Ch* name, std::size_t name_size)
+	{
+		std::size_t found = child(node, name, name_size);
+		if(found != npos)
+			return found;
+
+		m_nodes.push_back(trie_node());
+		m_nodes.back().name.assign(name, name_size);
+		m_nodes[node].children.push_back(m_nodes.size() - 1);
+		return m_nodes.size() - 1;
+	}
+
+	std::vector<trie_node> m_nodes;
+};
+
+
+// ########################################### projected_document ###########################################
+/*
+ * Document building nodes only for the elements requested by a projection.
+ *
+ * Requested subtrees are parsed by the regular parser. Elements on the way to them get their
+ * attributes but no data, comments or other children. Everything else is skipped by scanning for
+ * markup without allocating nodes, and without the validation the parser would do.
+ * All elements matching a path are kept, not only the first one.
+ */
+template<typename _Ch = char>
+class projected_document
+	: public rapidxml::xml_document<_Ch>
+{
+	typedef rapidxml::xml_document<_Ch> base_type;
+	typedef rapidxml::xml_node<_Ch> node_type;
+public:
+	typedef projection<_Ch> projection_type;
+
+	projected_document()
+		: m_end(nullptr)
+	{
+	}
+
+	template<int _Flags>
+	void parse_projected(_Ch* text, const projection_type& paths)
+	{
+		rxml_assert(text);
+
+		if(paths.whole(paths.root()))
+		{
+			this->template parse<_Flags>(text);
+			return;
+		}
+
+		this->remove_all_nodes();
+		this->remove_all_attributes();
+		this->reset_namespaces();
+		this->m_parse_flags = _Flags;
+		m_end = text + rapidxml::internal::measure(text);
+
+		this->template parse_bom<_Flags>(text);
+		parse_projected_contents<_Flags>(text, this, paths, paths.root());
+	}
+
+	template<int _Flags, typename _Paths>
+	void parse_projected(_Ch* text, const _Paths& paths)
+	{
+		parse_projected<_Flags>(text, projection_type(paths.begin(), paths.end()));
+	}
+
+	template<int _Flags>
+	void parse_projected(_Ch* text, std::initializer_list<std::basic_string<_Ch>> paths)
+	{
+		parse_projected<_Flags>(text, projection_type(paths));
+	}
+
+private:
+	// same as xml_document::parse_element, but only with requested children
+	template<int _Flags>
+	node_type* parse_path_element(_Ch*& text, const projection_type& paths, std::size_t trie_node)
+	{
+		node_type* element = this->allocate_node(rapidxml::node_element);
+
+		_Ch* name = text;
+		this->template skip<typename base_type::node_name_pred, _Flags>(text);
+		if(text == name)
+			throw rapidxml::parse_error("expected element name", text);
+		element->name(name, text - name);
+
+		this->template skip<typename base_type::whitespace_pred, _Flags>(text);
+		this->template parse_node_attributes<_Flags>(text, element);
+
+		typename base_type::namespace_binding* scope = this->m_namespace_scope;
+		if(_Flags & rapidxml::parse_namespaces)
+			this->resolve_namespace(element);
+
+		if(*text == _Ch('>'))
+		{
+			++text;
+			parse_projected_contents<_Flags>(text, element, paths, trie_node);
+		}else if(*text == _Ch('/'))
+		{
+			++text;
+			if(*text != _Ch('>'))
+				throw rapidxml::parse_error("expected >", text);
+			++text;
+		}else
+			throw rapidxml::parse_error("expected >", text);
+
+		if(!(_Flags & rapidxml::parse_no_string_terminators))
+			element->name()[element->name_size()] = _Ch('\0');
+		this->m_namespace_scope = scope;
+
+		return element;
+	}
+
+	// parses the requested children of node up to its closing tag, or of the document up to the end
+	template<int _Flags>
+	void parse_projected_contents(_Ch*& text, node_type* node, const projection_type& paths, std::size_t trie_node)
+	{
+		const bool document = node == this;
+
+		while(true)
+		{
+			text = scan::find(text, m_end, _Ch('<'));
+			if(!text)
+			{
+				if(!document)
+					throw rapidxml::parse_error("unexpected end of data", m_end);
+				text = m_end;
+				return;
+			}
+
+			if(text[1] == _Ch('/'))
+			{
+				if(document)
+					throw rapidxml::parse_error("unexpected closing tag", text);
+				this->template parse_closing_tag<_Flags>(text, node);
+				return;
+			}
+
+			if(text[1] == _Ch('?') || text[1] == _Ch('!'))
+			{
+				int depth_change;
+				text = scan::skip_markup(text, m_end, depth_change);
+				if(!text)
+					throw rapidxml::parse_error("unexpected end of data", m_end);
+				continue;
+			}
+
+			_Ch* name = text + 1;
+			_Ch* name_end = name;
+			this->template skip<typename base_type::node_name_pred, _Flags>(name_end);
+
+			const std::size_t child = paths.child(trie_node, name, name_end - name);
+			if(child == projection_type::npos)
+			{
+				text = scan::skip_element(text, m_end);
+				if(!text)
+					throw rapidxml::parse_error("unexpected end of data", m_end);
+				continue;
+			}
+
+			++text;
+			if(paths.whole(child))
+				node->append_node(this->template parse_element<_Flags>(text));
+			else
+				node->append_node(parse_path_element<_Flags>(text, paths, child));
+		}
+	}
+
+	_Ch* m_end;
+};
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,386 @@
+#pragma once
+#ifndef _RXML_READER_HPP
+#define _RXML_READER_HPP
+
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "error.hpp"
+#include "entities.hpp"
+#include "scanner.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### reader_attribute ###########################################
+template<typename _Ch = char>
+class reader_attribute
+{
+public:
+	reader_attribute(const _Ch* name, std::size_t name_size, const _Ch* value, std::size_t value_size)
+		: m_name(name)
+		, m_name_size(name_size)
+		, m_value(value)
+		, m_value_size(value_size)
+	{
+	}
+
+	const _Ch* name() const				{ return m_name; }
+	std::size_t name_size() const		{ return m_name_size; }
+	const _Ch* raw_value() const		{ return m_value; }
+	std::size_t raw_value_size() const	{ return m_value_size; }
+
+	// value with entities decoded
+	std::basic_string<_Ch> value() const
+	{
+		return decode_entities(m_value, m_value_size);
+	}
+
+private:
+	const _Ch* m_name;
+	std::size_t m_name_size;
+	const _Ch* m_value;
+	std::size_t m_value_size;
+};
+
+
+// ########################################### reader ###########################################
+/*
+ * Pull parser moving a cursor token by token over a zero terminated text.
+ *
+ * The text is never modified and no nodes are allocated. Names and values point into the text
+ * and are not zero terminated; value() decodes entities on request.
+ * Like the dom, the reader drops whitespace-only text, comments, processing instructions and doctypes.
+ * Empty elements produce a start and an end token.
+ *
+ * skip() jumps over the content of the current element by scanning for markup only,
+ * materialize() parses the current element into a document, so a dom can be built for just the
+ * elements of interest.
+ */
+template<typename _Ch = char>
+class reader
+{
+	typedef rapidxml::internal::lookup_tables<0> tables;
+public:
+	typedef reader_attribute<_Ch> attribute_type;
+
+	enum token_type
+	{
+		token_none,
+		token_start_element,
+		token_end_element,
+		token_text,
+		token_cdata
+	};
+
+	// text must be zero terminated and outlive the reader
+	explicit reader(const _Ch* text)
+		: m_pos(text)
+		, m_end(text + rapidxml::internal::measure(text))
+		, m_token(text)
+		, m_type(token_none)
+		, m_empty(false)
+		, m_depth(0)
+		, m_name(nullptr)
+		, m_name_size(0)
+		, m_value(nullptr)
+		, m_value_size(0)
+	{
+		rxml_assert(text);
+
+		// skip utf-8 bom
+		if(m_end - m_pos >= 3 && index(m_pos[0]) == 0xEF && index(m_pos[1]) == 0xBB && index(m_pos[2]) == 0xBF)
+			m_pos += 3;
+	}
+
+	// advances to the next token, returns false at the end of the document
+	bool next()
+	{
+		m_attributes.clear();
+		m_value = nullptr;
+		m_value_size = 0;
+
+		if(m_type == token_start_element && m_empty)
+		{
+			m_type = token_end_element;
+			m_empty = false;
+			return true;
+		}
+
+		while(m_pos < m_end)
+		{
+			m_token = m_pos;
+
+			if(*m_pos != _Ch('<'))
+			{
+				if(read_text())
+					return true;
+				continue;
+			}
+
+			if(m_pos[1] == _Ch('/'))
+			{
+				read_end_tag();
+				return true;
+			}
+
+			if(m_pos[1] == _Ch('!') && scan::skip_past(m_pos, m_pos + std::min<std::size_t>(9, m_end - m_pos), "<![CDATA["))
+			{
+				const _Ch* end = scan::skip_past(m_pos + 9, m_end, "]]>");
+				if(!end)
+					error("unexpected end of data", m_end);
+				set_token(token_cdata, nullptr, 0);
+				m_value = m_pos + 9;
+				m_value_size = end - 3 - m_value;
+				m_pos = end;
+				return true;
+			}
+
+			if(m_pos[1] == _Ch('!') || m_pos[1] == _Ch('?'))
+			{
+				int depth_change;
+				m_pos = scan::skip_markup(m_pos, m_end, depth_change);
+				if(!m_pos)
+					error("unexpected end of data", m_end);
+				continue;
+			}
+
+			read_start_tag();
+			return true;
+		}
+
+		if(!m_stack.empty())
+			error("unexpected end of data", m_end);
+		m_type = token_none;
+		m_name = nullptr;
+		m_name_size = 0;
+		return false;
+	}
+
+	// moves the cursor from a start tag to its end tag without looking at the content
+	void skip()
+	{
+		if(m_type != token_start_element)
+			return;
+
+		if(!m_empty)
+		{
+			const _Ch* close = scan::skip_content(m_pos, m_end);
+			if(!close)
+				error("unexpected end of data", m_end);
+			m_pos = close;
+		}
+		next();
+	}
+
+	// parses the current element with its content into doc, replacing the contents of doc,
+	// and moves the cursor to the end tag; the text of the element is copied into the pool of doc
+	template<int _Flags>
+	rapidxml::xml_node<_Ch>* materialize(rapidxml::xml_document<_Ch>& doc)
+	{
+		rxml_assert(m_type == token_start_element);
+
+		const _Ch* begin = m_token;
+		skip();
+
+		const std::size_t size = m_pos - begin;
+		_Ch* copy = doc.allocate_string(nullptr, size + 1);
+		std::copy(begin, m_pos, copy);
+		copy[size] = _Ch('\0');
+
+		doc.template parse<_Flags>(copy);
+		return doc.first_node();
+	}
+
+	token_type type() const					{ return m_type; }
+
+	// number of enclosing elements
+	std::size_t depth() const				{ return m_depth; }
+
+	// element name of start and end tags
+	const _Ch* name() const					{ return m_name; }
+	std::size_t name_size() const			{ return m_name_size; }
+
+	// text and cdata as they are in the document
+	const _Ch* raw_value() const			{ return m_value; }
+	std::size_t raw_value_size() const		{ return m_value_size; }
+
+	// text with entities decoded, cdata as it is
+	std::basic_string<_Ch> value() const
+	{
+		if(m_type == token_text)
+			return decode_entities(m_value, m_value_size);
+		return std::basic_string<_Ch>(m_value, m_value_size);
+	}
+
+	// attributes of the current start tag
+	const std::vector<attribute_type>& attributes() const
+	{
+		return m_attributes;
+	}
+
+	const attribute_type* attribute(const _Ch* name, std::size_t name_size = 0) const
+	{
+		if(!name_size)
+			name_size = rapidxml::internal::measure(name);
+
+		for(auto& attr : m_attributes)
+		{
+			if(rapidxml::internal::compare(attr.name(), attr.name_size(), name, name_size, true))
+				return &attr;
+		}
+		return nullptr;
+	}
+
+	// position of the current token in the text
+	const _Ch* where() const
+	{
+		return m_token;
+	}
+
+private:
+	static unsigned char index(_Ch ch)
+	{
+		return static_cast<unsigned char>(ch);
+	}
+
+	void error(const char* what, const _Ch* where) const
+	{
+		throw rapidxml::parse_error(what, const_cast<_Ch*>(where));
+	}
+
+	void set_token(token_type type, const _Ch* name, std::size_t name_size)
+	{
+		m_type = type;
+		m_name = name;
+		m_name_size = name_size;
+		m_depth = m_stack.size();
+	}
+
+	void skip_whitespace()
+	{
+		while(tables::lookup_whitespace[index(*m_pos)])
+			++m_pos;
+	}
+
+	// returns false for whitespace-only text
+	bool read_text()
+	{
+		const _Ch* begin = m_pos;
+		bool blank = true;
+		for(; tables::lookup_text[index(*m_pos)]; ++m_pos)
+			blank = blank && tables::lookup_whitespace[index(*m_pos)];
+
+		if(m_pos < m_end && *m_pos != _Ch('<'))
+			error("unexpected zero character", m_pos);
+		if(blank)
+			return false;
+		if(m_stack.empty())
+			error("expected <", begin);
+
+		set_token(token_text, nullptr, 0);
+		m_value = begin;
+		m_value_size = m_pos - begin;
+		return true;
+	}
+
+	void read_start_tag()
+	{
+		++m_pos;
+		const _Ch* name = m_pos;
+		while(tables::lookup_node_name[index(*m_pos)])
+			++m_pos;
+		if(m_pos == name)
+			error("expected element name", m_pos);
+		set_token(token_start_element, name, m_pos - name);
+
+		while(true)
+		{
+			skip_whitespace();
+
+			const _Ch* attr_name = m_pos;
+			while(tables::lookup_attribute_name[index(*m_pos)])
+				++m_pos;
+			if(m_pos == attr_name)
+				break;
+			const _Ch* attr_name_end = m_pos;
+
+			skip_whitespace();
+			if(*m_pos != _Ch('='))
+				error("expected =", m_pos);
+			++m_pos;
+			skip_whitespace();
+
+			const _Ch quote = *m_pos;
+			if(quote != _Ch('\'') && quote != _Ch('"'))
+				error("expected ' or \"", m_pos);
+			const _Ch* value = ++m_pos;
+			while(*m_pos && *m_pos != quote)
+				++m_pos;
+			if(*m_pos != quote)
+				error("expected ' or \"", m_pos);
+
+			m_attributes.push_back(attribute_type(attr_name, attr_name_end - attr_name, value, m_pos - value));
+			++m_pos;
+		}
+
+		if(*m_pos == _Ch('/'))
+		{
+			++m_pos;
+			m_empty = true;
+		}else
+		{
+			m_empty = false;
+			m_stack.push_back(std::make_pair(m_name, m_name_size));
+		}
+
+		if(*m_pos != _Ch('>'))
+			error("expected >", m_pos);
+		++m_pos;
+	}
+
+	void read_end_tag()
+	{
+		m_pos += 2;
+		const _Ch* name = m_pos;
+		while(tables::lookup_node_name[index(*m_pos)])
+			++m_pos;
+		const std::size_t name_size = m_pos - name;
+
+		skip_whitespace();
+		if(*m_pos != _Ch('>'))
+			error("expected >", m_pos);
+		++m_pos;
+
+		if(m_stack.empty())
+			error("unexpected closing tag", name);
+		if(!rapidxml::internal::compare(m_stack.back().first, m_stack.back().second, name, name_size, true))
+			error("invalid closing tag name", name);
+
+		m_stack.pop_back();
+		set_token(token_end_element, name, name_size);
+	}
+
+	const _Ch* m_pos;
+	const _Ch* m_end;
+	const _Ch* m_token;
+	token_type m_type;
+	bool m_empty;
+	std::size_t m_depth;
+	const _Ch* m_name;
+	std::size_t m_name_size;
+	const _Ch* m_value;
+	std::size_t m_value_size;
+	std::vector<attribute_type> m_attributes;
+	std::vector<std::pair<const _Ch*, std::size_t>> m_stack;
+};
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,452 @@
+#pragma once
+#ifndef _RXML_SAX_HPP
+#define _RXML_SAX_HPP
+
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "entities.hpp"
+#include "scanner.hpp"
+
+
+namespace rxml {
+
+
+class sax_error
+	: public std::runtime_error
+{
+public:
+	sax_error(const std::string& _what, std::size_t _offset)
+		: std::runtime_error(_what)
+		, m_offset(_offset)
+	{
+	}
+
+	// position of the error in the fed stream
+	std::size_t offset() const
+	{
+		return m_offset;
+	}
+
+private:
+	std::size_t m_offset;
+};
+
+
+// ########################################### sax_handler ###########################################
+/*
+ * Handler ignoring all events. Derive from it and hide the events of interest.
+ * Strings passed to the events are only valid during the call and are not zero terminated.
+ */
+template<typename _Ch = char>
+struct sax_handler
+{
+	void start_element(const _Ch* name, std::size_t name_size) {}
+	void attribute(const _Ch* name, std::size_t name_size, const _Ch* value, std::size_t value_size) {}
+	void text(const _Ch* text, std::size_t text_size) {}
+	void end_element(const _Ch* name, std::size_t name_size) {}
+};
+
+
+// ########################################### sax_parser ###########################################
+/*
+ * Streaming parser emitting events instead of building a dom.
+ *
+ * Input is passed in chunks of any size with feed() and completed with finish(). Events are emitted as soon
+ * as their token is complete: start_element, one attribute event per attribute (entities decoded),
+ * end_element (also for empty elements), and text. Text, including cdata sections and whitespace between
+ * elements, is emitted as it arrives, so one text run may be split into several events at chunk
+ * boundaries and around entities. Comments, processing instructions and doctypes are skipped.
+ *
+ * Only the names of the open elements and the token straddling the current chunk boundary are kept,
+ * so memory is bounded by the nesting depth as long as single tags are of reasonable size.
+ * Closing tags are always validated.
+ */
+template<typename _Handler, typename _Ch = char>
+class sax_parser
+{
+	typedef rapidxml::internal::lookup_tables<0> tables;
+public:
+	// longest entity reference that is decoded; longer ones are emitted verbatim
+	static const std::size_t max_entity_size = 16;
+
+	explicit sax_parser(_Handler& handler)
+		: m_handler(handler)
+	{
+		reset();
+	}
+
+	void feed(const _Ch* data, std::size_t size)
+	{
+		while(size)
+		{
+			if(m_buffer.empty())
+			{
+				std::size_t used = consume(data, data + size, false);
+				m_buffer.assign(data + used, data + size);
+				return;
+			}
+
+			// complete the pending token with as few input as possible, so large chunks are not copied
+			std::size_t piece = std::min(size, std::max<std::size_t>(256, m_buffer.size()));
+			m_buffer.insert(m_buffer.end(), data, data + piece);
+			data += piece;
+			size -= piece;
+
+			std::size_t used = consume(&m_buffer.front(), &m_buffer.front() + m_buffer.size(), false);
+			m_buffer.erase(m_buffer.begin(), m_buffer.begin() + used);
+		}
+	}
+
+	void feed(const std::basic_string<_Ch>& data)
+	{
+		feed(data.data(), data.size());
+	}
+
+	// throws if the stream ended inside a token or an element
+	void finish()
+	{
+		if(!m_buffer.empty())
+		{
+			std::size_t used = consume(&m_buffer.front(), &m_buffer.front() + m_buffer.size(), true);
+			m_buffer.erase(m_buffer.begin(), m_buffer.begin() + used);
+		}
+
+		if(m_state != in_content || depth())
+			throw sax_error("unexpected end of data", m_consumed);
+	}
+
+	void reset()
+	{
+		m_state = in_content;
+		m_brackets = 0;
+		m_consumed = 0;
+		m_base = nullptr;
+		m_buffer.clear();
+		m_names.clear();
+		m_name_offsets.clear();
+	}
+
+	std::size_t depth() const
+	{
+		return m_name_offsets.size();
+	}
+
+	// number of characters processed so far
+	std::size_t offset() const
+	{
+		return m_consumed;
+	}
+
+private:
+	enum state
+	{
+		in_content,
+		in_comment,
+		in_cdata,
+		in_pi,
+		in_declaration
+	};
+
+	static unsigned char index(_Ch ch)
+	{
+		return static_cast<unsigned char>(ch);
+	}
+
+	void error(const char* what, const _Ch* where) const
+	{
+		throw sax_error(what, m_consumed + (where - m_base));
+	}
+
+	// returns nullptr to wait for more input
+	const _Ch* more(bool final, const _Ch* where) const
+	{
+		if(final)
+			error("unexpected end of data", where);
+		return nullptr;
+	}
+
+	// returns 1 if text starts with seq, 0 if it does not and -1 if it is too short to decide
+	static int starts_with(const _Ch* text, const _Ch* end, const char* seq)
+	{
+		for(; *seq; ++seq, ++text)
+		{
+			if(text == end)
+				return -1;
+			if(*text != _Ch(*seq))
+				return 0;
+		}
+		return 1;
+	}
+
+	// processes as many complete tokens as possible and returns the number of consumed characters
+	std::size_t consume(const _Ch* begin, const _Ch* end, bool final)
+	{
+		m_base = begin;
+		const _Ch* text = begin;
+
+		while(text < end)
+		{
+			const _Ch* next = nullptr;
+			switch(m_state)
+			{
+			case in_content:		next = parse_content(text, end, final); break;
+			case in_comment:		next = skip_until(text, end, final, "-->", false); break;
+			case in_cdata:			next = skip_until(text, end, final, "]]>", true); break;
+			case in_pi:				next = skip_until(text, end, final, "?>", false); break;
+			case in_declaration:	next = skip_declaration(text, end, final); break;
+			}
+
+			if(!next)
+				break;
+			text = next;
+		}
+
+		m_consumed += text - begin;
+		return text - begin;
+	}
+
+	const _Ch* parse_content(const _Ch* text, const _Ch* end, bool final)
+	{
+		if(*text == _Ch('<'))
+			return parse_markup(text, end, final);
+		if(*text == _Ch('&'))
+			return parse_entity(text, end, final);
+
+		const _Ch* stop = text;
+		while(stop < end && tables::lookup_text_pure_no_ws[index(*stop)])
+			++stop;
+		if(stop == text)
+			error("unexpected zero character", text);
+
+		m_handler.text(text, stop - text);
+		return stop;
+	}
+
+	const _Ch* parse_entity(const _Ch* text, const _Ch* end, bool final)
+	{
+		const _Ch* limit = std::min(end, text + max_entity_size);
+		const _Ch* semicolon = text + 1;
+		while(semicolon < limit && *semicolon != _Ch(';'))
+			++semicolon;
+
+		if(semicolon == limit && limit == end && !final)
+			return nullptr;
+
+		m_scratch.clear();
+		if(semicolon < limit && decode_entity(text + 1, semicolon, m_scratch))
+		{
+			m_handler.text(m_scratch.data(), m_scratch.size());
+			return semicolon + 1;
+		}
+
+		// unknown entities are kept as they are
+		m_handler.text(text, 1);
+		return text + 1;
+	}
+
+	const _Ch* parse_markup(const _Ch* text, const _Ch* end, bool final)
+	{
+		if(end - text < 2)
+			return more(final, text);
+
+		switch(text[1])
+		{
+		case _Ch('/'):
+			return parse_end_tag(text, end, final);
+
+		case _Ch('?'):
+			m_state = in_pi;
+			return text + 2;
+
+		case _Ch('!'):
+			{
+				int comment = starts_with(text, end, "<!--");
+				if(comment < 0)
+					return more(final, text);
+				if(comment)
+				{
+					m_state = in_comment;
+					return text + 4;
+				}
+
+				int cdata = starts_with(text, end, "<![CDATA[");
+				if(cdata < 0)
+					return more(final, text);
+				if(cdata)
+				{
+					m_state = in_cdata;
+					return text + 9;
+				}
+
+				m_state = in_declaration;
+				m_brackets = 0;
+				return text + 2;
+			}
+
+		default:
+			return parse_start_tag(text, end, final);
+		}
+	}
+
+	const _Ch* parse_start_tag(const _Ch* text, const _Ch* end, bool final)
+	{
+		bool empty = false;
+		const _Ch* after = scan::skip_tag(text + 1, end, empty);
+		if(!after)
+			return more(final, text);
+		const _Ch* close = after - (empty? 2 : 1);
+
+		const _Ch* name = text + 1;
+		const _Ch* p = name;
+		while(p < close && tables::lookup_node_name[index(*p)])
+			++p;
+		if(p == name)
+			error("expected element name", p);
+		const std::size_t name_size = p - name;
+
+		m_handler.start_element(name, name_size);
+
+		while(true)
+		{
+			while(p < close && tables::lookup_whitespace[index(*p)])
+				++p;
+			if(p == close)
+				break;
+
+			const _Ch* attr_name = p;
+			while(p < close && tables::lookup_attribute_name[index(*p)])
+				++p;
+			if(p == attr_name)
+				error("expected attribute name", p);
+			const _Ch* attr_name_end = p;
+
+			while(p < close && tables::lookup_whitespace[index(*p)])
+				++p;
+			if(p == close || *p != _Ch('='))
+				error("expected =", p);
+			++p;
+			while(p < close && tables::lookup_whitespace[index(*p)])
+				++p;
+			if(p == close || (*p != _Ch('\'') && *p != _Ch('"')))
+				error("expected ' or \"", p);
+
+			const _Ch quote = *p++;
+			const _Ch* value = p;
+			while(p < close && *p != quote)
+				++p;
+			if(p == close)
+				error("expected ' or \"", p);
+
+			m_scratch.clear();
+			decode_entities(value, p, m_scratch);
+			++p;
+
+			m_handler.attribute(attr_name, attr_name_end - attr_name, m_scratch.data(), m_scratch.size());
+		}
+
+		if(empty)
+		{
+			m_handler.end_element(name, name_size);
+		}else
+		{
+			m_name_offsets.push_back(m_names.size());
+			m_names.append(name, name_size);
+		}
+		return after;
+	}
+
+	const _Ch* parse_end_tag(const _Ch* text, const _Ch* end, bool final)
+	{
+		const _Ch* close = scan::find(text + 2, end, _Ch('>'));
+		if(!close)
+			return more(final, text);
+
+		const _Ch* name = text + 2;
+		const _Ch* p = name;
+		while(p < close && tables::lookup_node_name[index(*p)])
+			++p;
+		const std::size_t name_size = p - name;
+
+		while(p < close && tables::lookup_whitespace[index(*p)])
+			++p;
+		if(p != close)
+			error("expected >", p);
+
+		if(!depth())
+			error("unexpected closing tag", text);
+
+		const std::size_t open = m_name_offsets.back();
+		if(m_names.size() - open != name_size || m_names.compare(open, name_size, name, name_size) != 0)
+			error("invalid closing tag name", name);
+
+		m_handler.end_element(name, name_size);
+		m_names.resize(open);
+		m_name_offsets.pop_back();
+		return close + 1;
+	}
+
+	const _Ch* skip_until(const _Ch* text, const _Ch* end, bool final, const char* seq, bool emit)
+	{
+		const std::size_t seq_size = std::char_traits<char>::length(seq);
+		const _Ch* after = scan::skip_past(text, end, seq);
+
+		if(after)
+		{
+			if(emit && after - seq_size > text)
+				m_handler.text(text, after - seq_size - text);
+			m_state = in_content;
+			return after;
+		}
+
+		if(final)
+			error("unexpected end of data", end);
+
+		// the last characters might be the beginning of the terminator
+		const _Ch* keep = end - (seq_size - 1);
+		if(keep <= text)
+			return nullptr;
+		if(emit)
+			m_handler.text(text, keep - text);
+		return keep;
+	}
+
+	const _Ch* skip_declaration(const _Ch* text, const _Ch* end, bool final)
+	{
+		for(; text < end; ++text)
+		{
+			if(*text == _Ch('['))
+				++m_brackets;
+			else if(*text == _Ch(']'))
+				--m_brackets;
+			else if(*text == _Ch('>') && m_brackets <= 0)
+			{
+				m_state = in_content;
+				return text + 1;
+			}
+		}
+
+		if(final)
+			error("unexpected end of data", end);
+		return end;
+	}
+
+	_Handler& m_handler;
+	state m_state;
+	int m_brackets;
+	std::size_t m_consumed;
+	const _Ch* m_base;
+	std::vector<_Ch> m_buffer;
+	std::basic_string<_Ch> m_scratch;
+	std::basic_string<_Ch> m_names;
+	std::vector<std::size_t> m_name_offsets;
+};
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,239 @@
+#pragma once
+#ifndef _RXML_SCANNER_HPP
+#define _RXML_SCANNER_HPP
+
+#include <rapidxml.hpp>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace rxml {
+namespace scan {
+
+/*
+ * Structural helpers walking over markup without building nodes.
+ * They follow the same rules as the rapidxml parser (quoted attribute values may contain '>',
+ * comments end at "-->", cdata at "]]>", doctypes may contain brackets) but do no validation.
+ * Each helper returns nullptr if the text ends before the construct is closed.
+ */
+
+template<typename _Ch>
+inline bool is_whitespace(_Ch ch)
+{
+	return ch == _Ch(' ') || ch == _Ch('\t') || ch == _Ch('\n') || ch == _Ch('\r');
+}
+
+// returns the first occurrence of ch in [text, end) or nullptr
+template<typename _Ch>
+inline _Ch* find(_Ch* text, _Ch* end, typename std::remove_const<_Ch>::type ch)
+{
+	typedef std::char_traits<typename std::remove_const<_Ch>::type> traits;
+	return text < end? const_cast<_Ch*>(traits::find(text, end - text, ch)) : nullptr;
+}
+
+// returns the position after the first occurrence of seq in [text, end) or nullptr
+template<typename _Ch>
+inline _Ch* skip_past(_Ch* text, _Ch* end, const char* seq)
+{
+	const std::size_t seq_size = std::char_traits<char>::length(seq);
+	while((text = find(text, end, _Ch(seq[0]))))
+	{
+		std::size_t i = 1;
+		for(; i < seq_size && text + i < end && text[i] == _Ch(seq[i]); ++i);
+		if(i == seq_size)
+			return text + seq_size;
+		++text;
+	}
+	return nullptr;
+}
+
+// text points after the tag name, returns the position after '>' and tells if the tag was closed by "/>"
+template<typename _Ch>
+inline _Ch* skip_tag(_Ch* text, _Ch* end, bool& empty)
+{
+	for(; text < end; ++text)
+	{
+		if(*text == _Ch('\'') || *text == _Ch('"'))
+		{
+			text = find(text + 1, end, *text);
+			if(!text)
+				return nullptr;
+		}else if(*text == _Ch('>'))
+		{
+			empty = *(text - 1) == _Ch('/');
+			return text + 1;
+		}
+	}
+	return nullptr;
+}
+
+// text points at '<!' of a doctype or an unknown declaration
+template<typename _Ch>
+inline _Ch* skip_declaration(_Ch* text, _Ch* end)
+{
+	int brackets = 0;
+	for(; text < end; ++text)
+	{
+		if(*text == _Ch('['))
+			++brackets;
+		else if(*text == _Ch(']'))
+			--brackets;
+		else if(*text == _Ch('>') && brackets <= 0)
+			return text + 1;
+	}
+	return nullptr;
+}
+
+
+// text points at '<', returns the position after the markup and tells how it changes the nesting depth
+template<typename _Ch>
+inline _Ch* skip_markup(_Ch* text, _Ch* end, int& depth_change)
+{
+	depth_change = 0;
+	const typename std::remove_const<_Ch>::type next = text[1];
+
+	if(next == _Ch('/'))
+	{
+		depth_change = -1;
+		text = find(text, end, _Ch('>'));
+		return text? text + 1 : nullptr;
+	}else if(next == _Ch('?'))
+	{
+		return skip_past(text + 2, end, "?>");
+	}else if(next == _Ch('!'))
+	{
+		if(text[2] == _Ch('-') && text[3] == _Ch('-'))
+			return skip_past(text + 4, end, "-->");
+		else if(text[2] == _Ch('['))
+			return skip_past(text + 3, end, "]]>");
+		return skip_declaration(text + 2, end);
+	}
+
+	bool empty = false;
+	text = skip_tag(text + 1, end, empty);
+	depth_change = empty? 0 : 1;
+	return text;
+}
+
+// ########################################### skip_content ###########################################
+/*
+ * Skips the content of an element, starting right after the '>' of its start tag.
+ * Returns the position of the '<' of its closing tag or nullptr if the content is not closed before end.
+ */
+template<typename _Ch>
+_Ch* skip_content(_Ch* text, _Ch* end)
+{
+	std::size_t depth = 0;
+	while((text = find(text, end, _Ch('<'))))
+	{
+		if(!depth && text[1] == _Ch('/'))
+			return text;
+
+		int depth_change;
+		text = skip_markup(text, end, depth_change);
+		if(!text)
+			return nullptr;
+		depth += depth_change;
+	}
+	return nullptr;
+}
+
+
+// text points at the '<' of a start tag, returns the position after the element or nullptr
+template<typename _Ch>
+_Ch* skip_element(_Ch* text, _Ch* end)
+{
+	int depth_change;
+	text = skip_markup(text, end, depth_change);
+	if(!text || !depth_change)
+		return text;
+
+	text = skip_content(text, end);
+	if(!text)
+		return nullptr;
+	text = find(text, end, _Ch('>'));
+	return text? text + 1 : nullptr;
+}
+
+
+// ########################################### content_layout ###########################################
+/*
+ * Result of scan_content.
+ * end points at the '<' of the closing tag of the scanned element.
+ * splits are start positions of child elements which are preceded by whitespace and are about
+ * step characters apart. Every range between two of them (and between begin, the splits and end)
+ * is a sequence of complete sibling nodes.
+ */
+template<typename _Ch>
+struct content_layout
+{
+	content_layout()
+		: end(nullptr)
+	{
+	}
+
+	_Ch* end;
+	std::vector<_Ch*> splits;
+};
+
+
+// ########################################### scan_content ###########################################
+/*
+ * Scans the content of an element, starting right after the '>' of its start tag.
+ * limit is the end of the text (usually the position of the terminating zero).
+ * Returns false if the content is not closed before limit or if it contains non-whitespace text directly,
+ * in which case the children can not be parsed as independent sequences.
+ */
+template<typename _Ch>
+bool scan_content(_Ch* begin, _Ch* limit, std::size_t step, content_layout<_Ch>& layout)
+{
+	layout = content_layout<_Ch>();
+
+	std::size_t depth = 0;
+	_Ch* next_split = begin + step;
+	_Ch* text = begin;
+
+	while(text && text < limit)
+	{
+		if(*text != _Ch('<'))
+		{
+			if(depth)
+			{
+				text = find(text, limit, _Ch('<'));
+				continue;
+			}
+
+			if(!is_whitespace(*text))
+				return false;
+			++text;
+			continue;
+		}
+
+		if(!depth && text[1] == _Ch('/'))
+		{
+			layout.end = text;
+			return true;
+		}
+
+		if(!depth && text >= next_split && text > begin && is_whitespace(*(text - 1))
+			&& text[1] != _Ch('?') && text[1] != _Ch('!'))
+		{
+			layout.splits.push_back(text);
+			next_split = text + step;
+		}
+
+		int depth_change;
+		text = skip_markup(text, limit, depth_change);
+		depth += depth_change;
+	}
+
+	return false;
+}
+
+}
+}
+
+
+
+#endif
@@ -0,0 +1,314 @@
+#pragma once
+#ifndef _RXML_SERIALIZE_HPP
+#define _RXML_SERIALIZE_HPP
+
+#include <rapidxml.hpp>
+#include <rapidxml_print.hpp>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "error.hpp"
+
+
+namespace rxml {
+
+
+namespace detail {
+
+	// ####################### size_counter #######################
+	template<typename _Ch>
+	struct size_counter
+	{
+		size_counter()
+			: size(0)
+		{
+		}
+
+		void put(_Ch)								{ ++size; }
+		void put(const _Ch*, std::size_t count)		{ size += count; }
+		void fill(_Ch, std::size_t count)			{ size += count; }
+
+		template<std::size_t _N>
+		void literal(const char (&)[_N])			{ size += _N - 1; }
+
+		std::size_t size;
+	};
+
+
+	// ####################### buffer_writer #######################
+	template<typename _Ch>
+	struct buffer_writer
+	{
+		explicit buffer_writer(_Ch* buffer)
+			: out(buffer)
+		{
+		}
+
+		void put(_Ch ch)
+		{
+			*out++ = ch;
+		}
+
+		void put(const _Ch* text, std::size_t count)
+		{
+			std::memcpy(out, text, count * sizeof(_Ch));
+			out += count;
+		}
+
+		void fill(_Ch ch, std::size_t count)
+		{
+			out = std::fill_n(out, count, ch);
+		}
+
+		template<std::size_t _N>
+		void literal(const char (&text)[_N])
+		{
+			for(std::size_t i = 0; i < _N - 1; ++i)
+				out[i] = _Ch(text[i]);
+			out += _N - 1;
+		}
+
+		_Ch* out;
+	};
+
+
+	// ####################### serializer #######################
+	/*
+	 * Produces exactly the text of rapidxml::print. The walk is shared by the sinks above,
+	 * so the size computed by size_counter is the size written by buffer_writer.
+	 */
+	template<typename _Ch, typename _Sink>
+	class serializer
+	{
+		typedef rapidxml::xml_node<_Ch> node_type;
+
+	public:
+		serializer(_Sink& sink, int flags)
+			: m_sink(sink)
+			, m_indenting(!(flags & rapidxml::print_no_indenting))
+		{
+		}
+
+		void node(const node_type* node, std::size_t indent)
+		{
+			switch(node->type())
+			{
+			case rapidxml::node_document:
+				children(node, indent);
+				break;
+
+			case rapidxml::node_element:
+				element(node, indent);
+				break;
+
+			case rapidxml::node_data:
+				this->indent(indent);
+				escaped(node->value(), node->value_size(), _Ch(0));
+				break;
+
+			case rapidxml::node_cdata:
+				this->indent(indent);
+				m_sink.literal("<![CDATA[");
+				m_sink.put(node->value(), node->value_size());
+				m_sink.literal("]]>");
+				break;
+
+			case rapidxml::node_declaration:
+				this->indent(indent);
+				m_sink.literal("<?xml");
+				attributes(node);
+				m_sink.literal("?>");
+				break;
+
+			case rapidxml::node_comment:
+				this->indent(indent);
+				m_sink.literal("<!--");
+				m_sink.put(node->value(), node->value_size());
+				m_sink.literal("-->");
+				break;
+
+			case rapidxml::node_doctype:
+				this->indent(indent);
+				m_sink.literal("<!DOCTYPE ");
+				m_sink.put(node->value(), node->value_size());
+				m_sink.put(_Ch('>'));
+				break;
+
+			case rapidxml::node_pi:
+				this->indent(indent);
+				m_sink.literal("<?");
+				m_sink.put(node->name(), node->name_size());
+				m_sink.put(_Ch(' '));
+				m_sink.put(node->value(), node->value_size());
+				m_sink.literal("?>");
+				break;
+
+			default:
+				rxml_assert(false);
+				break;
+			}
+
+			if(m_indenting)
+				m_sink.put(_Ch('\n'));
+		}
+
+		// writes the attributes of node as print writes them into a start tag
+		void attributes(const node_type* node)
+		{
+			for(const rapidxml::xml_attribute<_Ch>* attr = node->first_attribute(); attr; attr = attr->next_attribute())
+			{
+				m_sink.put(_Ch(' '));
+				m_sink.put(attr->name(), attr->name_size());
+				m_sink.put(_Ch('='));
+
+				// values with double quotes are quoted with single ones
+				const _Ch* value = attr->value();
+				const bool single = std::char_traits<_Ch>::find(value, attr->value_size(), _Ch('"')) != nullptr;
+				const _Ch quote = single? _Ch('\'') : _Ch('"');
+
+				m_sink.put(quote);
+				escaped(value, attr->value_size(), single? _Ch('"') : _Ch('\''));
+				m_sink.put(quote);
+			}
+		}
+
+		// copies runs of plain characters at once and expands the others like rapidxml::print;
+		// the runs are found by the vectorized kernels of the printer
+		void escaped(const _Ch* text, std::size_t size, _Ch noexpand)
+		{
+			const _Ch* end = text + size;
+			while(text != end)
+			{
+				const _Ch* run = text;
+				text = rapidxml::internal::find_expanded_char(text, end, noexpand);
+				m_sink.put(run, text - run);
+				if(text == end)
+					break;
+
+				switch(*text++)
+				{
+				case _Ch('<'):	m_sink.literal("&lt;");		break;
+				case _Ch('>'):	m_sink.literal("&gt;");		break;
+				case _Ch('\''):	m_sink.literal("&apos;");	break;
+				case _Ch('"'):	m_sink.literal("&quot;");	break;
+				default:		m_sink.literal("&amp;");	break;
+				}
+			}
+		}
+
+	private:
+		void indent(std::size_t indent)
+		{
+			if(m_indenting)
+				m_sink.fill(_Ch('\t'), indent);
+		}
+
+		void children(const node_type* node, std::size_t indent)
+		{
+			for(const node_type* child = node->first_node(); child; child = child->next_sibling())
+				this->node(child, indent);
+		}
+
+		void element(const node_type* node, std::size_t indent)
+		{
+			this->indent(indent);
+			m_sink.put(_Ch('<'));
+			m_sink.put(node->name(), node->name_size());
+			attributes(node);
+
+			const node_type* child = node->first_node();
+			if(!node->value_size() && !child)
+			{
+				m_sink.literal("/>");
+				return;
+			}
+
+			m_sink.put(_Ch('>'));
+			if(!child)
+				escaped(node->value(), node->value_size(), _Ch(0));
+			else if(!child->next_sibling() && child->type() == rapidxml::node_data)
+				escaped(child->value(), child->value_size(), _Ch(0));
+			else
+			{
+				if(m_indenting)
+					m_sink.put(_Ch('\n'));
+				children(node, indent + 1);
+				this->indent(indent);
+			}
+
+			m_sink.literal("</");
+			m_sink.put(node->name(), node->name_size());
+			m_sink.put(_Ch('>'));
+		}
+
+		_Sink& m_sink;
+		const bool m_indenting;
+	};
+}
+
+
+// ########################################### serialized_size ###########################################
+/*
+ * Number of characters rapidxml::print(out, *node, flags) writes, without a terminating zero.
+ */
+template<typename _Ch>
+std::size_t serialized_size(const rapidxml::xml_node<_Ch>* node, int flags = 0)
+{
+	rxml_assert(node);
+	detail::size_counter<_Ch> counter;
+	detail::serializer<_Ch, detail::size_counter<_Ch>>(counter, flags).node(node, 0);
+	return counter.size;
+}
+
+template<typename _Ch>
+std::size_t serialized_size(const rapidxml::xml_node<_Ch>& node, int flags = 0)
+{
+	return serialized_size(&node, flags);
+}
+
+
+// ########################################### serialize_to ###########################################
+/*
+ * Writes the text of rapidxml::print(out, *node, flags) to buffer, which must have room for
+ * serialized_size(node, flags) characters. Names, values and the runs between escaped characters
+ * are copied with memcpy. No terminating zero is written.
+ * Returns the position after the last written character.
+ */
+template<typename _Ch>
+_Ch* serialize_to(_Ch* buffer, const rapidxml::xml_node<_Ch>* node, int flags = 0)
+{
+	rxml_assert(buffer && node);
+	detail::buffer_writer<_Ch> writer(buffer);
+	detail::serializer<_Ch, detail::buffer_writer<_Ch>>(writer, flags).node(node, 0);
+	return writer.out;
+}
+
+template<typename _Ch>
+_Ch* serialize_to(_Ch* buffer, const rapidxml::xml_node<_Ch>& node, int flags = 0)
+{
+	return serialize_to(buffer, &node, flags);
+}
+
+
+// ########################################### serialize ###########################################
+template<typename _Ch>
+std::basic_string<_Ch> serialize(const rapidxml::xml_node<_Ch>* node, int flags = 0)
+{
+	std::basic_string<_Ch> result(serialized_size(node, flags), _Ch());
+	if(!result.empty())
+		serialize_to(&result[0], node, flags);
+	return result;
+}
+
+template<typename _Ch>
+std::basic_string<_Ch> serialize(const rapidxml::xml_node<_Ch>& node, int flags = 0)
+{
+	return serialize(&node, flags);
+}
+
+
+}
+
+
+
+#endif
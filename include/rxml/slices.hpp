@@ -0,0 +1,285 @@
+#pragma once
+#ifndef _RXML_SLICES_HPP
+#define _RXML_SLICES_HPP
+
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "error.hpp"
+#include "serialize.hpp"
+
+#if !defined(_WIN32)
+#	include <climits>
+#	include <sys/uio.h>
+#	include <unistd.h>
+#	define RXML_SLICES_WRITEV
+#	ifndef IOV_MAX
+#		define IOV_MAX 16
+#	endif
+#endif
+
+
+namespace rxml {
+
+namespace detail {
+	template<typename _Ch>
+	class slice_builder;
+}
+
+
+// ########################################### slice ###########################################
+template<typename _Ch = char>
+struct slice
+{
+	const _Ch* data;
+	std::size_t size;
+};
+
+
+// ########################################### slice_list ###########################################
+/*
+ * Serialized text as a list of slices, in the order of the text. Names, values and runs between
+ * escaped characters point into the strings of the document; markup, indentation, references and
+ * pieces shorter than the reference threshold are generated into blocks owned by the list, and
+ * adjacent generated pieces share one slice.
+ *
+ * The slices stay valid as long as the list and the strings of the serialized nodes.
+ */
+template<typename _Ch = char>
+class slice_list
+{
+public:
+	typedef rxml::slice<_Ch> slice_type;
+	typedef typename std::vector<slice_type>::const_iterator const_iterator;
+
+	static const std::size_t block_size = 4096;
+
+	slice_list()
+		: m_free(nullptr)
+		, m_left(0)
+		, m_total(0)
+	{
+	}
+
+	slice_list(slice_list&& other)
+		: m_slices(std::move(other.m_slices))
+		, m_blocks(std::move(other.m_blocks))
+		, m_free(other.m_free)
+		, m_left(other.m_left)
+		, m_total(other.m_total)
+	{
+		other.m_free = nullptr;
+		other.m_left = 0;
+		other.m_total = 0;
+	}
+
+	std::size_t size() const						{ return m_slices.size(); }
+	bool empty() const								{ return m_slices.empty(); }
+	const slice_type& operator [](std::size_t i) const	{ return m_slices[i]; }
+	const_iterator begin() const					{ return m_slices.begin(); }
+	const_iterator end() const						{ return m_slices.end(); }
+
+	// number of characters of all slices
+	std::size_t total_size() const
+	{
+		return m_total;
+	}
+
+	// number of characters generated into the blocks of the list
+	std::size_t generated_size() const
+	{
+		std::size_t result = 0;
+		for(auto& block : m_blocks)
+			result += block.size;
+		return result - m_left;
+	}
+
+	std::basic_string<_Ch> str() const
+	{
+		std::basic_string<_Ch> result;
+		result.reserve(m_total);
+		for(auto& s : m_slices)
+			result.append(s.data, s.size);
+		return result;
+	}
+
+#ifdef RXML_SLICES_WRITEV
+	// writes all slices with writev, at most IOV_MAX at a time; returns the number of bytes written
+	std::size_t write_to(int fd) const
+	{
+		std::vector<iovec> vectors(m_slices.size());
+		for(std::size_t i = 0; i < m_slices.size(); ++i)
+		{
+			vectors[i].iov_base = const_cast<_Ch*>(m_slices[i].data);
+			vectors[i].iov_len = m_slices[i].size * sizeof(_Ch);
+		}
+
+		std::size_t written = 0;
+		for(iovec* next = vectors.data(), *last = vectors.data() + vectors.size(); next != last; )
+		{
+			const ssize_t result = ::writev(fd, next, static_cast<int>(std::min<std::size_t>(last - next, IOV_MAX)));
+			if(result < 0)
+			{
+				if(errno == EINTR)
+					continue;
+				throw std::runtime_error(std::string("cannot write to file descriptor: ") + std::strerror(errno));
+			}
+			written += result;
+
+			// skip what was written, a partially written slice continues where writev stopped
+			std::size_t left = result;
+			for(; next != last && left >= next->iov_len; ++next)
+				left -= next->iov_len;
+			if(next != last)
+			{
+				next->iov_base = static_cast<char*>(next->iov_base) + left;
+				next->iov_len -= left;
+			}
+		}
+		return written;
+	}
+#endif
+
+private:
+	friend class detail::slice_builder<_Ch>;
+
+	slice_list(const slice_list&);
+	slice_list& operator =(const slice_list&);
+
+	struct block
+	{
+		std::unique_ptr<_Ch[]> data;
+		std::size_t size;
+	};
+
+	void reference(const _Ch* text, std::size_t count)
+	{
+		slice_type s = { text, count };
+		m_slices.push_back(s);
+		m_total += count;
+	}
+
+	// room for count generated characters, appended to the last slice if that ends at the free position
+	_Ch* generate(std::size_t count)
+	{
+		if(!count)
+			return m_free;
+
+		if(count > m_left)
+		{
+			block b;
+			b.size = std::max(count, block_size);
+			b.data.reset(new _Ch[b.size]);
+			m_free = b.data.get();
+			m_left = b.size;
+			m_blocks.push_back(std::move(b));
+		}
+
+		_Ch* out = m_free;
+		if(!m_slices.empty() && m_slices.back().data + m_slices.back().size == out)
+			m_slices.back().size += count;
+		else
+		{
+			slice_type s = { out, count };
+			m_slices.push_back(s);
+		}
+
+		m_free += count;
+		m_left -= count;
+		m_total += count;
+		return out;
+	}
+
+	std::vector<slice_type> m_slices;
+	std::vector<block> m_blocks;
+	_Ch* m_free;
+	std::size_t m_left;
+	std::size_t m_total;
+};
+
+template<typename _Ch>
+const std::size_t slice_list<_Ch>::block_size;
+
+
+namespace detail {
+
+	// ####################### slice_builder #######################
+	// sink of serializer that appends to a slice_list
+	template<typename _Ch>
+	class slice_builder
+	{
+	public:
+		slice_builder(slice_list<_Ch>& slices, std::size_t min_reference)
+			: m_slices(slices)
+			, m_min_reference(min_reference)
+		{
+		}
+
+		void put(_Ch ch)
+		{
+			*m_slices.generate(1) = ch;
+		}
+
+		void put(const _Ch* text, std::size_t count)
+		{
+			if(!count)
+				return;
+			if(count < m_min_reference)
+				std::memcpy(m_slices.generate(count), text, count * sizeof(_Ch));
+			else
+				m_slices.reference(text, count);
+		}
+
+		void fill(_Ch ch, std::size_t count)
+		{
+			std::fill_n(m_slices.generate(count), count, ch);
+		}
+
+		template<std::size_t _N>
+		void literal(const char (&text)[_N])
+		{
+			_Ch* out = m_slices.generate(_N - 1);
+			for(std::size_t i = 0; i < _N - 1; ++i)
+				out[i] = _Ch(text[i]);
+		}
+
+	private:
+		slice_list<_Ch>& m_slices;
+		const std::size_t m_min_reference;
+	};
+}
+
+
+// ########################################### serialize_slices ###########################################
+/*
+ * The text of rapidxml::print(out, *node, flags) as slices for scatter-gather output.
+ * Pieces of the document shorter than min_reference characters are copied instead of referenced,
+ * since another slice costs more than copying a short name.
+ */
+template<typename _Ch>
+slice_list<_Ch> serialize_slices(const rapidxml::xml_node<_Ch>* node, int flags = 0, std::size_t min_reference = 16)
+{
+	rxml_assert(node);
+	slice_list<_Ch> slices;
+	detail::slice_builder<_Ch> builder(slices, min_reference);
+	detail::serializer<_Ch, detail::slice_builder<_Ch>>(builder, flags).node(node, 0);
+	return slices;
+}
+
+template<typename _Ch>
+slice_list<_Ch> serialize_slices(const rapidxml::xml_node<_Ch>& node, int flags = 0, std::size_t min_reference = 16)
+{
+	return serialize_slices(&node, flags, min_reference);
+}
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,455 @@
+#pragma once
+#ifndef _RXML_SNAPSHOT_HPP
+#define _RXML_SNAPSHOT_HPP
+
+#include <rapidxml.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "error.hpp"
+#include "compact.hpp"
+#include "mapped_file.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### snapshot_source ###########################################
+// identifies the text a snapshot was built from
+struct snapshot_source
+{
+	std::uint64_t size;		// in bytes
+	std::uint64_t checksum;
+
+	bool operator ==(const snapshot_source& other) const
+	{
+		return size == other.size && checksum == other.checksum;
+	}
+
+	bool operator !=(const snapshot_source& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+// FNV-1a over 64 bit words, the remaining bytes one by one; hash continues a previous checksum
+inline std::uint64_t snapshot_checksum(const void* data, std::size_t size, std::uint64_t hash = 0xcbf29ce484222325ull)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for(; size >= 8; bytes += 8, size -= 8)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, bytes, 8);
+		hash = (hash ^ word) * 0x100000001b3ull;
+	}
+	for(; size; ++bytes, --size)
+		hash = (hash ^ *bytes) * 0x100000001b3ull;
+
+	return hash;
+}
+
+template<typename _Ch>
+snapshot_source describe_snapshot_source(const _Ch* text, std::size_t size)
+{
+	snapshot_source source;
+	source.size = size * sizeof(_Ch);
+	source.checksum = snapshot_checksum(text, source.size);
+	return source;
+}
+
+
+namespace detail {
+
+	static const char snapshot_magic[8] = { 'R', 'X', 'M', 'L', 'S', 'N', 'A', 'P' };
+	static const std::uint32_t snapshot_version = 2;
+	static const std::uint32_t snapshot_byte_order = 0x01020304;
+
+	/*
+	 * A snapshot file is the header, the node records, the attribute records and the string pool
+	 * with a terminating zero. The records are those of compact_document with offsets into the pool,
+	 * so the file is used as it is mapped. Numbers are in the byte order of the writing machine.
+	 * body_checksum covers the node records, the attribute records and the pool, in this order.
+	 */
+	struct snapshot_header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint32_t char_size;
+		std::uint32_t node_count;
+		std::uint32_t attribute_count;
+		std::uint32_t pool_size;		// characters without the terminating zero
+		snapshot_source source;
+		std::uint64_t body_checksum;
+	};
+
+	// collects the records and strings of a tree
+	template<typename _Ch>
+	class snapshot_builder
+	{
+	public:
+		// raw: values contain their entities; otherwise '&' is escaped so rxml::value restores them as they are
+		explicit snapshot_builder(bool raw)
+			: m_raw(raw)
+		{
+		}
+
+		// _Node is a pointer to a rapidxml node or a compact_node
+		template<typename _Node>
+		void build(const _Node& document)
+		{
+			m_nodes.clear();
+			m_attributes.clear();
+			m_pool.clear();
+			m_names.clear();
+
+			add_node(document, compact_npos);
+			add_children(document, 0);
+		}
+
+		void write(std::ostream& out, const snapshot_source& source) const
+		{
+			if(m_pool.size() >= compact_npos)
+				throw std::length_error("strings are too large for a snapshot");
+
+			snapshot_header header;
+			std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+			header.version = snapshot_version;
+			header.byte_order = snapshot_byte_order;
+			header.char_size = sizeof(_Ch);
+			header.node_count = static_cast<std::uint32_t>(m_nodes.size());
+			header.attribute_count = static_cast<std::uint32_t>(m_attributes.size());
+			header.pool_size = static_cast<std::uint32_t>(m_pool.size());
+			header.source = source;
+			header.body_checksum = snapshot_checksum(m_nodes.data(), m_nodes.size() * sizeof(compact_node_record));
+			header.body_checksum = snapshot_checksum(m_attributes.data(), m_attributes.size() * sizeof(compact_attribute_record), header.body_checksum);
+			header.body_checksum = snapshot_checksum(m_pool.c_str(), (m_pool.size() + 1) * sizeof(_Ch), header.body_checksum);
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(m_nodes.data()), m_nodes.size() * sizeof(compact_node_record));
+			out.write(reinterpret_cast<const char*>(m_attributes.data()), m_attributes.size() * sizeof(compact_attribute_record));
+			out.write(reinterpret_cast<const char*>(m_pool.c_str()), (m_pool.size() + 1) * sizeof(_Ch));
+		}
+
+	private:
+		template<typename _Node>
+		void add_children(const _Node& node, std::uint32_t index)
+		{
+			std::uint32_t last = compact_npos;
+			for(auto child = node->first_node(); child; child = child->next_sibling())
+			{
+				const std::uint32_t child_index = add_node(child, index);
+				if(last == compact_npos)
+					m_nodes[index].first_child = child_index;
+				else
+					m_nodes[last].next_sibling = child_index;
+				last = child_index;
+
+				add_children(child, child_index);
+			}
+		}
+
+		template<typename _Node>
+		std::uint32_t add_node(const _Node& node, std::uint32_t parent)
+		{
+			compact_node_record record = {};
+			add_name(node->name(), node->name_size(), record.name, record.name_size);
+			add_value(node->value(), node->value_size(), record.value, record.value_size);
+			record.parent = parent;
+			record.first_child = record.next_sibling = compact_npos;
+			record.type = node->type();
+
+			const std::uint32_t index = static_cast<std::uint32_t>(m_nodes.size());
+			record.first_attribute = static_cast<std::uint32_t>(m_attributes.size());
+			for(auto attr = node->first_attribute(); attr; attr = attr->next_attribute())
+			{
+				compact_attribute_record a;
+				add_name(attr->name(), attr->name_size(), a.name, a.name_size);
+				add_value(attr->value(), attr->value_size(), a.value, a.value_size);
+				a.parent = index;
+				m_attributes.push_back(a);
+			}
+			if(m_attributes.size() - record.first_attribute > compact_max_attributes)
+				throw std::length_error("too many attributes for a snapshot");
+			record.attribute_count = static_cast<std::uint32_t>(m_attributes.size() - record.first_attribute);
+
+			m_nodes.push_back(record);
+			return index;
+		}
+
+		// names repeat a lot, so they are stored once
+		void add_name(const _Ch* name, std::size_t size, std::uint32_t& offset, std::uint32_t& out_size)
+		{
+			auto inserted = m_names.insert(std::make_pair(std::basic_string<_Ch>(name, size), 0u));
+			if(inserted.second)
+			{
+				inserted.first->second = static_cast<std::uint32_t>(m_pool.size());
+				m_pool.append(name, size);
+			}
+			offset = inserted.first->second;
+			out_size = static_cast<std::uint32_t>(size);
+		}
+
+		void add_value(const _Ch* value, std::size_t size, std::uint32_t& offset, std::uint32_t& out_size)
+		{
+			offset = static_cast<std::uint32_t>(m_pool.size());
+			if(m_raw || !std::char_traits<_Ch>::find(value, size, _Ch('&')))
+			{
+				m_pool.append(value, size);
+			}else{
+				for(const _Ch* end = value + size; value < end; ++value)
+				{
+					if(*value == _Ch('&'))
+						m_pool.append({ _Ch('&'), _Ch('a'), _Ch('m'), _Ch('p'), _Ch(';') });
+					else
+						m_pool.append(1, *value);
+				}
+			}
+			out_size = static_cast<std::uint32_t>(m_pool.size() - offset);
+		}
+
+		const bool m_raw;
+		std::vector<compact_node_record> m_nodes;
+		std::vector<compact_attribute_record> m_attributes;
+		std::basic_string<_Ch> m_pool;
+		std::unordered_map<std::basic_string<_Ch>, std::uint32_t> m_names;
+	};
+
+	template<typename _Ch, typename _Node>
+	void save_snapshot(const std::string& filename, const _Node& document, bool raw, const snapshot_source& source)
+	{
+		snapshot_builder<_Ch> builder(raw);
+		builder.build(document);
+
+		std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+		if(!out)
+			throw std::runtime_error("cannot open file " + filename);
+		builder.write(out, source);
+		out.close();
+		if(!out)
+			throw std::runtime_error("cannot write file " + filename);
+	}
+}
+
+
+// ########################################### save_snapshot ###########################################
+/*
+ * Writes the tree of a document to a binary snapshot, which snapshot_document maps without parsing.
+ * source identifies the text the document was parsed from (see describe_snapshot_source).
+ */
+template<typename _Ch>
+void save_snapshot(const std::string& filename, const rapidxml::xml_document<_Ch>& doc, const snapshot_source& source)
+{
+	const bool raw = (doc.parse_flags() & rapidxml::parse_no_entity_translation) != 0;
+	detail::save_snapshot<_Ch>(filename, static_cast<const rapidxml::xml_node<_Ch>*>(&doc), raw, source);
+}
+
+template<typename _Ch>
+void save_snapshot(const std::string& filename, const compact_document<_Ch>& doc, const snapshot_source& source)
+{
+	detail::save_snapshot<_Ch>(filename, static_cast<const compact_node<_Ch>&>(doc), true, source);
+}
+
+
+// ########################################### snapshot_document ###########################################
+/*
+ * Read-only document mapping a snapshot written by save_snapshot. It is used through the same handles
+ * and rxml accessors as compact_document (see handles.hpp), without parsing anything.
+ *
+ * load_or_build keeps a snapshot next to its source: if the snapshot is missing, was written by
+ * another version or for a different source, the source is parsed and the snapshot rewritten.
+ * A snapshot whose body does not match its checksum, or whose records point outside the file, is
+ * invalid and rebuilt like a stale one.
+ */
+template<typename _Ch = char>
+class snapshot_document
+	: public compact_node<_Ch>
+{
+	typedef detail::compact_node_record node_record;
+	typedef detail::compact_attribute_record attribute_record;
+public:
+	snapshot_document()
+		: compact_node<_Ch>(&m_storage, 0)
+	{
+		clear();
+	}
+
+	void load(const std::string& filename)
+	{
+		if(!try_load(filename))
+			throw std::runtime_error("invalid snapshot " + filename);
+	}
+
+	// returns false if the file is missing, invalid or was not built from expected
+	bool try_load(const std::string& filename, const snapshot_source* expected = nullptr)
+	{
+		clear();
+
+		std::unique_ptr<mapped_file<char>> file;
+		try
+		{
+			file.reset(new mapped_file<char>(filename, mapped_file<char>::access_willneed, mapped_file<char>::map_read_only));
+		}catch(const std::runtime_error&)
+		{
+			return false;
+		}
+
+		const std::size_t size = file->size() - 1;
+		detail::snapshot_header header;
+		if(size < sizeof(header))
+			return false;
+		std::memcpy(&header, file->data(), sizeof(header));
+
+		if(std::memcmp(header.magic, detail::snapshot_magic, sizeof(header.magic)) != 0
+			|| header.version != detail::snapshot_version
+			|| header.byte_order != detail::snapshot_byte_order
+			|| header.char_size != sizeof(_Ch)
+			|| !header.node_count
+			|| (expected && header.source != *expected))
+			return false;
+
+		const std::size_t nodes = sizeof(header);
+		const std::size_t attributes = nodes + std::size_t(header.node_count) * sizeof(node_record);
+		const std::size_t pool = attributes + std::size_t(header.attribute_count) * sizeof(attribute_record);
+		if(size != pool + (std::size_t(header.pool_size) + 1) * sizeof(_Ch))
+			return false;
+
+		const char* data = file->data();
+		std::uint64_t checksum = snapshot_checksum(data + nodes, attributes - nodes);
+		checksum = snapshot_checksum(data + attributes, pool - attributes, checksum);
+		checksum = snapshot_checksum(data + pool, size - pool, checksum);
+		if(checksum != header.body_checksum)
+			return false;
+
+		if(!valid(reinterpret_cast<const node_record*>(data + nodes), reinterpret_cast<const attribute_record*>(data + attributes),
+				reinterpret_cast<const _Ch*>(data + pool), header))
+			return false;
+
+		m_storage.nodes = reinterpret_cast<const node_record*>(data + nodes);
+		m_storage.attributes = reinterpret_cast<const attribute_record*>(data + attributes);
+		m_storage.text = reinterpret_cast<const _Ch*>(data + pool);
+		m_storage.node_count = header.node_count;
+		m_storage.attribute_count = header.attribute_count;
+		m_source = header.source;
+		m_file = std::move(file);
+		return true;
+	}
+
+	// loads the snapshot of the source file, building it first if needed; returns true if it was built
+	bool load_or_build(const std::string& snapshot_filename, const std::string& source_filename)
+	{
+		mapped_file<_Ch> source_file(source_filename, mapped_file<_Ch>::access_sequential, mapped_file<_Ch>::map_read_only);
+		const snapshot_source source = describe_snapshot_source(source_file.data(), source_file.size() - 1);
+
+		if(try_load(snapshot_filename, &source))
+			return false;
+
+		{
+			compact_document<_Ch> doc;
+			doc.parse(source_file.data());
+
+			// replace the snapshot at once, so no reader ever maps a partial file
+			const std::string temporary = snapshot_filename + ".tmp";
+			save_snapshot(temporary, doc, source);
+			if(std::rename(temporary.c_str(), snapshot_filename.c_str()) != 0)
+			{
+				std::remove(temporary.c_str());
+				throw std::runtime_error("cannot replace snapshot " + snapshot_filename);
+			}
+		}
+
+		if(!try_load(snapshot_filename, &source))
+			throw std::runtime_error("invalid snapshot " + snapshot_filename);
+		return true;
+	}
+
+	void clear()
+	{
+		static const _Ch empty[1] = { _Ch('\0') };
+		static const node_record document = { 0, 0, 0, 0, detail::compact_npos, detail::compact_npos, detail::compact_npos, 0, 0, rapidxml::node_document };
+
+		m_file.reset();
+		m_storage.text = empty;
+		m_storage.nodes = &document;
+		m_storage.attributes = nullptr;
+		m_storage.node_count = 1;
+		m_storage.attribute_count = 0;
+		m_source = snapshot_source();
+	}
+
+	// the source the loaded snapshot was built from
+	const snapshot_source& source() const
+	{
+		return m_source;
+	}
+
+	std::size_t node_count() const
+	{
+		return m_storage.node_count;
+	}
+
+	std::size_t attribute_count() const
+	{
+		return m_storage.attribute_count;
+	}
+
+private:
+	snapshot_document(const snapshot_document&);
+	snapshot_document& operator =(const snapshot_document&);
+
+	static bool in_pool(std::uint32_t offset, std::uint32_t size, std::uint32_t pool_size)
+	{
+		return std::uint64_t(offset) + size <= pool_size;
+	}
+
+	// every index and offset stays inside the file; children and siblings follow their node as
+	// save_snapshot writes them, so no chain of them loops
+	static bool valid(const node_record* nodes, const attribute_record* attributes, const _Ch* text, const detail::snapshot_header& header)
+	{
+		if(text[header.pool_size] != _Ch('\0') || nodes[0].type != rapidxml::node_document || nodes[0].parent != detail::compact_npos)
+			return false;
+
+		for(std::uint32_t i = 0; i < header.node_count; ++i)
+		{
+			const node_record& n = nodes[i];
+			if(!in_pool(n.name, n.name_size, header.pool_size)
+				|| !in_pool(n.value, n.value_size, header.pool_size)
+				|| n.type > rapidxml::node_pi
+				|| (i && n.parent >= i)
+				|| (n.first_child != detail::compact_npos && (n.first_child <= i || n.first_child >= header.node_count))
+				|| (n.next_sibling != detail::compact_npos && (n.next_sibling <= i || n.next_sibling >= header.node_count))
+				|| std::uint64_t(n.first_attribute) + n.attribute_count > header.attribute_count)
+				return false;
+		}
+
+		for(std::uint32_t i = 0; i < header.attribute_count; ++i)
+		{
+			const attribute_record& a = attributes[i];
+			if(!in_pool(a.name, a.name_size, header.pool_size)
+				|| !in_pool(a.value, a.value_size, header.pool_size)
+				|| a.parent >= header.node_count
+				|| i < nodes[a.parent].first_attribute
+				|| i >= nodes[a.parent].first_attribute + nodes[a.parent].attribute_count)
+				return false;
+		}
+		return true;
+	}
+
+	detail::compact_storage<_Ch> m_storage;
+	std::unique_ptr<mapped_file<char>> m_file;
+	snapshot_source m_source;
+};
+
+
+}
+
+
+
+#endif
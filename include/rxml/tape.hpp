@@ -0,0 +1,600 @@
+#pragma once
+#ifndef _RXML_TAPE_HPP
+#define _RXML_TAPE_HPP
+
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "error.hpp"
+#include "handles.hpp"
+#include "scanner.hpp"
+
+
+namespace rxml {
+
+template<typename _Ch> class tape_node;
+template<typename _Ch> class tape_attribute;
+
+
+namespace detail {
+
+	enum tape_entry_type
+	{
+		tape_open,			// start of an element or the document, the link is the index of its close entry
+		tape_close,			// end of an element or the document, the link is the index of its open entry
+		tape_attribute,		// attribute name, the next entry is its value
+		tape_value,			// attribute value
+		tape_data,
+		tape_cdata
+	};
+
+	/*
+	 * The tape is stored as columns: navigation only reads the types and links,
+	 * names and values (offsets into the text) are only read when they are compared or returned.
+	 */
+	template<typename _Ch>
+	struct tape_storage
+	{
+		const _Ch* text;
+		std::vector<std::uint8_t> types;
+		std::vector<std::uint32_t> links;
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> sizes;
+
+		std::size_t size() const
+		{
+			return types.size();
+		}
+
+		bool matches(std::uint32_t entry, const _Ch* name, std::size_t name_size, bool case_sensitive) const
+		{
+			return !name || rapidxml::internal::compare(text + offsets[entry], sizes[entry], name, name_size, case_sensitive);
+		}
+
+		// entry after entry and everything belonging to it
+		std::uint32_t next(std::uint32_t entry) const
+		{
+			switch(types[entry])
+			{
+			case tape_open:			return links[entry] + 1;
+			case tape_attribute:	return entry + 2;
+			default:				return entry + 1;
+			}
+		}
+
+		// first entry after the attributes of an open entry
+		std::uint32_t first_child(std::uint32_t entry) const
+		{
+			for(++entry; types[entry] == tape_attribute; entry += 2);
+			return entry;
+		}
+
+		// open entry enclosing entry
+		std::uint32_t parent(std::uint32_t entry) const
+		{
+			if(types[entry] == tape_attribute)
+			{
+				while(types[--entry] != tape_open);
+				return entry;
+			}
+
+			while(types[entry] != tape_close)
+				entry = next(entry);
+			return links[entry];
+		}
+	};
+}
+
+
+// ########################################### tape_entity ###########################################
+/*
+ * Handle to a node or an attribute of a tape_document, the counterpart of rapidxml::xml_base.
+ * Handles are small values; a default constructed handle is null and converts to false.
+ * Names and values point into the parsed text and are not zero terminated.
+ * See handles.hpp for the rxml accessors.
+ */
+template<typename _Ch = char>
+class tape_entity
+{
+public:
+	typedef _Ch char_type;
+	typedef tape_entity<_Ch> handle_entity;
+	typedef tape_node<_Ch> handle_node;
+	typedef tape_attribute<_Ch> handle_attribute;
+
+	tape_entity()
+		: m_storage(nullptr)
+		, m_entry(0)
+	{
+	}
+
+	tape_entity(const detail::tape_storage<_Ch>* storage, std::uint32_t entry)
+		: m_storage(storage)
+		, m_entry(entry)
+	{
+	}
+
+	const _Ch* name() const
+	{
+		return m_storage->text + (named()? m_storage->offsets[m_entry] : 0);
+	}
+
+	std::size_t name_size() const
+	{
+		return named()? m_storage->sizes[m_entry] : 0;
+	}
+
+	// the raw value, entities are not decoded (see rxml::value)
+	const _Ch* value() const
+	{
+		const std::uint32_t entry = value_entry();
+		return m_storage->text + (entry? m_storage->offsets[entry] : 0);
+	}
+
+	std::size_t value_size() const
+	{
+		const std::uint32_t entry = value_entry();
+		return entry? m_storage->sizes[entry] : 0;
+	}
+
+	tape_node<_Ch> parent() const
+	{
+		return m_entry? tape_node<_Ch>(m_storage, m_storage->parent(m_entry)) : tape_node<_Ch>();
+	}
+
+	// the document is the first entry
+	tape_node<_Ch> document() const
+	{
+		return tape_node<_Ch>(m_storage, 0);
+	}
+
+	bool is_attribute() const
+	{
+		return m_storage->types[m_entry] == detail::tape_attribute;
+	}
+
+	std::uint32_t entry() const
+	{
+		return m_entry;
+	}
+
+	explicit operator bool() const
+	{
+		return m_storage != nullptr;
+	}
+
+	bool operator ==(const tape_entity& other) const
+	{
+		return m_storage == other.m_storage && m_entry == other.m_entry;
+	}
+
+	bool operator !=(const tape_entity& other) const
+	{
+		return !(*this == other);
+	}
+
+protected:
+	bool named() const
+	{
+		const std::uint8_t type = m_storage->types[m_entry];
+		return type == detail::tape_open || type == detail::tape_attribute;
+	}
+
+	// entry holding the value or 0 if there is none; elements have the value of their first data node
+	std::uint32_t value_entry() const
+	{
+		rxml_assert(m_storage);
+
+		switch(m_storage->types[m_entry])
+		{
+		case detail::tape_attribute:
+			return m_entry + 1;
+
+		case detail::tape_data:
+		case detail::tape_cdata:
+			return m_entry;
+
+		default:
+			for(std::uint32_t entry = m_storage->first_child(m_entry); m_storage->types[entry] != detail::tape_close; entry = m_storage->next(entry))
+			{
+				if(m_storage->types[entry] == detail::tape_data)
+					return entry;
+			}
+			return 0;
+		}
+	}
+
+	const detail::tape_storage<_Ch>* m_storage;
+	std::uint32_t m_entry;
+};
+
+
+// ########################################### tape_attribute ###########################################
+template<typename _Ch = char>
+class tape_attribute
+	: public tape_entity<_Ch>
+{
+public:
+	tape_attribute()
+	{
+	}
+
+	tape_attribute(const detail::tape_storage<_Ch>* storage, std::uint32_t entry)
+		: tape_entity<_Ch>(storage, entry)
+	{
+	}
+
+	tape_attribute next_attribute(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		return find(this->m_storage, this->m_entry + 2, name, name_size, case_sensitive);
+	}
+
+	const tape_attribute* operator ->() const
+	{
+		return this;
+	}
+
+	// first attribute starting at entry with the given name
+	static tape_attribute find(const detail::tape_storage<_Ch>* storage, std::uint32_t entry, const _Ch* name, std::size_t name_size, bool case_sensitive)
+	{
+		if(name && !name_size)
+			name_size = rapidxml::internal::measure(name);
+
+		for(; storage->types[entry] == detail::tape_attribute; entry += 2)
+		{
+			if(storage->matches(entry, name, name_size, case_sensitive))
+				return tape_attribute(storage, entry);
+		}
+		return tape_attribute();
+	}
+};
+
+
+// ########################################### tape_node ###########################################
+/*
+ * Handle to a node of a tape_document, the counterpart of rapidxml::xml_node.
+ * Moving to the next sibling jumps over the whole subtree by the link of its open entry.
+ */
+template<typename _Ch = char>
+class tape_node
+	: public tape_entity<_Ch>
+{
+public:
+	tape_node()
+	{
+	}
+
+	tape_node(const detail::tape_storage<_Ch>* storage, std::uint32_t entry)
+		: tape_entity<_Ch>(storage, entry)
+	{
+	}
+
+	rapidxml::node_type type() const
+	{
+		switch(this->m_storage->types[this->m_entry])
+		{
+		case detail::tape_data:		return rapidxml::node_data;
+		case detail::tape_cdata:	return rapidxml::node_cdata;
+		default:					return this->m_entry? rapidxml::node_element : rapidxml::node_document;
+		}
+	}
+
+	tape_node first_node(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		if(this->m_storage->types[this->m_entry] != detail::tape_open)
+			return tape_node();
+		return find(this->m_storage->first_child(this->m_entry), name, name_size, case_sensitive);
+	}
+
+	tape_node next_sibling(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		if(!this->m_entry)
+			return tape_node();
+		return find(this->m_storage->next(this->m_entry), name, name_size, case_sensitive);
+	}
+
+	tape_attribute<_Ch> first_attribute(const _Ch* name = nullptr, std::size_t name_size = 0, bool case_sensitive = true) const
+	{
+		if(this->m_storage->types[this->m_entry] != detail::tape_open)
+			return tape_attribute<_Ch>();
+		return tape_attribute<_Ch>::find(this->m_storage, this->m_entry + 1, name, name_size, case_sensitive);
+	}
+
+	const tape_node* operator ->() const
+	{
+		return this;
+	}
+
+private:
+	// first sibling starting at entry with the given name
+	tape_node find(std::uint32_t entry, const _Ch* name, std::size_t name_size, bool case_sensitive) const
+	{
+		const detail::tape_storage<_Ch>& storage = *this->m_storage;
+
+		if(name && !name_size)
+			name_size = rapidxml::internal::measure(name);
+
+		for(; storage.types[entry] != detail::tape_close; entry = storage.next(entry))
+		{
+			if(!name || (storage.types[entry] == detail::tape_open && storage.matches(entry, name, name_size, case_sensitive)))
+				return tape_node(this->m_storage, entry);
+		}
+		return tape_node();
+	}
+};
+
+
+// ########################################### tape_document ###########################################
+/*
+ * Read-only document stored as a flat tape of entries instead of linked nodes.
+ *
+ * An element is an open entry, followed by two entries per attribute, its children and a close entry.
+ * Open and close entries link to each other, so a subtree is skipped with a single jump.
+ * The tape is built in two stages: first the positions of all '<' in the text are indexed,
+ * then the tape is built from the markup at these positions and the text between them.
+ *
+ * The text is not modified, must outlive the document and be smaller than 4 GiB.
+ * The tree equals the one of xml_document::parse<parse_default | parse_non_destructive>: elements,
+ * data and cdata nodes; element values are the first data child. Values keep their entities,
+ * rxml::value decodes them.
+ */
+template<typename _Ch = char>
+class tape_document
+	: public tape_node<_Ch>
+{
+	typedef rapidxml::internal::lookup_tables<0> tables;
+public:
+	tape_document()
+		: tape_node<_Ch>(&m_storage, 0)
+	{
+		clear();
+	}
+
+	// text must be zero terminated
+	void parse(const _Ch* text)
+	{
+		rxml_assert(text);
+		clear();
+
+		const std::size_t size = rapidxml::internal::measure(text);
+		if(size >= static_cast<std::uint32_t>(-1))
+			throw std::length_error("text is too large for a tape document");
+
+		m_storage.text = text;
+		m_end = text + size;
+
+		// stage 1: structural index
+		std::vector<std::uint32_t> structurals;
+		for(const _Ch* p = scan::find(text, m_end, _Ch('<')); p; p = scan::find(p + 1, m_end, _Ch('<')))
+			structurals.push_back(static_cast<std::uint32_t>(p - text));
+
+		// stage 2: tape, most elements take one start and one end tag
+		m_storage.types.clear();
+		m_storage.links.clear();
+		m_storage.offsets.clear();
+		m_storage.sizes.clear();
+		reserve(structurals.size() + 2);
+
+		std::vector<std::uint32_t> open(1, push(detail::tape_open, nullptr, 0));
+
+		const _Ch* pos = text;
+		if(size >= 3 && index(text[0]) == 0xEF && index(text[1]) == 0xBB && index(text[2]) == 0xBF)
+			pos += 3;
+
+		for(std::uint32_t structural : structurals)
+		{
+			// positions inside comments, cdata and the like were consumed with them
+			const _Ch* markup = text + structural;
+			if(markup < pos)
+				continue;
+
+			append_text(pos, markup, open);
+			pos = parse_markup(markup, open);
+		}
+		append_text(pos, m_end, open);
+
+		if(open.size() != 1)
+			throw rapidxml::parse_error("unexpected end of data", const_cast<_Ch*>(m_end));
+		close(open);
+
+		m_storage.types.shrink_to_fit();
+		m_storage.links.shrink_to_fit();
+		m_storage.offsets.shrink_to_fit();
+		m_storage.sizes.shrink_to_fit();
+	}
+
+	void clear()
+	{
+		static const _Ch empty[1] = { _Ch('\0') };
+		m_storage.text = empty;
+		m_end = empty;
+
+		m_storage.types.assign(2, detail::tape_open);
+		m_storage.types[1] = detail::tape_close;
+		m_storage.links.assign(1, 1);
+		m_storage.links.push_back(0);
+		m_storage.offsets.assign(2, 0);
+		m_storage.sizes.assign(2, 0);
+	}
+
+	// number of entries on the tape
+	std::size_t size() const
+	{
+		return m_storage.size();
+	}
+
+	// bytes allocated for the tape
+	std::size_t memory_size() const
+	{
+		return m_storage.types.capacity() * sizeof(std::uint8_t)
+			+ (m_storage.links.capacity() + m_storage.offsets.capacity() + m_storage.sizes.capacity()) * sizeof(std::uint32_t);
+	}
+
+private:
+	tape_document(const tape_document&);
+	tape_document& operator =(const tape_document&);
+
+	static unsigned char index(_Ch ch)
+	{
+		return static_cast<unsigned char>(ch);
+	}
+
+	void error(const char* what, const _Ch* where) const
+	{
+		throw rapidxml::parse_error(what, const_cast<_Ch*>(where));
+	}
+
+	void reserve(std::size_t entries)
+	{
+		m_storage.types.reserve(entries);
+		m_storage.links.reserve(entries);
+		m_storage.offsets.reserve(entries);
+		m_storage.sizes.reserve(entries);
+	}
+
+	std::uint32_t push(detail::tape_entry_type type, const _Ch* str, std::size_t size)
+	{
+		m_storage.types.push_back(static_cast<std::uint8_t>(type));
+		m_storage.links.push_back(0);
+		m_storage.offsets.push_back(str? static_cast<std::uint32_t>(str - m_storage.text) : 0);
+		m_storage.sizes.push_back(static_cast<std::uint32_t>(size));
+		return static_cast<std::uint32_t>(m_storage.types.size() - 1);
+	}
+
+	// links the innermost open entry with a new close entry
+	void close(std::vector<std::uint32_t>& open)
+	{
+		const std::uint32_t entry = push(detail::tape_close, nullptr, 0);
+		m_storage.links[entry] = open.back();
+		m_storage.links[open.back()] = entry;
+		open.pop_back();
+	}
+
+	const _Ch* skip_whitespace(const _Ch* text) const
+	{
+		while(tables::lookup_whitespace[index(*text)])
+			++text;
+		return text;
+	}
+
+	// whitespace-only text is dropped
+	void append_text(const _Ch* begin, const _Ch* end, const std::vector<std::uint32_t>& open)
+	{
+		const _Ch* p = begin;
+		while(p < end && tables::lookup_whitespace[index(*p)])
+			++p;
+		if(p == end)
+			return;
+
+		if(open.size() == 1)
+			error("expected <", p);
+		push(detail::tape_data, begin, end - begin);
+	}
+
+	// text points at '<', returns the position after the markup
+	const _Ch* parse_markup(const _Ch* text, std::vector<std::uint32_t>& open)
+	{
+		if(text[1] == _Ch('/'))
+			return parse_end_tag(text + 2, open);
+
+		if(text[1] == _Ch('!') && scan::skip_past(text, text + std::min<std::size_t>(9, m_end - text), "<![CDATA["))
+		{
+			const _Ch* end = scan::skip_past(text + 9, m_end, "]]>");
+			if(!end)
+				error("unexpected end of data", m_end);
+			push(detail::tape_cdata, text + 9, end - 3 - (text + 9));
+			return end;
+		}
+
+		if(text[1] == _Ch('!') || text[1] == _Ch('?'))
+		{
+			int depth_change;
+			const _Ch* end = scan::skip_markup(text, m_end, depth_change);
+			if(!end)
+				error("unexpected end of data", m_end);
+			return end;
+		}
+
+		return parse_start_tag(text + 1, open);
+	}
+
+	const _Ch* parse_start_tag(const _Ch* text, std::vector<std::uint32_t>& open)
+	{
+		const _Ch* name = text;
+		while(tables::lookup_node_name[index(*text)])
+			++text;
+		if(text == name)
+			error("expected element name", text);
+		open.push_back(push(detail::tape_open, name, text - name));
+
+		while(true)
+		{
+			text = skip_whitespace(text);
+
+			const _Ch* attr_name = text;
+			while(tables::lookup_attribute_name[index(*text)])
+				++text;
+			if(text == attr_name)
+				break;
+			push(detail::tape_attribute, attr_name, text - attr_name);
+
+			text = skip_whitespace(text);
+			if(*text != _Ch('='))
+				error("expected =", text);
+			text = skip_whitespace(text + 1);
+
+			const _Ch quote = *text;
+			if(quote != _Ch('\'') && quote != _Ch('"'))
+				error("expected ' or \"", text);
+			const _Ch* value = ++text;
+			while(*text && *text != quote)
+				++text;
+			if(*text != quote)
+				error("expected ' or \"", text);
+			push(detail::tape_value, value, text - value);
+			++text;
+		}
+
+		const bool empty = *text == _Ch('/');
+		if(empty)
+			++text;
+		if(*text != _Ch('>'))
+			error("expected >", text);
+
+		if(empty)
+			close(open);
+		return text + 1;
+	}
+
+	const _Ch* parse_end_tag(const _Ch* text, std::vector<std::uint32_t>& open)
+	{
+		const _Ch* name = text;
+		while(tables::lookup_node_name[index(*text)])
+			++text;
+		const std::size_t name_size = text - name;
+
+		text = skip_whitespace(text);
+		if(*text != _Ch('>'))
+			error("expected >", text);
+
+		if(open.size() == 1)
+			error("unexpected closing tag", name);
+		if(!m_storage.matches(open.back(), name, name_size, true))
+			error("invalid closing tag name", name);
+
+		close(open);
+		return text + 1;
+	}
+
+	detail::tape_storage<_Ch> m_storage;
+	const _Ch* m_end;
+};
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,641 @@
+#pragma once
+#ifndef _RXML_TRACKED_HPP
+#define _RXML_TRACKED_HPP
+
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "error.hpp"
+#include "scanner.hpp"
+#include "serialize.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### tracked_document ###########################################
+/*
+ * Document that remembers its source text and the edits made through it, so that writing it back
+ * copies the untouched parts of the source verbatim and only serializes what was edited.
+ *
+ * Edits are tracked as patches of the source: a changed value replaces the node, a changed name or
+ * attribute replaces the tags of the element, a removed node cuts its text and the whitespace before
+ * it, inserted nodes are serialized (without indentation, after the indentation of their neighbour)
+ * in place. Everything between patches is copied as is, so writing back costs a memcpy of the
+ * document plus the serialization of the edits. Nodes moved by remove_node and insert_node are
+ * serialized like new ones.
+ *
+ * Every construct of the source has to be a node to know where it ends, so parse() adds the flags
+ * for comment, pi, declaration and doctype nodes; data nodes must not be disabled.
+ * Edits made directly on the nodes, bypassing this class, are not written back.
+ */
+template<typename _Ch = char>
+class tracked_document
+{
+public:
+	typedef rapidxml::xml_document<_Ch> document_type;
+	typedef rapidxml::xml_node<_Ch> node_type;
+	typedef rapidxml::xml_attribute<_Ch> attribute_type;
+
+	static const int required_flags = rapidxml::parse_comment_nodes | rapidxml::parse_pi_nodes
+									| rapidxml::parse_declaration_node | rapidxml::parse_doctype_node;
+
+	tracked_document()
+		: m_source(nullptr)
+		, m_buffer(nullptr)
+		, m_size(0)
+	{
+	}
+
+	// copies the text, so it does not need to outlive the document
+	template<int _Flags>
+	void parse(const _Ch* text, std::size_t size = 0)
+	{
+		static_assert(!(_Flags & rapidxml::parse_no_data_nodes), "tracked documents need data nodes");
+
+		if(!size)
+			size = rapidxml::internal::measure(text);
+
+		m_nodes.clear();
+		m_removed.clear();
+		m_document.clear();
+
+		m_size = size;
+		m_source = m_document.allocate_string(text, size);
+		m_buffer = m_document.allocate_string(nullptr, size + 1);
+		std::memcpy(m_buffer, text, size * sizeof(_Ch));
+		m_buffer[size] = _Ch('\0');
+
+		m_document.template parse<_Flags | required_flags>(m_buffer);
+	}
+
+	template<int _Flags>
+	void parse(const std::basic_string<_Ch>& text)
+	{
+		parse<_Flags>(text.data(), text.size());
+	}
+
+	// for reading and allocating; edits have to go through the functions below
+	document_type& document()				{ return m_document; }
+	const document_type& document() const	{ return m_document; }
+
+	// true if anything was edited since parsing
+	bool modified() const
+	{
+		return !m_removed.empty() || std::any_of(m_nodes.begin(), m_nodes.end(),
+			[](const typename node_map::value_type& entry) { return entry.second.marks != 0; });
+	}
+
+
+	// ############################ edits ############################
+	// strings are copied into the document
+
+	void name(node_type* node, const _Ch* name, std::size_t size = 0)
+	{
+		if(original(node))
+			mark(node, node->type() == rapidxml::node_element? (tag_dirty | name_dirty) : value_dirty);
+		node->name(copy(name, size), size? size : rapidxml::internal::measure(name));
+	}
+
+	// setting the value of an element sets the value of its data node, if it has only this one child
+	void value(node_type* node, const _Ch* value, std::size_t size = 0)
+	{
+		if(!size)
+			size = rapidxml::internal::measure(value);
+		const _Ch* text = copy(value, size);
+
+		if(node->type() == rapidxml::node_element)
+		{
+			node_type* child = node->first_node();
+			if(child && !child->next_sibling() && child->type() == rapidxml::node_data)
+			{
+				if(original(child))
+					mark(child, value_dirty);
+				child->value(text, size);
+			}else if(!child && original(node))
+				mark(node, self_closing(node)? replaced : value_dirty);
+		}else if(original(node))
+			mark(node, value_dirty);
+
+		node->value(text, size);
+	}
+
+	void name(attribute_type* attr, const _Ch* name, std::size_t size = 0)
+	{
+		touch_tag(attr->parent());
+		attr->name(copy(name, size), size? size : rapidxml::internal::measure(name));
+	}
+
+	void value(attribute_type* attr, const _Ch* value, std::size_t size = 0)
+	{
+		touch_tag(attr->parent());
+		attr->value(copy(value, size), size? size : rapidxml::internal::measure(value));
+	}
+
+	void append_attribute(node_type* node, attribute_type* attr)
+	{
+		touch_tag(node);
+		node->append_attribute(attr);
+	}
+
+	void remove_attribute(node_type* node, attribute_type* attr)
+	{
+		touch_tag(node);
+		node->remove_attribute(attr);
+	}
+
+	// inserts child before where, or at the end if where is nullptr
+	void insert_node(node_type* parent, node_type* where, node_type* child)
+	{
+		if(original(parent))
+		{
+			change_children(parent);
+			if(parent->type() == rapidxml::node_element && self_closing(parent))
+				mark(parent, replaced);
+		}
+		m_nodes[child].marks |= inserted;
+		parent->insert_node(where, child);
+	}
+
+	void append_node(node_type* parent, node_type* child)
+	{
+		insert_node(parent, nullptr, child);
+	}
+
+	void remove_node(node_type* child)
+	{
+		node_type* parent = child->parent();
+		rxml_assert(parent);
+
+		if(original(child))
+		{
+			change_children(parent);
+
+			// the node goes with the whitespace before it, which usually is its indentation
+			const _Ch* begin = begin_of(child);
+			if(child->type() != rapidxml::node_data || trimmed())
+				begin = skip_whitespace_back(begin);
+			m_removed.push_back(patch(begin, proper_end(child), patch_remove, child));
+		}
+		parent->remove_node(child);
+	}
+
+
+	// ############################ output ############################
+
+	std::size_t serialized_size() const
+	{
+		detail::size_counter<_Ch> counter;
+		emit(counter);
+		return counter.size;
+	}
+
+	// writes serialized_size() characters without a terminating zero, returns the position after them
+	_Ch* serialize_to(_Ch* buffer) const
+	{
+		detail::buffer_writer<_Ch> writer(buffer);
+		emit(writer);
+		return writer.out;
+	}
+
+	std::basic_string<_Ch> serialize() const
+	{
+		std::basic_string<_Ch> result(serialized_size(), _Ch());
+		if(!result.empty())
+			serialize_to(&result[0]);
+		return result;
+	}
+
+private:
+	tracked_document(const tracked_document&);
+	tracked_document& operator =(const tracked_document&);
+
+	enum marks
+	{
+		value_dirty	= 1 << 0,	// the node is serialized again
+		tag_dirty	= 1 << 1,	// the start tag of the element is serialized again
+		name_dirty	= 1 << 2,	// so is the end tag
+		inserted	= 1 << 3,	// the node has no source
+		replaced	= 1 << 4,	// the element is serialized again with all its descendants
+		children	= 1 << 5	// the children of the node changed, their ranges are snapshots
+	};
+
+	struct node_info
+	{
+		node_info()
+			: begin(nullptr)
+			, end(nullptr)
+			, marks(0)
+			, snapshot(false)
+		{
+		}
+
+		const _Ch* begin;	// first character of the node in the source
+		const _Ch* end;		// begin of the next node or of the end tag of the parent
+		unsigned marks;
+		bool snapshot;
+	};
+
+	typedef std::unordered_map<const node_type*, node_info> node_map;
+
+	enum patch_kind
+	{
+		patch_remove,
+		patch_node,
+		patch_start_tag,
+		patch_end_tag,
+		patch_value,
+		patch_insert
+	};
+
+	struct patch
+	{
+		patch(const _Ch* begin, const _Ch* end, patch_kind kind, const node_type* node)
+			: begin(begin)
+			, end(end)
+			, kind(kind)
+			, node(node)
+			, indent_begin(nullptr)
+			, indent_end(nullptr)
+		{
+		}
+
+		// insertions come first, then the larger of nested patches
+		bool operator <(const patch& other) const
+		{
+			if(begin != other.begin)
+				return begin < other.begin;
+			if((begin == end) != (other.begin == other.end))
+				return begin == end;
+			return end > other.end;
+		}
+
+		const _Ch* begin;
+		const _Ch* end;
+		patch_kind kind;
+		const node_type* node;
+		const _Ch* indent_begin;	// whitespace written before inserted nodes
+		const _Ch* indent_end;
+	};
+
+
+	// ############################ source ranges ############################
+
+	_Ch* copy(const _Ch* text, std::size_t size)
+	{
+		return m_document.allocate_string(text, size? size : rapidxml::internal::measure(text));
+	}
+
+	const _Ch* source_end() const
+	{
+		return m_source + m_size;
+	}
+
+	// maps a pointer into the parsed buffer to the source
+	const _Ch* to_source(const _Ch* p) const
+	{
+		return (p >= m_buffer && p <= m_buffer + m_size)? m_source + (p - m_buffer) : nullptr;
+	}
+
+	static bool is_whitespace(_Ch ch)
+	{
+		return scan::is_whitespace(ch);
+	}
+
+	const _Ch* skip_whitespace_back(const _Ch* p) const
+	{
+		while(p > m_source && is_whitespace(p[-1]))
+			--p;
+		return p;
+	}
+
+	static const _Ch* back_to_markup(const _Ch* p)
+	{
+		while(*p != _Ch('<'))
+			--p;
+		return p;
+	}
+
+	const node_info* info(const node_type* node) const
+	{
+		auto it = m_nodes.find(node);
+		return it != m_nodes.end()? &it->second : nullptr;
+	}
+
+	unsigned marks_of(const node_type* node) const
+	{
+		const node_info* i = info(node);
+		return i? i->marks : 0;
+	}
+
+	// the node and all its ancestors come from the source
+	bool original(const node_type* node) const
+	{
+		for(; node; node = node->parent())
+		{
+			if(node == &m_document)
+				return true;
+			if(marks_of(node) & inserted)
+				return false;
+		}
+		return false;
+	}
+
+	const _Ch* begin_of(const node_type* node) const
+	{
+		const node_info* i = info(node);
+		if(i && i->snapshot)
+			return i->begin;
+
+		const _Ch* p = nullptr;
+		switch(node->type())
+		{
+		case rapidxml::node_element:
+			p = to_source(node->name());
+			return p? p - 1 : begin_after_previous(node);
+
+		case rapidxml::node_data:
+			p = to_source(node->value());
+			return p? p : begin_after_previous(node);
+
+		case rapidxml::node_pi:
+			p = to_source(node->name());
+			break;
+
+		case rapidxml::node_declaration:
+			p = node->first_attribute()? to_source(node->first_attribute()->name()) : nullptr;
+			break;
+
+		default:
+			p = to_source(node->value());
+			break;
+		}
+		return p? back_to_markup(p) : begin_after_previous(node);
+	}
+
+	// for nodes without pointers into the source, e.g. a declaration without attributes
+	const _Ch* begin_after_previous(const node_type* node) const
+	{
+		const _Ch* p = node->previous_sibling()? proper_end(node->previous_sibling()) : content_begin(node->parent());
+		while(p < source_end() && is_whitespace(*p))
+			++p;
+		return p;
+	}
+
+	const _Ch* end_of(const node_type* node) const
+	{
+		const node_info* i = info(node);
+		if(i && i->snapshot)
+			return i->end;
+		return node->next_sibling()? begin_of(node->next_sibling()) : content_end(node->parent());
+	}
+
+	// data nodes include the whitespace around them unless it was trimmed
+	bool trimmed() const
+	{
+		return (m_document.parse_flags() & rapidxml::parse_trim_whitespace) != 0;
+	}
+
+	// end of the node without the whitespace after it; the range of a data node matches its value on both sides
+	const _Ch* proper_end(const node_type* node) const
+	{
+		const _Ch* end = end_of(node);
+		return (node->type() == rapidxml::node_data && !trimmed())? end : skip_whitespace_back(end);
+	}
+
+	const _Ch* start_tag_end(const node_type* element, bool& empty) const
+	{
+		empty = false;
+		const _Ch* end = scan::skip_tag(begin_of(element) + 1, source_end(), empty);
+		rxml_assert(end);
+		return end;
+	}
+
+	bool self_closing(const node_type* element) const
+	{
+		bool empty;
+		start_tag_end(element, empty);
+		return empty;
+	}
+
+	const _Ch* content_begin(const node_type* node) const
+	{
+		bool empty;
+		return node == &m_document? m_source : start_tag_end(node, empty);
+	}
+
+	const _Ch* content_end(const node_type* node) const
+	{
+		return node == &m_document? source_end() : back_to_markup(proper_end(node) - 1);
+	}
+
+
+	// ############################ marks ############################
+
+	// keeps the range of the node from before the edit
+	void snapshot(const node_type* node)
+	{
+		if(node == &m_document)
+			return;
+		node_info& i = m_nodes[node];
+		if(!i.snapshot)
+		{
+			const _Ch* begin = begin_of(node);
+			const _Ch* end = end_of(node);
+			i.begin = begin;
+			i.end = end;
+			i.snapshot = true;
+		}
+	}
+
+	void mark(const node_type* node, unsigned marks)
+	{
+		snapshot(node);
+		m_nodes[node].marks |= marks;
+	}
+
+	// only elements have tags of their own, a declaration is serialized as a whole
+	void touch_tag(node_type* node)
+	{
+		if(node && original(node))
+			mark(node, node->type() == rapidxml::node_element? tag_dirty : value_dirty);
+	}
+
+	// the ranges of siblings depend on each other, so all are kept before the first structural change
+	void change_children(node_type* parent)
+	{
+		if(marks_of(parent) & children)
+			return;
+		for(node_type* child = parent->first_node(); child; child = child->next_sibling())
+		{
+			if(!(marks_of(child) & inserted))
+				snapshot(child);
+		}
+		snapshot(parent);
+		m_nodes[parent].marks |= children;
+	}
+
+	// the node is in the document and no ancestor is serialized as a whole
+	bool written_in_place(const node_type* node) const
+	{
+		if(!node->parent())
+			return node == &m_document;
+		for(const node_type* p = node->parent(); p; p = p->parent())
+		{
+			if(p == &m_document)
+				return true;
+			if(marks_of(p) & (inserted | replaced))
+				return false;
+		}
+		return false;
+	}
+
+	// the first original node before or after node, skipping inserted ones
+	const node_type* original_sibling(const node_type* node, bool forward) const
+	{
+		do
+			node = forward? node->next_sibling() : node->previous_sibling();
+		while(node && (marks_of(node) & inserted));
+		return node;
+	}
+
+	void collect(std::vector<patch>& patches) const
+	{
+		patches.insert(patches.end(), m_removed.begin(), m_removed.end());
+
+		for(auto& entry : m_nodes)
+		{
+			const node_type* node = entry.first;
+			const unsigned marks = entry.second.marks;
+			if(!(marks & ~children) || !written_in_place(node))
+				continue;
+
+			if(marks & inserted)
+			{
+				// a run of inserted siblings is written by its first node
+				const node_type* previous = node->previous_sibling();
+				if(previous && (marks_of(previous) & inserted))
+					continue;
+
+				const node_type* parent = node->parent();
+				const node_type* before = original_sibling(node, false);
+				const node_type* after = original_sibling(node, true);
+				const node_type* neighbour = before? before : after;
+
+				const _Ch* at = before? proper_end(before) : content_begin(parent);
+				patch p(at, at, patch_insert, node);
+				if(neighbour && neighbour->type() != rapidxml::node_data)
+				{
+					p.indent_end = begin_of(neighbour);
+					p.indent_begin = skip_whitespace_back(p.indent_end);
+				}
+				patches.push_back(p);
+				continue;
+			}
+
+			if(marks & (replaced | value_dirty))
+			{
+				if(node->type() == rapidxml::node_element && !(marks & replaced))
+				{
+					bool empty;
+					patches.push_back(patch(start_tag_end(node, empty), content_end(node), patch_value, node));
+				}else
+					patches.push_back(patch(begin_of(node), proper_end(node), patch_node, node));
+				if(marks & replaced)
+					continue;
+			}
+
+			if(marks & tag_dirty)
+			{
+				bool empty;
+				patches.push_back(patch(begin_of(node), start_tag_end(node, empty), patch_start_tag, node));
+				if((marks & name_dirty) && !empty)
+					patches.push_back(patch(content_end(node), proper_end(node), patch_end_tag, node));
+			}
+		}
+
+		std::sort(patches.begin(), patches.end());
+	}
+
+	template<typename _Sink>
+	void emit(_Sink& sink) const
+	{
+		std::vector<patch> patches;
+		collect(patches);
+
+		detail::serializer<_Ch, _Sink> serializer(sink, rapidxml::print_no_indenting);
+		const _Ch* at = m_source;
+		for(const patch& p : patches)
+		{
+			// nested in a patch already applied
+			if(p.begin < at)
+				continue;
+
+			sink.put(at, p.begin - at);
+			at = p.end;
+
+			const node_type* node = p.node;
+			switch(p.kind)
+			{
+			case patch_remove:
+				break;
+
+			case patch_node:
+				serializer.node(node, 0);
+				break;
+
+			case patch_value:
+				serializer.escaped(node->value(), node->value_size(), _Ch(0));
+				break;
+
+			case patch_start_tag:
+				{
+					bool empty;
+					start_tag_end(node, empty);
+					sink.put(_Ch('<'));
+					sink.put(node->name(), node->name_size());
+					serializer.attributes(node);
+					if(empty)
+						sink.literal("/>");
+					else
+						sink.put(_Ch('>'));
+				}
+				break;
+
+			case patch_end_tag:
+				sink.literal("</");
+				sink.put(node->name(), node->name_size());
+				sink.put(_Ch('>'));
+				break;
+
+			case patch_insert:
+				for(; node && (marks_of(node) & inserted); node = node->next_sibling())
+				{
+					if(p.indent_begin)
+						sink.put(p.indent_begin, p.indent_end - p.indent_begin);
+					serializer.node(node, 0);
+				}
+				break;
+			}
+		}
+		sink.put(at, source_end() - at);
+	}
+
+	// declared first, the pool holds the texts
+	document_type m_document;
+	_Ch* m_source;		// copy of the parsed text
+	_Ch* m_buffer;		// text parsed in place
+	std::size_t m_size;
+	node_map m_nodes;
+	std::vector<patch> m_removed;
+};
+
+
+}
+
+
+
+#endif
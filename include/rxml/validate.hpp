@@ -0,0 +1,431 @@
+#pragma once
+#ifndef _RXML_VALIDATE_HPP
+#define _RXML_VALIDATE_HPP
+
+#include <rapidxml.hpp>
+#include <string>
+#include <vector>
+#include "error.hpp"
+#include "scanner.hpp"
+
+
+namespace rxml {
+
+
+// ########################################### validation_result ###########################################
+struct validation_result
+{
+	validation_result()
+		: what(nullptr)
+		, offset(0)
+	{
+	}
+
+	// true if the text is well-formed
+	explicit operator bool() const
+	{
+		return !what;
+	}
+
+	const char* what;		// message of the first error as rapidxml::parse_error would have it, nullptr if there is none
+	std::size_t offset;		// byte offset of the first error in the text
+};
+
+
+namespace detail {
+
+	// makes the character predicates of the parser accessible; never instantiated
+	template<typename _Ch>
+	struct parser_grammar
+		: public rapidxml::xml_document<_Ch>
+	{
+		typedef rapidxml::xml_document<_Ch> base_type;
+
+		typedef typename base_type::whitespace_pred whitespace_pred;
+		typedef typename base_type::node_name_pred node_name_pred;
+		typedef typename base_type::attribute_name_pred attribute_name_pred;
+
+	private:
+		parser_grammar();
+	};
+
+
+	// ########################################### validator ###########################################
+	/*
+	 * Walks the text with the grammar of xml_document::parse<_Flags> without building nodes.
+	 * Elements are tracked by a depth counter instead of recursion; their names are only kept,
+	 * in a fixed stack of _MaxDepth entries, if closing tags are validated. With rapidxml::parse_namespaces
+	 * the declared prefixes are kept to find unbound element prefixes like the parser does.
+	 */
+	template<typename _Ch, int _Flags, std::size_t _MaxDepth>
+	class validator
+	{
+		typedef parser_grammar<_Ch> grammar;
+		typedef typename grammar::whitespace_pred whitespace_pred;
+		typedef typename grammar::node_name_pred node_name_pred;
+		typedef typename grammar::attribute_name_pred attribute_name_pred;
+
+		static const bool check_names = (_Flags & rapidxml::parse_validate_closing_tags) != 0;
+		static const bool check_namespaces = (_Flags & rapidxml::parse_namespaces) != 0;
+
+		struct open_element
+		{
+			const _Ch* name;
+			std::size_t name_size;
+		};
+
+		struct prefix
+		{
+			const _Ch* name;
+			std::size_t size;
+		};
+
+	public:
+		explicit validator(const _Ch* text)
+			: m_begin(text)
+			, m_end(const_cast<_Ch*>(text) + rapidxml::internal::measure(text))
+			, m_depth(0)
+		{
+		}
+
+		validation_result run()
+		{
+			_Ch* text = const_cast<_Ch*>(m_begin);
+
+			// skip utf-8 bom
+			if(index(text[0]) == 0xEF && index(text[1]) == 0xBB && index(text[2]) == 0xBF)
+				text += 3;
+
+			while(text)
+			{
+				skip<whitespace_pred>(text);
+
+				if(*text == _Ch('<'))
+				{
+					if(m_depth && text[1] == _Ch('/'))
+						text = end_tag(text + 2);
+					else
+						text = node(text + 1);
+				}else if(!*text)
+				{
+					if(!m_depth)
+						break;
+					text = fail("unexpected end of data", text);
+				}else if(m_depth)
+					text = value(text, _Ch('<'));
+				else
+					text = fail("expected <", text);
+			}
+
+			return m_result;
+		}
+
+	private:
+		static unsigned char index(_Ch ch)
+		{
+			return static_cast<unsigned char>(ch);
+		}
+
+		// names and whitespace are short, so a plain table lookup beats the vectorized skip of the parser
+		template<typename _Pred>
+		static void skip(_Ch*& text)
+		{
+			while(_Pred::test(*text))
+				++text;
+		}
+
+		_Ch* fail(const char* what, const _Ch* where)
+		{
+			m_result.what = what;
+			m_result.offset = (where - m_begin) * sizeof(_Ch);
+			return nullptr;
+		}
+
+		_Ch* skip_past(_Ch* text, const char* seq)
+		{
+			_Ch* end = scan::skip_past(text, m_end, seq);
+			return end? end : fail("unexpected end of data", m_end);
+		}
+
+		// text points after '<'
+		_Ch* node(_Ch* text)
+		{
+			switch(text[0])
+			{
+			default:
+				return start_tag(text);
+
+			case _Ch('?'):
+				++text;
+				if((text[0] == _Ch('x') || text[0] == _Ch('X')) &&
+					(text[1] == _Ch('m') || text[1] == _Ch('M')) &&
+					(text[2] == _Ch('l') || text[2] == _Ch('L')) &&
+					whitespace_pred::test(text[3]))
+				{
+					text += 4;
+					if(!(_Flags & rapidxml::parse_declaration_node))
+						return skip_past(text, "?>");
+
+					skip<whitespace_pred>(text);
+					text = attributes(text);
+					if(text && (text[0] != _Ch('?') || text[1] != _Ch('>')))
+						return fail("expected ?>", text);
+					return text? text + 2 : nullptr;
+				}
+
+				if(_Flags & rapidxml::parse_pi_nodes)
+				{
+					const _Ch* name = text;
+					skip<node_name_pred>(text);
+					if(text == name)
+						return fail("expected PI target", text);
+				}
+				return skip_past(text, "?>");
+
+			case _Ch('!'):
+				if(text[1] == _Ch('-') && text[2] == _Ch('-'))
+					return skip_past(text + 3, "-->");
+
+				if(text[1] == _Ch('[') && text[2] == _Ch('C') && text[3] == _Ch('D') && text[4] == _Ch('A') &&
+					text[5] == _Ch('T') && text[6] == _Ch('A') && text[7] == _Ch('['))
+					return skip_past(text + 8, "]]>");
+
+				if(text[1] == _Ch('D') && text[2] == _Ch('O') && text[3] == _Ch('C') && text[4] == _Ch('T') &&
+					text[5] == _Ch('Y') && text[6] == _Ch('P') && text[7] == _Ch('E') && whitespace_pred::test(text[8]))
+					return doctype(text + 9);
+
+				// unrecognized <! node
+				text = scan::find(text + 1, m_end, _Ch('>'));
+				return text? text + 1 : fail("unexpected end of data", m_end);
+			}
+		}
+
+		// same bracket matching as the parser
+		_Ch* doctype(_Ch* text)
+		{
+			while(*text != _Ch('>'))
+			{
+				if(*text == _Ch('['))
+				{
+					++text;
+					for(int depth = 1; depth > 0; ++text)
+					{
+						if(*text == _Ch('['))
+							++depth;
+						else if(*text == _Ch(']'))
+							--depth;
+						else if(!*text)
+							return fail("unexpected end of data", text);
+					}
+				}else if(!*text)
+					return fail("unexpected end of data", text);
+				else
+					++text;
+			}
+			return text + 1;
+		}
+
+		// text points at the element name
+		_Ch* start_tag(_Ch* text)
+		{
+			const _Ch* name = text;
+			skip<node_name_pred>(text);
+			if(text == name)
+				return fail("expected element name", text);
+			const std::size_t name_size = text - name;
+
+			const std::size_t scope = m_prefixes.size();
+			skip<whitespace_pred>(text);
+			text = attributes(text, check_namespaces);
+			if(!text)
+				return nullptr;
+			if(check_namespaces && !bound(name, name_size))
+				return fail("unbound namespace prefix", name);
+
+			if(*text == _Ch('>'))
+			{
+				if(check_names)
+				{
+					if(m_depth == _MaxDepth)
+						return fail("element nesting too deep", name);
+					m_elements[m_depth].name = name;
+					m_elements[m_depth].name_size = name_size;
+				}
+				if(check_namespaces)
+					m_scopes.push_back(scope);
+				++m_depth;
+				return text + 1;
+			}
+
+			if(*text == _Ch('/'))
+			{
+				++text;
+				if(*text != _Ch('>'))
+					return fail("expected >", text);
+				m_prefixes.resize(scope);
+				return text + 1;
+			}
+			return fail("expected >", text);
+		}
+
+		// same lookup as xml_document::resolve_namespace; names without prefix are always bound
+		bool bound(const _Ch* name, std::size_t name_size) const
+		{
+			const _Ch* colon = std::char_traits<_Ch>::find(name, name_size, _Ch(':'));
+			if(!colon)
+				return true;
+
+			const std::size_t size = colon - name;
+			for(std::size_t i = m_prefixes.size(); i-- > 0; )
+			{
+				if(rapidxml::internal::compare(m_prefixes[i].name, m_prefixes[i].size, name, size, true))
+					return true;
+			}
+			return size == 3 && name[0] == _Ch('x') && name[1] == _Ch('m') && name[2] == _Ch('l');
+		}
+
+		// xmlns binds the empty prefix, xmlns:p binds p
+		void declare(const _Ch* name, std::size_t size)
+		{
+			static const _Ch xmlns[] = { _Ch('x'), _Ch('m'), _Ch('l'), _Ch('n'), _Ch('s') };
+			if(size < 5 || !rapidxml::internal::compare(name, 5, xmlns, 5, true) || (size > 5 && (name[5] != _Ch(':') || size == 6)))
+				return;
+
+			prefix binding = { size > 5? name + 6 : name + 5, size > 5? size - 6 : 0 };
+			m_prefixes.push_back(binding);
+		}
+
+		// text points after '</'
+		_Ch* end_tag(_Ch* text)
+		{
+			const _Ch* name = text;
+			skip<node_name_pred>(text);
+			if(check_names)
+			{
+				const open_element& element = m_elements[m_depth - 1];
+				if(!rapidxml::internal::compare(element.name, element.name_size, name, text - name, true))
+					return fail("invalid closing tag name", text);
+			}
+
+			skip<whitespace_pred>(text);
+			if(*text != _Ch('>'))
+				return fail("expected >", text);
+			--m_depth;
+			if(check_namespaces)
+			{
+				m_prefixes.resize(m_scopes.back());
+				m_scopes.pop_back();
+			}
+			return text + 1;
+		}
+
+		// declarations of the attributes are put in scope if declare is set
+		_Ch* attributes(_Ch* text, bool declare = false)
+		{
+			while(attribute_name_pred::test(*text))
+			{
+				const _Ch* name = text;
+				++text;
+				skip<attribute_name_pred>(text);
+				if(declare)
+					this->declare(name, text - name);
+				skip<whitespace_pred>(text);
+				if(*text != _Ch('='))
+					return fail("expected =", text);
+				++text;
+				skip<whitespace_pred>(text);
+
+				const _Ch quote = *text;
+				if(quote != _Ch('\'') && quote != _Ch('"'))
+					return fail("expected ' or \"", text);
+
+				text = value(text + 1, quote);
+				if(!text)
+					return nullptr;
+				if(*text != quote)
+					return fail("expected ' or \"", text);
+				++text;
+				skip<whitespace_pred>(text);
+			}
+			return text;
+		}
+
+		// skips a value up to the first stop character, checking numeric character references like the parser expands them;
+		// the text has no zero before m_end, so values are found by memchr-like scans instead of the parser's predicates
+		_Ch* value(_Ch* text, _Ch stop)
+		{
+			_Ch* end = scan::find(text, m_end, stop);
+			if(!end)
+				end = m_end;
+			if(_Flags & rapidxml::parse_no_entity_translation)
+				return end;
+
+			while((text = scan::find(text, end, _Ch('&'))))
+			{
+				const _Ch* amp = text;
+				if(text[1] != _Ch('#'))
+				{
+					++text;
+					continue;
+				}
+
+				const bool hex = text[2] == _Ch('x');
+				text += hex? 3 : 2;
+				unsigned long code = 0;
+				for(unsigned char digit; (digit = rapidxml::internal::lookup_tables<0>::lookup_digits[index(*text)]) != 0xFF; ++text)
+					code = code * (hex? 16 : 10) + digit;
+
+				// the parser reports this at its write position, which is at or before the reference
+				if(!(_Flags & rapidxml::parse_no_utf8) && code >= 0x110000)
+					return fail("invalid numeric character entity", amp);
+				if(*text != _Ch(';'))
+					return fail("expected ;", text);
+				++text;
+			}
+			return end;
+		}
+
+		const _Ch* m_begin;
+		_Ch* m_end;
+		std::size_t m_depth;
+		open_element m_elements[check_names? _MaxDepth : 1];
+		std::vector<prefix> m_prefixes;		// declared prefixes, innermost last
+		std::vector<std::size_t> m_scopes;	// number of prefixes declared outside of each open element
+		validation_result m_result;
+	};
+}
+
+
+// ########################################### validate ###########################################
+/*
+ * Checks that xml_document::parse<_Flags> would accept the zero terminated text, without allocating
+ * nodes and without modifying the text.
+ *
+ * The checks are those of the parser: with rapidxml::parse_validate_closing_tags closing tag names
+ * must match, without rapidxml::parse_no_entity_translation numeric character references must be
+ * terminated and in range, with rapidxml::parse_namespaces element prefixes must be declared, and
+ * so on. The result tells the message and the byte offset of the first error, which is where the
+ * parser would have thrown, except for out of range references, which are reported at their '&'.
+ *
+ * If closing tags are validated, open element names are kept in a fixed stack and elements nested
+ * deeper than _MaxDepth are reported as an error. Declared prefixes are kept in a vector.
+ */
+template<int _Flags, std::size_t _MaxDepth = 256, typename _Ch>
+validation_result validate(const _Ch* text)
+{
+	rxml_assert(text);
+	return detail::validator<_Ch, _Flags, _MaxDepth>(text).run();
+}
+
+template<int _Flags, std::size_t _MaxDepth = 256, typename _Ch>
+validation_result validate(const std::basic_string<_Ch>& text)
+{
+	return validate<_Flags, _MaxDepth>(text.c_str());
+}
+
+
+}
+
+
+
+#endif
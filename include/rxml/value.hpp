@@ -5,7 +5,9 @@
 
 #include <rapidxml.hpp>
 #include <regex>
+#include <string>
 #include "get.hpp"
+#include "entities.hpp"
 
 namespace rxml {
 
@@ -52,6 +54,29 @@ namespace detail {
 	{
 		typedef _Ty type;
 	};
+
+	// checks if the document of entity was parsed without entity translation (e.g. parse_non_destructive)
+	template<typename _Ch>
+	bool has_raw_entities(const rapidxml::xml_base<_Ch>& entity)
+	{
+		const rapidxml::xml_node<_Ch>* root = entity.parent();
+		if(!root)
+			return false;
+		root = getroot(root);
+
+		return root->type() == rapidxml::node_document
+			&& (static_cast<const rapidxml::xml_document<_Ch>*>(root)->parse_flags() & rapidxml::parse_no_entity_translation);
+	}
+
+	template<typename _Ch>
+	std::basic_string<_Ch> make_value(const rapidxml::xml_base<_Ch>& entity, const _Ch* val, std::size_t size)
+	{
+		// values of non destructively parsed documents are not terminated and may contain entities
+		if(std::char_traits<_Ch>::find(val, size, _Ch('&')) && has_raw_entities(entity))
+			return decode_entities(val, size);
+
+		return std::basic_string<_Ch>(val, size);
+	}
 }
 
 
@@ -59,7 +84,22 @@ namespace detail {
 template<typename _Ch>
 std::basic_string<_Ch> value(const rapidxml::xml_base<_Ch>& entity)
 {
-	return std::basic_string<_Ch>(entity.value(), entity.value_size());
+	return detail::make_value(entity, entity.value(), entity.value_size());
+}
+
+template<typename _Ch>
+std::basic_string<_Ch> value(const rapidxml::xml_node<_Ch>& node)
+{
+	// xml_node::value() parses deferred content first (see lazy_document)
+	const _Ch* val = node.value();
+	return detail::make_value(node, val, node.value_size());
+}
+
+template<typename _Ch>
+std::basic_string<_Ch> value(const rapidxml::xml_node<_Ch>* node)
+{
+	assert(node);
+	return rxml::value(*node);
 }
 
 template<typename _Ch>
@@ -72,8 +112,9 @@ std::basic_string<_Ch> value(const rapidxml::xml_base<_Ch>* entity)
 template<typename _Ch, typename _TGen>
 std::basic_string<_Ch> value(const rapidxml::xml_node<_Ch>& node, const _Ch* path, _TGen throw_notfound, std::size_t path_size = 0)
 {
-	auto& entity = rxml::get(node, path, throw_notfound, path_size);
-	return rxml::value(entity);
+	if(detail::is_attribute_path(path, path_size))
+		return rxml::value(rxml::getattr(node, path, throw_notfound, path_size));
+	return rxml::value(rxml::getnode(node, path, throw_notfound, path_size));
 }
 
 template<typename _Ch>
@@ -187,7 +228,8 @@ std::basic_string<_Ch> valuefb(const rapidxml::xml_node<_Ch>* node, const _Ch* p
 
 	if(entity)
 	{
-		std::basic_string<_Ch> val(entity->value(), entity->value_size());
+		std::basic_string<_Ch> val = detail::is_attribute_path(path, path_size)? rxml::value(*entity)
+										: rxml::value(*static_cast<const rapidxml::xml_node<_Ch>*>(entity));
 		if(detail::apply_check(val, checker))
 		{
 			return std::move(val);
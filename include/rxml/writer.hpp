@@ -0,0 +1,370 @@
+#pragma once
+#ifndef _RXML_WRITER_HPP
+#define _RXML_WRITER_HPP
+
+#include <rapidxml.hpp>
+#include <rapidxml_print.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "error.hpp"
+
+#if defined(_WIN32)
+#	include <io.h>
+#else
+#	include <unistd.h>
+#endif
+
+
+namespace rxml {
+
+
+// ########################################### writer ###########################################
+/*
+ * Writes xml as a sequence of calls instead of printing a dom. The text is exactly what rapidxml::print
+ * writes for each top level node the calls describe, every text() call being one data node, with the same
+ * indentation (unless rapidxml::print_no_indenting is given) and the same escaping. Printing a whole
+ * document adds one more line break at the end.
+ *
+ * Output goes through a buffer of fixed size that is handed to the sink whenever it is full, so memory
+ * does not grow with the output. Besides the buffer, the writer keeps the names of the open elements and,
+ * when indenting, the first text of an element until it knows whether the element has other children,
+ * because print writes a sole data child without indentation.
+ *
+ * The sink is a callback or a file descriptor. Remaining output is flushed by flush() and by the destructor;
+ * errors of the sink are only reported if flush() is called explicitly.
+ */
+template<typename _Ch = char>
+class writer
+{
+public:
+	typedef std::function<void(const _Ch*, std::size_t)> sink_type;
+
+	static const std::size_t default_buffer_size = 64 * 1024;
+
+	explicit writer(sink_type sink, int flags = 0, std::size_t buffer_size = default_buffer_size)
+		: m_sink(std::move(sink))
+		, m_buffer(std::max<std::size_t>(buffer_size, 16))
+		, m_used(0)
+		, m_indenting(!(flags & rapidxml::print_no_indenting))
+		, m_open(false)
+		, m_has_children(false)
+		, m_has_pending(false)
+	{
+		rxml_assert(m_sink);
+	}
+
+	// the descriptor stays open
+	explicit writer(int fd, int flags = 0, std::size_t buffer_size = default_buffer_size)
+		: writer(fd_sink(fd), flags, buffer_size)
+	{
+	}
+
+	~writer()
+	{
+		try
+		{
+			flush();
+		}catch(...)
+		{
+		}
+	}
+
+	void start_element(const _Ch* name, std::size_t name_size = 0)
+	{
+		if(!name_size)
+			name_size = rapidxml::internal::measure(name);
+
+		child();
+		indent();
+		put(_Ch('<'));
+		put(name, name_size);
+
+		m_elements.push_back(std::basic_string<_Ch>(name, name_size));
+		m_open = true;
+		m_has_children = false;
+	}
+
+	void start_element(const std::basic_string<_Ch>& name)
+	{
+		start_element(name.data(), name.size());
+	}
+
+	// only between start_element and the first content of the element
+	void attribute(const _Ch* name, const _Ch* value, std::size_t name_size = 0, std::size_t value_size = 0)
+	{
+		rxml_assert(m_open && !m_has_children);
+		if(!name_size)
+			name_size = rapidxml::internal::measure(name);
+		if(!value_size)
+			value_size = rapidxml::internal::measure(value);
+
+		put(_Ch(' '));
+		put(name, name_size);
+		put(_Ch('='));
+
+		// values with double quotes are quoted with single ones
+		const bool single = std::char_traits<_Ch>::find(value, value_size, _Ch('"')) != nullptr;
+		const _Ch quote = single? _Ch('\'') : _Ch('"');
+		put(quote);
+		escaped(value, value_size, single? _Ch('"') : _Ch('\''));
+		put(quote);
+	}
+
+	void attribute(const std::basic_string<_Ch>& name, const std::basic_string<_Ch>& value)
+	{
+		attribute(name.data(), value.data(), name.size(), value.size());
+	}
+
+	// escaped data node; empty text writes nothing
+	void text(const _Ch* text, std::size_t size)
+	{
+		if(!size)
+			return;
+
+		if(m_open && !m_has_children && m_indenting)
+		{
+			// the first text is only indented if other children follow
+			m_has_children = true;
+			m_has_pending = true;
+			m_pending.assign(text, size);
+			return;
+		}
+
+		child();
+		indent();
+		escaped(text, size, _Ch(0));
+		newline();
+	}
+
+	void text(const _Ch* text)
+	{
+		this->text(text, rapidxml::internal::measure(text));
+	}
+
+	void text(const std::basic_string<_Ch>& text)
+	{
+		this->text(text.data(), text.size());
+	}
+
+	void cdata(const _Ch* text, std::size_t size)
+	{
+		child();
+		indent();
+		put("<![CDATA[");
+		put(text, size);
+		put("]]>");
+		newline();
+	}
+
+	void comment(const _Ch* text, std::size_t size)
+	{
+		child();
+		indent();
+		put("<!--");
+		put(text, size);
+		put("-->");
+		newline();
+	}
+
+	void end_element()
+	{
+		rxml_assert(!m_elements.empty());
+		const std::basic_string<_Ch>& name = m_elements.back();
+
+		if(m_open && !m_has_children)
+			put("/>");
+		else
+		{
+			if(m_has_pending)
+			{
+				// sole data child, written without indentation
+				end_start_tag();
+				escaped(m_pending.data(), m_pending.size(), _Ch(0));
+				m_has_pending = false;
+			}else
+			{
+				end_start_tag();
+				indent(m_elements.size() - 1);
+			}
+
+			put("</");
+			put(name.data(), name.size());
+			put(_Ch('>'));
+		}
+
+		m_elements.pop_back();
+		m_open = false;
+		m_has_children = true;
+		newline();
+	}
+
+	// number of open elements
+	std::size_t depth() const
+	{
+		return m_elements.size();
+	}
+
+	// hands the buffered output to the sink; text kept back for an open element is not written yet
+	void flush()
+	{
+		if(m_used)
+		{
+			const std::size_t used = m_used;
+			m_used = 0;
+			m_sink(m_buffer.data(), used);
+		}
+	}
+
+private:
+	writer(const writer&);
+	writer& operator =(const writer&);
+
+	static sink_type fd_sink(int fd)
+	{
+		return [fd](const _Ch* data, std::size_t size)
+			{
+				const char* bytes = reinterpret_cast<const char*>(data);
+				std::size_t left = size * sizeof(_Ch);
+				while(left)
+				{
+#if defined(_WIN32)
+					const int written = ::_write(fd, bytes, static_cast<unsigned>(std::min<std::size_t>(left, 1 << 30)));
+#else
+					const ssize_t written = ::write(fd, bytes, left);
+#endif
+					if(written < 0)
+					{
+						if(errno == EINTR)
+							continue;
+						throw std::runtime_error(std::string("cannot write to file descriptor: ") + std::strerror(errno));
+					}
+					bytes += written;
+					left -= written;
+				}
+			};
+	}
+
+	void put(_Ch ch)
+	{
+		if(m_used == m_buffer.size())
+			flush();
+		m_buffer[m_used++] = ch;
+	}
+
+	void put(const _Ch* text, std::size_t size)
+	{
+		if(size > m_buffer.size() - m_used)
+		{
+			flush();
+
+			// too large to be buffered at all
+			if(size >= m_buffer.size())
+			{
+				m_sink(text, size);
+				return;
+			}
+		}
+		std::memcpy(m_buffer.data() + m_used, text, size * sizeof(_Ch));
+		m_used += size;
+	}
+
+	template<std::size_t _N>
+	void put(const char (&text)[_N])
+	{
+		for(std::size_t i = 0; i < _N - 1; ++i)
+			put(_Ch(text[i]));
+	}
+
+	void escaped(const _Ch* text, std::size_t size, _Ch noexpand)
+	{
+		const _Ch* end = text + size;
+		while(text != end)
+		{
+			const _Ch* run = text;
+			text = rapidxml::internal::find_expanded_char(text, end, noexpand);
+			put(run, text - run);
+			if(text == end)
+				break;
+
+			switch(*text++)
+			{
+			case _Ch('<'):	put("&lt;");	break;
+			case _Ch('>'):	put("&gt;");	break;
+			case _Ch('\''):	put("&apos;");	break;
+			case _Ch('"'):	put("&quot;");	break;
+			default:		put("&amp;");	break;
+			}
+		}
+	}
+
+	void end_start_tag()
+	{
+		if(m_open)
+		{
+			put(_Ch('>'));
+			m_open = false;
+		}
+	}
+
+	// prepares the output of a child of the current element
+	void child()
+	{
+		if(m_open)
+		{
+			end_start_tag();
+			newline();
+		}
+		m_has_children = true;
+
+		if(m_has_pending)
+		{
+			// the first text turns out not to be the only child
+			m_has_pending = false;
+			indent();
+			escaped(m_pending.data(), m_pending.size(), _Ch(0));
+			newline();
+		}
+	}
+
+	void indent()
+	{
+		indent(m_elements.size());
+	}
+
+	void indent(std::size_t level)
+	{
+		if(m_indenting)
+		{
+			for(std::size_t i = 0; i < level; ++i)
+				put(_Ch('\t'));
+		}
+	}
+
+	void newline()
+	{
+		if(m_indenting)
+			put(_Ch('\n'));
+	}
+
+	sink_type m_sink;
+	std::vector<_Ch> m_buffer;
+	std::size_t m_used;
+	std::vector<std::basic_string<_Ch>> m_elements;	// names of the open elements
+	std::basic_string<_Ch> m_pending;				// first text of the current element while indenting
+	const bool m_indenting;
+	bool m_open;			// the start tag of the current element misses its '>'
+	bool m_has_children;	// the current element has content
+	bool m_has_pending;
+};
+
+
+}
+
+
+
+#endif
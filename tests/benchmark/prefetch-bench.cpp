@@ -0,0 +1,169 @@
+/************************************************
+ *
+ *	Compares plain sibling iteration with iteration
+ *	using sibling_prefetch, and with a walk over the
+ *	materialized child array, on long sibling chains.
+ *	The chain is walked in parse order and after a
+ *	shuffle simulating edits, each with a warm and a
+ *	cold cache and with more or less work per node.
+ *
+ ************************************************/
+#include <rapidxml.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "rxml/iterators.hpp"
+#include "rxml/child_array.hpp"
+
+namespace {
+
+	const std::size_t node_count = 1 << 20;
+	const std::size_t cache_flush_size = 64 << 20;
+	const int repetitions = 5;
+
+	std::vector<char> cache_flush_buffer(cache_flush_size, 1);
+	volatile std::size_t sink = 0;
+
+	void flush_cache()
+	{
+		std::size_t sum = 0;
+		for(std::size_t i = 0; i < cache_flush_buffer.size(); i += 64)
+		{
+			cache_flush_buffer[i] += 1;
+			sum += cache_flush_buffer[i];
+		}
+		sink = sink + sum;
+	}
+
+	void build_chain(rapidxml::memory_pool<>& pool, rapidxml::xml_node<>& parent)
+	{
+		char buffer[32];
+		for(std::size_t i = 0; i < node_count; ++i)
+		{
+			std::snprintf(buffer, sizeof(buffer), "entry-%u", static_cast<unsigned>(i % 64));
+			char* name = pool.allocate_string(buffer);
+			std::snprintf(buffer, sizeof(buffer), "value-%u", static_cast<unsigned>(i));
+			char* value = pool.allocate_string(buffer);
+			parent.append_node(pool.allocate_node(rapidxml::node_element, name, value));
+
+			// interleave some unrelated allocations like an edited document would have
+			pool.allocate_string(nullptr, 48);
+		}
+	}
+
+	void fragment_chain(rapidxml::xml_node<>& parent)
+	{
+		std::vector<rapidxml::xml_node<>*> nodes;
+		nodes.reserve(node_count);
+		for(auto* n = parent.first_node(); n; n = n->next_sibling())
+			nodes.push_back(n);
+
+		std::mt19937 rng(42);
+		std::shuffle(nodes.begin(), nodes.end(), rng);
+
+		parent.remove_all_nodes();
+		for(auto* n : nodes)
+			parent.append_node(n);
+	}
+
+	// hashes name and value, then mixes the hash a few more rounds like a consumer doing real work
+	template<int _Rounds>
+	std::size_t visit(const rapidxml::xml_node<>* node)
+	{
+		std::uint64_t hash = 0xcbf29ce484222325ull;
+		for(const char* c = node->name(), *end = c + node->name_size(); c != end; ++c)
+			hash = (hash ^ static_cast<unsigned char>(*c)) * 0x100000001b3ull;
+		for(const char* c = node->value(), *end = c + node->value_size(); c != end; ++c)
+			hash = (hash ^ static_cast<unsigned char>(*c)) * 0x100000001b3ull;
+		for(int i = 0; i < _Rounds; ++i)
+			hash = (hash ^ (hash >> 29)) * 0xbf58476d1ce4e5b9ull;
+		return static_cast<std::size_t>(hash);
+	}
+
+	template<int _Rounds, typename _Prefetch>
+	struct list_walk
+	{
+		std::size_t operator ()(rapidxml::xml_node<>& parent, const std::vector<rapidxml::xml_node<>*>&) const
+		{
+			std::size_t sum = 0;
+			for(rxml::node_iterator<char, _Prefetch> it(parent), end; it != end; ++it)
+				sum += visit<_Rounds>(&*it);
+			return sum;
+		}
+	};
+
+	template<int _Rounds>
+	struct array_walk
+	{
+		std::size_t operator ()(rapidxml::xml_node<>&, const std::vector<rapidxml::xml_node<>*>& children) const
+		{
+			std::size_t sum = 0;
+			for(rapidxml::xml_node<>* child : children)
+				sum += visit<_Rounds>(child);
+			return sum;
+		}
+	};
+
+	template<typename _Walk>
+	double measure(rapidxml::xml_node<>& parent, const std::vector<rapidxml::xml_node<>*>& children, bool cold)
+	{
+		double best = 0.0;
+		for(int i = 0; i < repetitions; ++i)
+		{
+			if(cold)
+				flush_cache();
+
+			auto start = std::chrono::steady_clock::now();
+			sink = sink + _Walk()(parent, children);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			if(i == 0 || elapsed.count() < best)
+				best = elapsed.count();
+		}
+		return best;
+	}
+
+	template<int _Rounds>
+	void run(const char* layout, rapidxml::xml_node<>& parent, const std::vector<rapidxml::xml_node<>*>& children)
+	{
+		for(int cold = 0; cold < 2; ++cold)
+		{
+			std::printf("%-12s %-6s %6d %10.2f %10.2f %10.2f\n",
+				layout,
+				cold? "cold" : "warm",
+				_Rounds,
+				measure<list_walk<_Rounds, rxml::no_prefetch>>(parent, children, cold != 0),
+				measure<list_walk<_Rounds, rxml::sibling_prefetch>>(parent, children, cold != 0),
+				measure<array_walk<_Rounds>>(parent, children, cold != 0));
+		}
+	}
+
+	void run(const char* layout, rapidxml::xml_node<>& parent)
+	{
+		const std::vector<rapidxml::xml_node<>*> children = rxml::child_array(&parent);
+		run<0>(layout, parent, children);
+		run<16>(layout, parent, children);
+		run<64>(layout, parent, children);
+	}
+}
+
+
+int main()
+{
+	rapidxml::memory_pool<> pool;
+	rapidxml::xml_node<> parent(rapidxml::node_element);
+	build_chain(pool, parent);
+
+	std::printf("%u siblings, best of %d runs in ms\n", static_cast<unsigned>(node_count), repetitions);
+	std::printf("%-12s %-6s %6s %10s %10s %10s\n", "layout", "cache", "rounds", "list", "prefetch", "array");
+
+	run("parse-order", parent);
+	fragment_chain(parent);
+	run("fragmented", parent);
+
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/batch.hpp"
+#include "rxml/value.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	struct temp_directory
+	{
+		temp_directory()
+			: path(fs::temp_directory_path() / fs::unique_path("rxml-%%%%-%%%%"))
+		{
+			fs::create_directories(path);
+		}
+
+		~temp_directory()
+		{
+			fs::remove_all(path);
+		}
+
+		std::string add(const std::string& name, const std::string& content)
+		{
+			const fs::path file = path / name;
+			std::ofstream out(file.string().c_str(), std::ios::binary);
+			out << content;
+			return file.string();
+		}
+
+		fs::path path;
+	};
+
+	// asset descriptors; every 7th one is malformed
+	std::vector<std::string> make_files(temp_directory& dir, std::size_t count)
+	{
+		std::vector<std::string> filenames;
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			std::ostringstream xml;
+			xml << "<asset id='" << i << "'><name>asset &amp; " << i << "</name>";
+			for(std::size_t j = 0; j < i % 5; ++j)
+				xml << "<tag>t" << j << "</tag>";
+			if(i % 7 != 3)
+				xml << "</asset>";
+			filenames.push_back(dir.add("asset-" + std::to_string(i) + ".xml", xml.str()));
+		}
+		return filenames;
+	}
+
+	void check_batch(const rxml::document_batch<>& batch, const std::vector<std::string>& filenames)
+	{
+		BOOST_REQUIRE_EQUAL(batch.size(), filenames.size());
+		std::size_t failures = 0;
+		for(std::size_t i = 0; i < batch.size(); ++i)
+		{
+			const rxml::batch_entry<>& entry = batch[i];
+			BOOST_CHECK_EQUAL(entry.filename(), filenames[i]);
+
+			if(i % 7 == 3)
+			{
+				BOOST_CHECK(!entry);
+				BOOST_CHECK(!entry.document());
+				BOOST_CHECK_THROW(entry.get(), rapidxml::parse_error);
+				++failures;
+				continue;
+			}
+
+			BOOST_REQUIRE(entry);
+			BOOST_CHECK_EQUAL(rxml::value(entry.get(), "asset:id"), std::to_string(i));
+			BOOST_CHECK_EQUAL(rxml::value(*entry.document(), "asset/name"), "asset & " + std::to_string(i));
+		}
+		BOOST_CHECK_EQUAL(batch.failures(), failures);
+	}
+}
+
+
+RXML_PARAM_TEST_CASE(test_batch_like_input, std::size_t count, unsigned threads)
+{
+	temp_directory dir;
+	const std::vector<std::string> filenames = make_files(dir, count);
+
+	rxml::document_batch<> batch = rxml::parse_batch<rapidxml::parse_default>(filenames, threads);
+	check_batch(batch, filenames);
+}
+
+RXML_PARAM_TEST(test_batch_like_input, 0, 4);
+RXML_PARAM_TEST(test_batch_like_input, 1, 4);
+RXML_PARAM_TEST(test_batch_like_input, 500, 1);
+RXML_PARAM_TEST(test_batch_like_input, 500, 4);
+RXML_PARAM_TEST(test_batch_like_input, 500, 0);
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_batch_missing_and_reuse)
+{
+	temp_directory dir;
+	std::vector<std::string> filenames = make_files(dir, 100);
+	filenames.insert(filenames.begin() + 10, (dir.path / "missing.xml").string());
+
+	rxml::document_batch<> batch;
+	batch.parse<rapidxml::parse_default>(filenames, 3);
+
+	BOOST_REQUIRE_EQUAL(batch.size(), 101);
+	BOOST_CHECK(!batch[10]);
+	BOOST_CHECK_THROW(batch[10].get(), std::runtime_error);
+	BOOST_CHECK_EQUAL(rxml::value(batch[12].get(), "asset:id"), "11");
+
+	// a second batch reuses the documents of the first one
+	filenames.erase(filenames.begin() + 10);
+	batch.parse<rapidxml::parse_non_destructive>(filenames, 2);
+	check_batch(batch, filenames);
+
+	batch.clear();
+	BOOST_CHECK(batch.empty());
+}
@@ -0,0 +1,95 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <algorithm>
+#include "rxml/child_array.hpp"
+#include "rxml/value.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+struct ChildArrayTestFixture
+{
+	ChildArrayTestFixture(const fs::path& xml_path)
+		: file(xml_path.string().c_str())
+	{
+		BOOST_REQUIRE(file.size());
+		doc.parse<rapidxml::parse_full | rapidxml::parse_trim_whitespace | rapidxml::parse_normalize_whitespace>(file.data());
+	}
+
+	//#########################################################################################
+	void test_size(const std::string& path, std::size_t expected)
+	{
+		BOOST_CHECK_EQUAL(rxml::child_array(rxml::getnode(doc, path)).size(), expected);
+		BOOST_CHECK_EQUAL(rxml::child_array(rxml::getnode(cdoc(), path)).size(), expected);
+	}
+
+	//#########################################################################################
+	void test_index(const std::string& path, std::size_t idx, const std::string& expected)
+	{
+		std::vector<rapidxml::xml_node<>*> storage;
+		auto span = rxml::child_array(rxml::getnode(doc, path), storage);
+
+		BOOST_REQUIRE(idx < span.size());
+		BOOST_CHECK_EQUAL(rxml::value(span[idx]), expected);
+		BOOST_CHECK_EQUAL(span.data(), storage.data());
+		BOOST_CHECK_THROW(span.at(span.size()), std::out_of_range);
+	}
+
+	//#########################################################################################
+	void test_sorted_search(const std::string& path, const std::string& needle)
+	{
+		auto less = [](const rapidxml::xml_node<>* n, const std::string& v) { return rxml::value(n) < v; };
+		auto children = rxml::child_array(rxml::getnode(cdoc(), path));
+
+		std::sort(children.begin(), children.end(), [](const rapidxml::xml_node<>* a, const rapidxml::xml_node<>* b)
+			{
+				return rxml::value(a) < rxml::value(b);
+			});
+
+		auto it = std::lower_bound(children.begin(), children.end(), needle, less);
+		BOOST_REQUIRE(it != children.end());
+		BOOST_CHECK_EQUAL(rxml::value(*it), needle);
+	}
+
+	//#########################################################################################
+	void test_table_cache(const std::string& path)
+	{
+		rxml::child_table<rapidxml::xml_node<>> table;
+		auto& node = rxml::getnode(doc, path);
+
+		auto first = table.child_array(node);
+		auto second = table.child_array(node);
+		BOOST_CHECK_EQUAL(first.data(), second.data());
+		BOOST_CHECK_EQUAL(table.size(), 1u);
+
+		table.invalidate(node);
+		BOOST_CHECK_EQUAL(table.size(), 0u);
+	}
+
+	const rapidxml::xml_document<>& cdoc() const
+	{
+		return doc;
+	}
+
+	rapidxml::xml_document<> doc;
+	rapidxml::file<> file;
+};
+
+
+
+
+RXML_START_FIXTURE_TEST(ChildArrayTestFixture, get_rxml_test_path() / "node-test-1.xml")
+
+	RXML_FIXTURE_TEST(test_size, "node-test/list", 4);
+	RXML_FIXTURE_TEST(test_size, "node-test/xxx/sample", 0);
+
+	RXML_FIXTURE_TEST(test_index, "node-test/list", 0, "hallo");
+	RXML_FIXTURE_TEST(test_index, "node-test/list", 3, "guten tag");
+
+	RXML_FIXTURE_TEST(test_sorted_search, "node-test/list", "good morning");
+	RXML_FIXTURE_TEST(test_sorted_search, "node-test/list", "hello");
+
+	RXML_FIXTURE_TEST(test_table_cache, "node-test/list");
+
+RXML_END_FIXTURE_TEST()
@@ -0,0 +1,174 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/compact.hpp"
+#include "rxml/locate.hpp"
+#include "rxml/value.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	// compares names, values and structure of both trees
+	void check_equal(const rxml::compact_node<>& compact, const rapidxml::xml_node<>* node)
+	{
+		BOOST_REQUIRE_EQUAL(compact.type(), node->type());
+		BOOST_CHECK_EQUAL(rxml::name(compact), rxml::name(node));
+		BOOST_CHECK_EQUAL(rxml::value(compact), rxml::value(node));
+
+		auto attr = compact.first_attribute();
+		for(auto* a = node->first_attribute(); a; a = a->next_attribute(), attr = attr.next_attribute())
+		{
+			BOOST_REQUIRE(attr);
+			BOOST_CHECK_EQUAL(rxml::name(attr), rxml::name(a));
+			BOOST_CHECK_EQUAL(rxml::value(attr), rxml::value(a));
+		}
+		BOOST_CHECK(!attr);
+
+		auto child = compact.first_node();
+		for(auto* n = node->first_node(); n; n = n->next_sibling(), child = child.next_sibling())
+		{
+			BOOST_REQUIRE(child);
+			check_equal(child, n);
+		}
+		BOOST_CHECK(!child);
+	}
+}
+
+struct CompactTestFixture
+{
+	CompactTestFixture(const fs::path& xml_path)
+		: file(xml_path.string().c_str())
+		, copy(file.data(), file.data() + file.size() + 1)
+	{
+		doc.parse(file.data());
+		full.parse<rapidxml::parse_default>(&copy.front());
+	}
+
+	//#########################################################################################
+	void test_like_full()
+	{
+		BOOST_CHECK_EQUAL(doc.type(), rapidxml::node_document);
+		check_equal(doc, &full);
+	}
+
+	//#########################################################################################
+	void test_value(const std::string& path, const std::string& expected)
+	{
+		BOOST_CHECK_EQUAL(rxml::value(doc, path), expected);
+		BOOST_CHECK_EQUAL(rxml::value(rxml::get(doc, path)), expected);
+	}
+
+	//#########################################################################################
+	void test_has(const std::string& path, bool has = true)
+	{
+		BOOST_CHECK_EQUAL(static_cast<bool>(rxml::get(&doc, path)), has);
+		if(!has)
+			BOOST_CHECK_THROW(rxml::get(doc, path), rxml::notfound_error);
+	}
+
+	//#########################################################################################
+	void test_locate(const std::string& path, const std::string& expected)
+	{
+		BOOST_CHECK_EQUAL(rxml::locate(rxml::get(doc, path)), expected);
+		BOOST_CHECK_EQUAL(rxml::locate(rxml::get(full, path)), expected);
+	}
+
+	//#########################################################################################
+	void test_element_iteration(const std::string& path, const std::string& expected)
+	{
+		std::string names;
+		for(auto& child : rxml::elements(rxml::getnode(doc, path)))
+			names += rxml::name(child) + ",";
+		BOOST_CHECK_EQUAL(names, expected);
+	}
+
+	//#########################################################################################
+	void test_attribute_iteration(const std::string& path, std::size_t expected)
+	{
+		std::size_t count = 0;
+		for(auto& attr : rxml::attributes(rxml::getnode(doc, path)))
+		{
+			BOOST_CHECK(attr.parent() == rxml::getnode(doc, path));
+			++count;
+		}
+		BOOST_CHECK_EQUAL(count, expected);
+	}
+
+	rapidxml::file<> file;
+	std::vector<char> copy;
+	rxml::compact_document<> doc;
+	rapidxml::xml_document<> full;
+};
+
+
+RXML_START_FIXTURE_TEST(CompactTestFixture, get_rxml_test_path() / "node-test-1.xml")
+
+	RXML_FIXTURE_TEST(test_like_full);
+
+	RXML_FIXTURE_TEST(test_value, "node-test:name", "node-test");
+	RXML_FIXTURE_TEST(test_value, "node-test/info/author:nick", "SirTobi");
+	RXML_FIXTURE_TEST(test_value, "node-test/info/text", "lalala");
+	RXML_FIXTURE_TEST(test_value, "/node-test/info/../list/value", "hallo");
+	RXML_FIXTURE_TEST(test_value, "node-test/xxx/sample:value", "bla");
+
+	RXML_FIXTURE_TEST(test_has, "node-test/xxx/sample");
+	RXML_FIXTURE_TEST(test_has, "node-test/xxxx/sample", false);
+	RXML_FIXTURE_TEST(test_has, "node-test/info:nope", false);
+
+	RXML_FIXTURE_TEST(test_locate, "node-test/info:alt", "/node-test/info:alt");
+	RXML_FIXTURE_TEST(test_locate, "node-test/list/value", "/node-test/list/value");
+
+	RXML_FIXTURE_TEST(test_element_iteration, "node-test/info", "author,version,text,");
+	RXML_FIXTURE_TEST(test_element_iteration, "node-test/list", "value,value,value,value,");
+
+	RXML_FIXTURE_TEST(test_attribute_iteration, "node-test/info/author", 2);
+	RXML_FIXTURE_TEST(test_attribute_iteration, "node-test/list", 0);
+
+RXML_END_FIXTURE_TEST()
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_compact_generated)
+{
+	std::ostringstream xml;
+	xml << "<list>";
+	for(std::size_t i = 0; i < 1000; ++i)
+		xml << "<item id='" << i << "' kind='a&amp;b'>item &lt;" << i << "&gt;<![CDATA[<raw>]]><sub/></item>";
+	xml << "</list>";
+	const std::string text = xml.str();
+	std::string copy = text;
+
+	rxml::compact_document<> doc;
+	doc.parse(text.c_str());
+	rapidxml::xml_document<> full;
+	full.parse<rapidxml::parse_default>(&copy[0]);
+
+	check_equal(doc, &full);
+	BOOST_CHECK_EQUAL(rxml::value(doc, "list/item:kind"), "a&b");
+	BOOST_CHECK_EQUAL(rxml::value(doc, "list/item"), "item <0>");
+
+	// document, list, 1000 items with data, cdata and sub
+	BOOST_CHECK_EQUAL(doc.node_count(), 2 + 4 * 1000);
+	BOOST_CHECK_EQUAL(doc.attribute_count(), 2 * 1000);
+
+	const std::size_t pointer_size = doc.node_count() * sizeof(rapidxml::xml_node<>) + doc.attribute_count() * sizeof(rapidxml::xml_attribute<>);
+	BOOST_CHECK(doc.memory_size() * 2 < pointer_size);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_compact_error)
+{
+	rxml::compact_document<> doc;
+	BOOST_CHECK_THROW(doc.parse("<a><b></a>"), rapidxml::parse_error);
+	BOOST_CHECK_THROW(doc.parse("<a>"), rapidxml::parse_error);
+
+	doc.clear();
+	BOOST_CHECK(!doc.first_node());
+	BOOST_CHECK(!rxml::getnode(&doc, "a"));
+}
@@ -0,0 +1,127 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+#include "test_helpers.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rxml/document_pool.hpp"
+#include "rxml/value.hpp"
+
+namespace {
+
+	std::string generate_message(std::size_t id, std::size_t items)
+	{
+		std::ostringstream xml;
+		xml << "<message id='" << id << "'>";
+		for(std::size_t i = 0; i < items; ++i)
+			xml << "<item n='" << i << "'>payload " << i << "</item>";
+		xml << "</message>";
+		return xml.str();
+	}
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_rewind_reuses_blocks)
+{
+	counting_arena arena;
+	rapidxml::memory_pool_config config;
+	config.block_size = 4096;
+	config.arena = &arena;
+
+	rapidxml::xml_document<> doc;
+	doc.configure(config);
+
+	std::string text = generate_message(1, 2000);
+	doc.parse<rapidxml::parse_default>(&text[0]);
+	const std::size_t allocations = arena.allocations;
+	const std::size_t capacity = doc.capacity();
+	BOOST_REQUIRE(allocations > 1);
+
+	for(std::size_t i = 0; i < 5; ++i)
+	{
+		doc.rewind();
+		text = generate_message(i, 2000);
+		doc.parse<rapidxml::parse_default>(&text[0]);
+		BOOST_CHECK_EQUAL(rxml::value(doc, "message:id"), std::to_string(i));
+	}
+
+	BOOST_CHECK_EQUAL(arena.allocations, allocations);
+	BOOST_CHECK_EQUAL(doc.capacity(), capacity);
+
+	// the limit drops blocks beyond it
+	doc.rewind(capacity / 2);
+	BOOST_CHECK(doc.capacity() <= capacity / 2);
+	doc.rewind(0);
+	BOOST_CHECK_EQUAL(doc.capacity(), 0);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_document_pool_reuses_documents)
+{
+	rxml::document_pool<> pool(1 << 20, 2, 1);
+
+	const rapidxml::xml_document<>* first;
+	{
+		auto doc = pool.acquire();
+		first = doc.get();
+		std::string text = generate_message(7, 10);
+		doc->parse<rapidxml::parse_default>(&text[0]);
+		BOOST_CHECK_EQUAL(rxml::value(*doc, "message/item:n"), "0");
+	}
+	BOOST_CHECK_EQUAL(pool.thread_size(), 1);
+
+	{
+		auto doc = pool.acquire();
+		BOOST_CHECK_EQUAL(doc.get(), first);
+		BOOST_CHECK(!doc->first_node());
+	}
+
+	// two go to the thread cache, one to the shared list, the last one is dropped
+	{
+		auto a = pool.acquire(), b = pool.acquire(), c = pool.acquire(), d = pool.acquire();
+	}
+	BOOST_CHECK_EQUAL(pool.thread_size(), 2);
+	BOOST_CHECK_EQUAL(pool.shared_size(), 1);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_document_pool_threads)
+{
+	counting_arena arena;
+	rapidxml::memory_pool_config config;
+	config.block_size = 4096;
+	config.arena = &arena;
+
+	std::atomic<std::size_t> errors{0};
+	{
+		rxml::document_pool<> pool(1 << 20, 2, 8, config);
+
+		std::vector<std::thread> threads;
+		for(std::size_t t = 0; t < 4; ++t)
+		{
+			threads.push_back(std::thread([&pool, &errors, t]
+				{
+					for(std::size_t i = 0; i < 200; ++i)
+					{
+						auto doc = pool.acquire();
+						std::string text = generate_message(t * 1000 + i, 100);
+						doc->parse<rapidxml::parse_default>(&text[0]);
+						if(rxml::value(*doc, "message:id") != std::to_string(t * 1000 + i))
+							++errors;
+					}
+				}));
+		}
+		for(auto& thread : threads)
+			thread.join();
+	}
+
+	BOOST_CHECK_EQUAL(errors, 0);
+
+	// each thread keeps reusing the same document and its blocks
+	BOOST_CHECK(arena.allocations < 4 * 10);
+}
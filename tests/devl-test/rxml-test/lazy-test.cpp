@@ -0,0 +1,168 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+#include "test_helpers.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rxml/lazy.hpp"
+#include "rxml/value.hpp"
+#include "rxml/iterators.hpp"
+
+namespace {
+
+	const int parse_flags = rapidxml::parse_full | rapidxml::parse_trim_whitespace;
+
+	std::string generate_document(std::size_t records)
+	{
+		std::ostringstream xml;
+		xml << "<?xml version=\"1.0\"?>\n<!-- export -->\n<export version='2'>\n\tintro &lt;text&gt;\n";
+		for(std::size_t i = 0; i < records; ++i)
+		{
+			xml << "\t<record id=\"" << i << "\">\n"
+				<< "\t\t<name>Record &amp; number " << i << "</name>\n"
+				<< "\t\t<!-- <fake/> -->\n"
+				<< "\t\t<data><![CDATA[<not></record>]]></data>\n"
+				<< "\t\t<list><item>a</item>mixed<item b='x > y'/></list>\n"
+				<< "\t\t<empty/><blank>  </blank>\n"
+				<< "\t</record>\n";
+		}
+		xml << "</export>\n<!-- trailer -->\n";
+		return xml.str();
+	}
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_lazy_equals_full, std::size_t records, std::size_t depth)
+{
+	std::string full_text = generate_document(records);
+	full_text.push_back('\0');
+	std::string lazy_text = full_text;
+
+	rapidxml::xml_document<> full;
+	full.parse<parse_flags>(&full_text[0]);
+	rxml::lazy_document<> lazy(depth);
+	lazy.parse<parse_flags>(&lazy_text[0]);
+
+	BOOST_CHECK(lazy.deferred_count() > 0);
+	BOOST_CHECK_EQUAL(lazy.pending_count(), lazy.deferred_count());
+
+	std::string expected, result;
+	dump_tree(&full, expected);
+	dump_tree(&lazy, result);
+	BOOST_CHECK_EQUAL(result, expected);
+	BOOST_CHECK_EQUAL(lazy.pending_count(), 0);
+}
+
+RXML_PARAM_TEST(test_lazy_equals_full, 10, 0);
+RXML_PARAM_TEST(test_lazy_equals_full, 10, 1);
+RXML_PARAM_TEST(test_lazy_equals_full, 10, 2);
+RXML_PARAM_TEST(test_lazy_equals_full, 10, 3);
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_lazy_prefetch_children)
+{
+	std::string text = generate_document(5);
+	text.push_back('\0');
+
+	rxml::lazy_document<> doc(1);
+	doc.parse<rapidxml::parse_default>(&text[0]);
+
+	// prefetching the values of upcoming siblings does not load them
+	std::size_t records = 0;
+	for(auto& child : rxml::prefetch_children(rxml::getnode(doc, "export")))
+		records += child.name_size() == 6;
+	BOOST_CHECK_EQUAL(records, 5);
+	BOOST_CHECK_EQUAL(doc.pending_count(), 5);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_lazy_loads_on_access)
+{
+	std::string text = generate_document(5);
+	text.push_back('\0');
+
+	rxml::lazy_document<> doc(1);
+	doc.parse<rapidxml::parse_default>(&text[0]);
+	BOOST_CHECK_EQUAL(doc.deferred_count(), 5);
+
+	// attributes are available without loading
+	auto& record = rxml::getnode(doc, "export/record");
+	BOOST_CHECK_EQUAL(rxml::value(doc, "export/record:id"), "0");
+	BOOST_CHECK_EQUAL(doc.pending_count(), 5);
+
+	BOOST_CHECK_EQUAL(rxml::value(doc, "export/record/name"), "Record & number 0");
+	BOOST_CHECK_EQUAL(doc.pending_count(), 4);
+
+	std::string names;
+	for(auto& child : rxml::elements(record.next_sibling()))
+		names.append(rxml::name(child)).append(",");
+	BOOST_CHECK_EQUAL(names, "name,data,list,empty,blank,");
+	BOOST_CHECK_EQUAL(doc.pending_count(), 3);
+
+	BOOST_CHECK_EQUAL(rxml::valuefb(doc, "export/record/list", "fallback"), "mixed");
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_lazy_value_of_deferred_element)
+{
+	char text[] = "<root><a x='1'>first<b/>second</a><c>  </c></root>";
+
+	rxml::lazy_document<> doc(1);
+	doc.parse<rapidxml::parse_default>(text);
+	BOOST_CHECK_EQUAL(doc.deferred_count(), 1);
+
+	BOOST_CHECK_EQUAL(rxml::value(rxml::getnode(doc, "root/a")), "first");
+	BOOST_CHECK_EQUAL(rxml::value(doc, "root/a"), "first");
+	BOOST_CHECK_EQUAL(rxml::value(doc, "root/c"), "");
+	BOOST_CHECK_EQUAL(doc.pending_count(), 0);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_lazy_concurrent_access)
+{
+	std::string full_text = generate_document(200);
+	full_text.push_back('\0');
+	std::string lazy_text = full_text;
+
+	rapidxml::xml_document<> full;
+	full.parse<parse_flags>(&full_text[0]);
+	rxml::lazy_document<> lazy(1);
+	lazy.parse<parse_flags>(&lazy_text[0]);
+
+	std::string expected;
+	dump_tree(&full, expected);
+
+	// every thread walks the whole document, so all of them race for the same elements
+	std::vector<std::string> results(8);
+	std::vector<std::thread> threads;
+	for(std::size_t i = 0; i < results.size(); ++i)
+		threads.push_back(std::thread([&lazy, &results, i] { dump_tree(&lazy, results[i]); }));
+	for(auto& thread : threads)
+		thread.join();
+
+	for(auto& result : results)
+		BOOST_CHECK(result == expected);
+	BOOST_CHECK_EQUAL(lazy.pending_count(), 0);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_lazy_deferred_error)
+{
+	// the scan over deferred content does not look into tags
+	char text[] = "<root><a>x<b y=1/></a><c>ok</c></root>";
+
+	rxml::lazy_document<> doc(1);
+	doc.parse<rapidxml::parse_default>(text);
+
+	BOOST_CHECK_THROW(rxml::getnode(doc, "root/a").first_node(), rapidxml::parse_error);
+	BOOST_CHECK(!rxml::getnode(doc, "root/a").first_node());
+	BOOST_CHECK_EQUAL(rxml::value(doc, "root/c"), "ok");
+}
@@ -0,0 +1,114 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <string>
+#include "rxml/mapped_file.hpp"
+#include "rxml/value.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	struct temp_file
+	{
+		explicit temp_file(const std::string& content)
+			: path(fs::temp_directory_path() / fs::unique_path("rxml-%%%%-%%%%.xml"))
+		{
+			std::ofstream out(path.string().c_str(), std::ios::binary);
+			out << content;
+		}
+
+		~temp_file()
+		{
+			fs::remove(path);
+		}
+
+		std::string read() const
+		{
+			std::ifstream in(path.string().c_str(), std::ios::binary);
+			return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		}
+
+		fs::path path;
+	};
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_mapped_equals_loaded, const std::string& file_name)
+{
+	const std::string path = (get_rxml_test_path() / file_name).string();
+	rapidxml::file<> loaded(path.c_str());
+	rxml::mapped_file<> mapped(path);
+
+	BOOST_REQUIRE_EQUAL(mapped.size(), loaded.size());
+	BOOST_CHECK(std::equal(loaded.data(), loaded.data() + loaded.size(), mapped.data()));
+	BOOST_CHECK_EQUAL(mapped.data()[mapped.size() - 1], '\0');
+}
+
+RXML_PARAM_TEST(test_mapped_equals_loaded, "node-test-1.xml");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_mapped_terminator, std::size_t size)
+{
+	temp_file file(std::string(size, 'x'));
+	rxml::mapped_file<> mapped(file.path.string());
+
+	BOOST_REQUIRE_EQUAL(mapped.size(), size + 1);
+	BOOST_CHECK_EQUAL(mapped.data()[size], '\0');
+	BOOST_CHECK_EQUAL(std::string(mapped.data()), std::string(size, 'x'));
+}
+
+RXML_PARAM_TEST(test_mapped_terminator, 0);
+RXML_PARAM_TEST(test_mapped_terminator, 1);
+RXML_PARAM_TEST(test_mapped_terminator, 4096);
+RXML_PARAM_TEST(test_mapped_terminator, 3 * 4096 - 1);
+RXML_PARAM_TEST(test_mapped_terminator, 65536);
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_mapped_parse_in_place)
+{
+	const std::string xml = "<root><a>one &amp; two</a><b x='1'/></root>";
+	temp_file file(xml);
+
+	{
+		rxml::mapped_file<> mapped(file.path.string(), rxml::mapped_file<>::access_willneed);
+		rapidxml::xml_document<> doc;
+		doc.parse<rapidxml::parse_default>(mapped.data());
+
+		BOOST_CHECK_EQUAL(rxml::value(doc, "root/a"), "one & two");
+		BOOST_CHECK_EQUAL(rxml::value(doc, "root/b:x"), "1");
+	}
+
+	// the parser wrote into private pages only
+	BOOST_CHECK_EQUAL(file.read(), xml);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_mapped_missing_file)
+{
+	BOOST_CHECK_THROW(rxml::mapped_file<>("/nonexisting/file.xml"), std::runtime_error);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_mapped_document_read_only)
+{
+	const std::string xml = "<root>\n\t<a>one &amp; two</a>\n\t<b x='&lt;1&gt;'/>\n</root>";
+	temp_file file(xml);
+
+	rxml::mapped_document<> doc(file.path.string());
+	doc.parse<rapidxml::parse_non_destructive | rapidxml::parse_trim_whitespace>();
+
+	// any write to the read-only mapping would crash the parser
+	BOOST_CHECK_EQUAL(rxml::value(doc, "root/a"), "one & two");
+	BOOST_CHECK_EQUAL(rxml::value(doc, "root/b:x"), "<1>");
+	BOOST_CHECK_EQUAL(doc.file().size(), xml.size() + 1);
+	BOOST_CHECK_EQUAL(file.read(), xml);
+}
@@ -0,0 +1,238 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/get.hpp"
+#include "rxml/lazy.hpp"
+#include "rxml/parallel.hpp"
+#include "rxml/value.hpp"
+
+namespace {
+
+	const char* const soap_uri = "http://schemas.xmlsoap.org/soap/envelope/";
+
+	struct namespace_document
+	{
+		explicit namespace_document(const std::string& text)
+			: buffer(text.begin(), text.end())
+		{
+			buffer.push_back(0);
+			doc.parse<rapidxml::parse_namespaces>(&buffer.front());
+		}
+
+		std::vector<char> buffer;
+		rapidxml::xml_document<> doc;
+	};
+
+	// root bindings used by every item, and bindings declared further down
+	std::string generate_items(std::size_t items)
+	{
+		std::ostringstream xml;
+		xml << "<s:root xmlns:s='urn:s' xmlns='urn:default'>\n";
+		for(std::size_t i = 0; i < items; ++i)
+		{
+			xml << "\t<s:item n='" << i << "'><plain/>";
+			if(i % 500 == 250)
+				xml << "<t:extra xmlns:t='urn:t" << i / 500 << "'><t:x/></t:extra>";
+			xml << "</s:item>\n";
+		}
+		xml << "</s:root>\n";
+		return xml.str();
+	}
+
+	// uri and name of every element in document order
+	void dump_namespaces(const rapidxml::xml_node<>* node, std::string& result)
+	{
+		for(const rapidxml::xml_node<>* child = node->first_node(); child; child = child->next_sibling())
+		{
+			if(child->type() != rapidxml::node_element)
+				continue;
+			const rapidxml::xml_document<>* doc = child->document();
+			if(child->namespace_id())
+				result.append(doc->namespace_uri(child->namespace_id()), doc->namespace_uri_size(child->namespace_id()));
+			result.append(" ").append(child->name(), child->name_size()).append("\n");
+			dump_namespaces(child, result);
+		}
+	}
+
+	template<typename _Doc>
+	void check_like_xml_document(_Doc& doc, const std::string& text)
+	{
+		std::vector<char> expected_buffer(text.begin(), text.end()), buffer(text.begin(), text.end());
+		expected_buffer.push_back(0);
+		buffer.push_back(0);
+
+		rapidxml::xml_document<> expected;
+		expected.parse<rapidxml::parse_namespaces>(&expected_buffer.front());
+		doc.template parse<rapidxml::parse_namespaces>(&buffer.front());
+
+		std::string expected_dump, result;
+		dump_namespaces(&expected, expected_dump);
+		dump_namespaces(&doc, result);
+		BOOST_CHECK_EQUAL(result, expected_dump);
+		BOOST_CHECK_EQUAL(doc.namespace_count(), expected.namespace_count());
+		for(unsigned id = 1; id <= doc.namespace_count() && id <= expected.namespace_count(); ++id)
+			BOOST_CHECK_EQUAL(std::string(doc.namespace_uri(id)), std::string(expected.namespace_uri(id)));
+
+		const rapidxml::xml_node<>* item = rxml::getnode(&doc, "{urn:s}root/{urn:s}item");
+		BOOST_REQUIRE(item);
+		BOOST_CHECK(rxml::getnode(item, "{urn:default}plain"));
+		BOOST_CHECK(rxml::getnode(&doc, "{urn:s}root/{urn:s}item/../{urn:s}item/{urn:default}plain"));
+	}
+}
+
+
+RXML_PARAM_TEST_CASE(test_namespace_prefixes, const std::string& text)
+{
+	namespace_document d(text);
+
+	const rapidxml::xml_node<>* body = rxml::getnode(&d.doc, "{http://schemas.xmlsoap.org/soap/envelope/}Envelope/{http://schemas.xmlsoap.org/soap/envelope/}Body");
+	BOOST_REQUIRE(body);
+	BOOST_CHECK_EQUAL(body->namespace_id(), d.doc.find_namespace(soap_uri));
+
+	const rapidxml::xml_node<>* item = rxml::getnode(body, "{urn:items}item");
+	BOOST_REQUIRE(item);
+	BOOST_CHECK_EQUAL(std::string(item->value()), "x");
+
+	// lookups by qualified name still see the prefixes as written
+	BOOST_CHECK(!rxml::getnode(&d.doc, "{http://schemas.xmlsoap.org/soap/envelope/}Envelope/{urn:items}Body"));
+	BOOST_CHECK(!rxml::getnode(&d.doc, "{urn:unknown}Envelope"));
+}
+
+RXML_PARAM_TEST(test_namespace_prefixes, "<soap:Envelope xmlns:soap='http://schemas.xmlsoap.org/soap/envelope/'><soap:Body><i:item xmlns:i='urn:items'>x</i:item></soap:Body></soap:Envelope>");
+RXML_PARAM_TEST(test_namespace_prefixes, "<s:Envelope xmlns:s='http://schemas.xmlsoap.org/soap/envelope/' xmlns='urn:items'><s:Body><item>x</item></s:Body></s:Envelope>");
+RXML_PARAM_TEST(test_namespace_prefixes, "<Envelope xmlns='http://schemas.xmlsoap.org/soap/envelope/'><Body><e:item xmlns:e='urn:items'>x</e:item></Body></Envelope>");
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_namespace_scopes)
+{
+	namespace_document d(
+		"<a xmlns='urn:one' xmlns:p='urn:two'>"
+			"<b xmlns=''><c/></b>"
+			"<p:d xmlns:p='urn:three'/>"
+			"<p:e/>"
+			"<xml:f/>"
+		"</a>");
+
+	const unsigned one = d.doc.find_namespace("urn:one");
+	const unsigned two = d.doc.find_namespace("urn:two");
+	const unsigned three = d.doc.find_namespace("urn:three");
+	BOOST_CHECK(one && two && three);
+	BOOST_CHECK_EQUAL(d.doc.find_namespace("urn:none"), 0);
+	BOOST_CHECK_EQUAL(d.doc.namespace_count(), 4);
+	BOOST_CHECK_EQUAL(std::string(d.doc.namespace_uri(two), d.doc.namespace_uri_size(two)), "urn:two");
+
+	const rapidxml::xml_node<>* a = d.doc.first_node();
+	BOOST_CHECK_EQUAL(a->namespace_id(), one);
+	BOOST_CHECK_EQUAL(a->first_node("b")->namespace_id(), 0);
+	BOOST_CHECK_EQUAL(a->first_node("b")->first_node("c")->namespace_id(), 0);
+	BOOST_CHECK_EQUAL(a->first_node("p:d")->namespace_id(), three);
+	BOOST_CHECK_EQUAL(a->first_node("p:e")->namespace_id(), two);
+	BOOST_CHECK_EQUAL(a->first_node("xml:f")->namespace_id(), d.doc.find_namespace("http://www.w3.org/XML/1998/namespace"));
+
+	BOOST_CHECK(rxml::getnode(&d.doc, "{urn:one}a/{}b/{}c"));
+	BOOST_CHECK(rxml::getnode(&d.doc, "{urn:one}a/{urn:two}e"));
+	BOOST_CHECK(rxml::getnode(&d.doc, "{urn:one}a/{urn:three}d"));
+	BOOST_CHECK(!rxml::getnode(&d.doc, "{urn:one}a/{urn:two}d"));
+	BOOST_CHECK(!rxml::getnode(&d.doc, "{}a"));
+
+	// paths with a size need no terminating zero, also after {}
+	const char path[] = { '{', 'u', 'r', 'n', ':', 'o', 'n', 'e', '}', 'a', '/', '{', '}', 'b', 'x' };
+	BOOST_CHECK(rxml::getnode(&d.doc, path, sizeof(path) - 1));
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_namespace_attributes)
+{
+	namespace_document d("<r xmlns:x='urn:x' xmlns:y='urn:x'><e x:id='1' id='2' xml:lang='en'><f y:id='3'/></e></r>");
+
+	const rapidxml::xml_attribute<>* attr = rxml::getattr(&d.doc, "r/e:{urn:x}id");
+	BOOST_REQUIRE(attr);
+	BOOST_CHECK_EQUAL(std::string(attr->value()), "1");
+
+	attr = rxml::getattr(&d.doc, "r/e:{}id");
+	BOOST_REQUIRE(attr);
+	BOOST_CHECK_EQUAL(std::string(attr->value()), "2");
+
+	attr = rxml::getattr(&d.doc, "{}r/{}e/{}f:{urn:x}id");
+	BOOST_REQUIRE(attr);
+	BOOST_CHECK_EQUAL(std::string(attr->value()), "3");
+
+	attr = rxml::getattr(&d.doc, "r/e:{http://www.w3.org/XML/1998/namespace}lang");
+	BOOST_REQUIRE(attr);
+	BOOST_CHECK_EQUAL(std::string(attr->value()), "en");
+
+	BOOST_CHECK(!rxml::getattr(&d.doc, "r/e:{urn:y}id"));
+	BOOST_CHECK(!rxml::getattr(&d.doc, "r/e/f:{}id"));
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_namespace_values)
+{
+	// ':' inside the uris does not make these attribute paths
+	namespace_document d("<r xmlns:a='http://x/a'><a:item a:id='1'>one</a:item><item>two</item></r>");
+
+	BOOST_CHECK_EQUAL(rxml::value(d.doc, "r/{http://x/a}item"), "one");
+	BOOST_CHECK_EQUAL(rxml::value(d.doc, "{}r/{}item"), "two");
+	BOOST_CHECK_EQUAL(rxml::value(d.doc, "r/{http://x/a}item:{http://x/a}id"), "1");
+	BOOST_CHECK_THROW(rxml::value(d.doc, "r/{http://x/b}item"), std::exception);
+
+	BOOST_CHECK_EQUAL(rxml::valuefb(d.doc, "r/{http://x/a}item", "none"), "one");
+	BOOST_CHECK_EQUAL(rxml::valuefb(d.doc, "r/{http://x/a}item:{http://x/a}id", "none"), "1");
+	BOOST_CHECK_EQUAL(rxml::valuefb(d.doc, "r/{http://x/b}item", "none"), "none");
+	BOOST_CHECK_EQUAL(rxml::valuefb(d.doc, "r/{http://x/a}item:{}id", "none"), "none");
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_namespace_errors)
+{
+	std::string text = "<a xmlns:p='urn:p'><p:b/></a><q:c/>";
+	rapidxml::xml_document<> doc;
+	BOOST_CHECK_THROW(doc.parse<rapidxml::parse_namespaces>(&text[0]), rapidxml::parse_error);
+
+	// without the flag prefixes are plain names
+	text = "<q:c/>";
+	BOOST_CHECK_NO_THROW(doc.parse<0>(&text[0]));
+	BOOST_CHECK_EQUAL(doc.first_node()->namespace_id(), 0);
+	BOOST_CHECK_EQUAL(doc.namespace_count(), 0);
+
+	// a declaration is only in scope within its element
+	text = "<r><a xmlns:p='urn:p'/><p:b/></r>";
+	BOOST_CHECK_THROW(doc.parse<rapidxml::parse_namespaces>(&text[0]), rapidxml::parse_error);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_namespace_parallel_document)
+{
+	const std::string text = generate_items(2000);
+	rxml::parallel_document<> doc(4, 1024);
+	check_like_xml_document(doc, text);
+	BOOST_CHECK(doc.chunk_count() > 1);
+
+	// parsing again starts with an empty table
+	check_like_xml_document(doc, "<s:root xmlns:s='urn:s'><s:item><plain xmlns='urn:default'/></s:item></s:root>");
+	BOOST_CHECK_EQUAL(doc.namespace_count(), 2);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_namespace_lazy_document)
+{
+	const std::string text = generate_items(2000);
+	for(std::size_t depth : {0, 1, 2})
+	{
+		rxml::lazy_document<> doc(depth);
+		check_like_xml_document(doc, text);
+		BOOST_CHECK_EQUAL(doc.pending_count(), 0u);
+
+		check_like_xml_document(doc, "<s:root xmlns:s='urn:s'><s:item><plain xmlns='urn:default'/></s:item></s:root>");
+		BOOST_CHECK_EQUAL(doc.namespace_count(), 2);
+	}
+}
@@ -1,6 +1,7 @@
 #include "test_settings.hpp"
 #include "test_config.hpp"
 
+#include <vector>
 #include "rxml/value.hpp"
 #include "rxml/iterators.hpp"
 #include "rxml/locate.hpp"
@@ -100,6 +101,45 @@ struct NodeTestFixture
 		BOOST_CHECK_EQUAL(result, expected);
 	}
 
+	//#########################################################################################
+	void test_element_iteration(const std::string& path, std::size_t expected)
+	{
+		std::size_t count = 0;
+		for(auto& child : rxml::elements(rxml::getnode(doc, path)))
+		{
+			BOOST_CHECK_EQUAL(child.type(), rapidxml::node_element);
+			++count;
+		}
+		BOOST_CHECK_EQUAL(count, expected);
+	}
+
+	//#########################################################################################
+	void test_masked_iteration(const std::string& path, unsigned int mask, std::size_t expected)
+	{
+		const rapidxml::xml_node<>& node = rxml::getnode(doc, path);
+		std::size_t count = 0;
+		for(auto& child : rxml::children(node, mask))
+		{
+			BOOST_CHECK(mask & (1u << child.type()));
+			++count;
+		}
+		BOOST_CHECK_EQUAL(count, expected);
+	}
+
+	//#########################################################################################
+	void test_prefetch_iteration(const std::string& path)
+	{
+		const rapidxml::xml_node<>& node = rxml::getnode(doc, path);
+		std::vector<const rapidxml::xml_node<>*> plain, prefetched;
+
+		for(auto& child : rxml::children(node))
+			plain.push_back(&child);
+		for(auto& child : rxml::prefetch_children(node))
+			prefetched.push_back(&child);
+
+		BOOST_CHECK(plain == prefetched);
+	}
+
 
 	rapidxml::xml_document<> doc;
 	rapidxml::file<> file;
@@ -125,6 +165,10 @@ private:
 	{
 		static_bidirectional_iterator_test<rxml::node_iterator<>>();
 		static_bidirectional_iterator_test<rxml::const_node_iterator<>>();
+		static_bidirectional_iterator_test<rxml::node_iterator<char, rxml::sibling_prefetch>>();
+		static_bidirectional_iterator_test<rxml::const_node_iterator<char, rxml::sibling_prefetch>>();
+		static_bidirectional_iterator_test<rxml::element_iterator<>>();
+		static_bidirectional_iterator_test<rxml::const_element_iterator<>>();
 
 		static_bidirectional_iterator_test<rxml::attribute_iterator<>>();
 		static_bidirectional_iterator_test<rxml::const_attribute_iterator<>>();
@@ -183,4 +227,19 @@ RXML_START_FIXTURE_TEST(NodeTestFixture, get_rxml_test_path() / "node-test-1.xml
 	RXML_FIXTURE_TEST(test_valuefb, "node-test/info/author/..", "---", "Test Info");
 	RXML_FIXTURE_TEST(test_valuefb, "node-test/info/author/...", "---", "---");
 
+
+	RXML_FIXTURE_TEST(test_element_iteration, "", 1);
+	RXML_FIXTURE_TEST(test_element_iteration, "node-test/info", 3);
+	RXML_FIXTURE_TEST(test_element_iteration, "node-test/xxx/sample", 0);
+
+	RXML_FIXTURE_TEST(test_masked_iteration, "", rxml::mask_declaration, 1);
+	RXML_FIXTURE_TEST(test_masked_iteration, "node-test/info", rxml::mask_data, 1);
+	RXML_FIXTURE_TEST(test_masked_iteration, "node-test/info", rxml::mask_data | rxml::mask_element, 4);
+	RXML_FIXTURE_TEST(test_masked_iteration, "node-test/info", rxml::mask_comment, 0);
+
+	RXML_FIXTURE_TEST(test_prefetch_iteration, "");
+	RXML_FIXTURE_TEST(test_prefetch_iteration, "node-test/list");
+	RXML_FIXTURE_TEST(test_prefetch_iteration, "node-test/info");
+	RXML_FIXTURE_TEST(test_prefetch_iteration, "node-test/xxx/sample");
+
 RXML_END_FIXTURE_TEST()
@@ -0,0 +1,109 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <string>
+#include <vector>
+#include "rxml/value.hpp"
+#include "rxml/locate.hpp"
+#include "rxml/iterators.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	const char* entity_xml =
+		"<root lang='en &amp; de'>"
+			"<title>Tom &amp; Jerry &lt;3</title>"
+			"<code>&#x41;&#66;C</code>"
+			"<plain>no entities</plain>"
+			"<raw>AT&amp;T &unknown;</raw>"
+		"</root>";
+}
+
+struct NonDestructiveTestFixture
+{
+	NonDestructiveTestFixture(const fs::path& xml_path)
+		: file(xml_path.string().c_str())
+		, text(entity_xml, entity_xml + std::char_traits<char>::length(entity_xml) + 1)
+		, copy(text)
+	{
+		BOOST_REQUIRE(file.size());
+		doc.parse<rapidxml::parse_non_destructive>(file.data());
+		entities.parse<rapidxml::parse_non_destructive | rapidxml::parse_trim_whitespace>(&text.front());
+		translated.parse<rapidxml::parse_default>(&copy.front());
+	}
+
+	//#########################################################################################
+	void test_value_like_destructive(const std::string& path)
+	{
+		BOOST_CHECK_EQUAL(rxml::value(entities, path), rxml::value(translated, path));
+		BOOST_CHECK_EQUAL(rxml::valuefb(entities, path, "fallback"), rxml::value(translated, path));
+	}
+
+	//#########################################################################################
+	void test_valuex(const std::string& path, const std::string& regex)
+	{
+		BOOST_CHECK_NO_THROW(rxml::valuex(entities, path, regex));
+	}
+
+	//#########################################################################################
+	void test_text_untouched()
+	{
+		BOOST_CHECK(std::string(&text.front()) == entity_xml);
+	}
+
+	//#########################################################################################
+	void test_path_size(const std::string& path, std::size_t size, const std::string& expected)
+	{
+		// the path is cut off and must not be read beyond its size
+		BOOST_CHECK_EQUAL(rxml::value(doc, path.c_str(), size), expected);
+	}
+
+	//#########################################################################################
+	void test_locate(const std::string& path)
+	{
+		BOOST_CHECK_EQUAL(rxml::locate(rxml::get(doc, path)), "/" + path);
+	}
+
+	//#########################################################################################
+	void test_iterate(const std::string& path, const std::string& expected)
+	{
+		std::string names;
+		for(auto& child : rxml::elements(rxml::getnode(doc, path)))
+			names.append(rxml::name(child)).append(",");
+		BOOST_CHECK_EQUAL(names, expected);
+	}
+
+	rapidxml::file<> file;
+	std::vector<char> text;
+	std::vector<char> copy;
+	rapidxml::xml_document<> doc;
+	rapidxml::xml_document<> entities;
+	rapidxml::xml_document<> translated;
+};
+
+
+
+
+RXML_START_FIXTURE_TEST(NonDestructiveTestFixture, get_rxml_test_path() / "node-test-1.xml")
+
+	RXML_FIXTURE_TEST(test_value_like_destructive, "root/title");
+	RXML_FIXTURE_TEST(test_value_like_destructive, "root/code");
+	RXML_FIXTURE_TEST(test_value_like_destructive, "root/plain");
+	RXML_FIXTURE_TEST(test_value_like_destructive, "root/raw");
+	RXML_FIXTURE_TEST(test_value_like_destructive, "root:lang");
+
+	RXML_FIXTURE_TEST(test_valuex, "root/title", "Tom & Jerry <3");
+	RXML_FIXTURE_TEST(test_text_untouched);
+
+	RXML_FIXTURE_TEST(test_path_size, "node-test/info/author:nickname", 26, "SirTobi");
+	RXML_FIXTURE_TEST(test_path_size, "node-test/xxx/sample:valueX", 26, "bla");
+	RXML_FIXTURE_TEST(test_path_size, "node-test:name", 14, "node-test");
+
+	RXML_FIXTURE_TEST(test_locate, "node-test/info/author");
+	RXML_FIXTURE_TEST(test_locate, "node-test/list/value");
+
+	RXML_FIXTURE_TEST(test_iterate, "node-test/info", "author,version,text,");
+
+RXML_END_FIXTURE_TEST()
@@ -0,0 +1,110 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+#include "test_helpers.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/parallel.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	const int parse_flags = rapidxml::parse_full | rapidxml::parse_trim_whitespace | rapidxml::parse_normalize_whitespace;
+
+	template<typename _Doc>
+	std::string parse_and_dump(_Doc& doc, std::string xml)
+	{
+		xml.push_back('\0');
+		doc.template parse<parse_flags>(&xml[0]);
+
+		std::string result;
+		dump_tree(&doc, result);
+		return result;
+	}
+
+	std::string generate_document(std::size_t records)
+	{
+		std::ostringstream xml;
+		xml << "<?xml version=\"1.0\"?>\n<!-- export -->\n<!DOCTYPE export [ <!ENTITY x \"y\"> ]>\n<export version='2'>\n";
+		for(std::size_t i = 0; i < records; ++i)
+		{
+			xml << "\t<record id=\"" << i << "\" note='a > b'>\n"
+				<< "\t\t<name>Record &amp; number " << i << "</name>\n"
+				<< "\t\t<!-- <fake/> -->\n"
+				<< "\t\t<data><![CDATA[<not><a/><tag>]]></data>\n"
+				<< "\t\t<?process me?>\n"
+				<< "\t\t<empty/>\n"
+				<< "\t</record>\n";
+			if(i % 7 == 0)
+				xml << "\t<!-- separator " << i << " -->\n\t<?marker?>\n";
+		}
+		xml << "</export>\n<!-- trailer -->\n";
+		return xml.str();
+	}
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_parallel_equals_sequential, std::size_t records, unsigned threads, std::size_t min_chunk_size)
+{
+	const std::string xml = generate_document(records);
+
+	rapidxml::xml_document<> sequential;
+	rxml::parallel_document<> parallel(threads, min_chunk_size);
+
+	BOOST_CHECK_EQUAL(parse_and_dump(parallel, xml), parse_and_dump(sequential, xml));
+	BOOST_CHECK(parallel.chunk_count() > 1);
+	BOOST_CHECK(parallel.chunk_count() <= threads);
+}
+
+RXML_PARAM_TEST(test_parallel_equals_sequential, 100, 2, 256);
+RXML_PARAM_TEST(test_parallel_equals_sequential, 100, 4, 256);
+RXML_PARAM_TEST(test_parallel_equals_sequential, 1000, 8, 1024);
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_sequential_fallback, const std::string& xml)
+{
+	rapidxml::xml_document<> sequential;
+	rxml::parallel_document<> parallel(4, 1);
+
+	BOOST_CHECK_EQUAL(parse_and_dump(parallel, xml), parse_and_dump(sequential, xml));
+	BOOST_CHECK_EQUAL(parallel.chunk_count(), 0u);
+}
+
+RXML_PARAM_TEST(test_sequential_fallback, "<root>text <a/> <b/> more text <c/></root>");
+RXML_PARAM_TEST(test_sequential_fallback, "<root><a/><b/><c/></root>");
+RXML_PARAM_TEST(test_sequential_fallback, "<?xml version='1.0'?><root/>");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_parallel_file, const std::string& file_name)
+{
+	rapidxml::file<> file((get_rxml_test_path() / file_name).string().c_str());
+	const std::string xml(file.data(), file.size() - 1);
+
+	rapidxml::xml_document<> sequential;
+	rxml::parallel_document<> parallel(3, 16);
+
+	BOOST_CHECK_EQUAL(parse_and_dump(parallel, xml), parse_and_dump(sequential, xml));
+}
+
+RXML_PARAM_TEST(test_parallel_file, "node-test-1.xml");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_parallel_error, const std::string& broken)
+{
+	std::string xml = generate_document(100);
+	xml.insert(xml.find("\n\t<record", xml.size() / 2), broken);
+	xml.push_back('\0');
+
+	rxml::parallel_document<> parallel(4, 256);
+	BOOST_CHECK_THROW(parallel.parse<parse_flags>(&xml[0]), rapidxml::parse_error);
+}
+
+RXML_PARAM_TEST(test_parallel_error, "\n<broken attr=\"x\" <");
+RXML_PARAM_TEST(test_parallel_error, "\n<unclosed>\n");
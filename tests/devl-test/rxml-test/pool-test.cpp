@@ -0,0 +1,129 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+#include "test_helpers.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/value.hpp"
+
+namespace {
+
+	std::string generate_document(std::size_t records)
+	{
+		std::ostringstream xml;
+		xml << "<list>";
+		for(std::size_t i = 0; i < records; ++i)
+			xml << "<item id='" << i << "' kind='x'><name>item " << i << "</name></item>";
+		xml << "</list>";
+		return xml.str();
+	}
+
+	std::size_t parse_with(rapidxml::xml_document<>& doc, std::string& text)
+	{
+		doc.parse<rapidxml::parse_default>(&text[0]);
+
+		std::size_t count = 0;
+		for(auto* n = doc.first_node()->first_node(); n; n = n->next_sibling())
+			++count;
+		return count;
+	}
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_pool_growth, std::size_t block_size, double growth, std::size_t max_block_size)
+{
+	std::string text = generate_document(5000);
+	counting_arena arena;
+
+	{
+		rapidxml::memory_pool_config config;
+		config.block_size = block_size;
+		config.growth = growth;
+		config.max_block_size = max_block_size;
+		config.arena = &arena;
+
+		rapidxml::xml_document<> doc;
+		doc.configure(config);
+		BOOST_CHECK_EQUAL(parse_with(doc, text), 5000);
+		BOOST_CHECK_EQUAL(rxml::value(doc, "list/item/name"), "item 0");
+		BOOST_REQUIRE(arena.sizes.size() > 1);
+
+		// every block is bigger than the previous one by the growth factor until it hits the limit
+		for(std::size_t i = 1; i < arena.sizes.size(); ++i)
+		{
+			const std::size_t overhead = arena.sizes[0] - block_size;
+			const std::size_t previous = arena.sizes[i - 1] - overhead;
+			const std::size_t current = arena.sizes[i] - overhead;
+			BOOST_CHECK_EQUAL(current, std::min(static_cast<std::size_t>(previous * growth), max_block_size? max_block_size : current));
+		}
+
+		const std::size_t first = arena.sizes.front();
+		doc.clear();
+		BOOST_CHECK_EQUAL(arena.live, 0);
+
+		// growth starts over after clear
+		arena.sizes.clear();
+		text = generate_document(5000);
+		parse_with(doc, text);
+		BOOST_CHECK_EQUAL(arena.sizes.front(), first);
+	}
+
+	BOOST_CHECK_EQUAL(arena.live, 0);
+}
+
+RXML_PARAM_TEST(test_pool_growth, 4096, 1.0, 0);
+RXML_PARAM_TEST(test_pool_growth, 4096, 2.0, 0);
+RXML_PARAM_TEST(test_pool_growth, 4096, 2.0, 32768);
+RXML_PARAM_TEST(test_pool_growth, 1024, 1.5, 0);
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_pool_growth_needs_fewer_blocks)
+{
+	std::string fixed_text = generate_document(20000);
+	std::string growing_text = fixed_text;
+	counting_arena fixed_arena, growing_arena;
+
+	rapidxml::memory_pool_config config;
+	config.block_size = 4096;
+	config.arena = &fixed_arena;
+	rapidxml::xml_document<> fixed;
+	fixed.configure(config);
+	parse_with(fixed, fixed_text);
+
+	config.growth = 2;
+	config.arena = &growing_arena;
+	rapidxml::xml_document<> growing;
+	growing.configure(config);
+	parse_with(growing, growing_text);
+
+	BOOST_CHECK(growing_arena.sizes.size() * 4 < fixed_arena.sizes.size());
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_pool_huge_pages)
+{
+	std::string text = generate_document(20000);
+	std::string copy = text;
+
+	rapidxml::memory_pool_config config;
+	config.huge_pages = true;
+	config.growth = 2;
+	rapidxml::xml_document<> doc;
+	doc.configure(config);
+	BOOST_CHECK_EQUAL(parse_with(doc, text), 20000);
+	BOOST_CHECK(doc.config().huge_pages);
+
+	rapidxml::xml_document<> plain;
+	parse_with(plain, copy);
+	BOOST_CHECK_EQUAL(rxml::value(doc, "list/item:id"), rxml::value(plain, "list/item:id"));
+	BOOST_CHECK_EQUAL(rxml::value(doc.first_node()->last_node()), rxml::value(plain.first_node()->last_node()));
+
+	// large strings exceeding the block size get their own block
+	char* big = doc.allocate_string(nullptr, 5 * 1024 * 1024);
+	std::fill(big, big + 5 * 1024 * 1024, 'x');
+	doc.clear();
+}
@@ -0,0 +1,148 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <string>
+#include <vector>
+#include "rxml/projection.hpp"
+#include "rxml/value.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	const char* config_xml =
+		"<?xml version='1.0'?>\n"
+		"<!-- settings -->\n"
+		"<config version='3'>\n"
+		"\tsome text\n"
+		"\t<db host='localhost'><user>admin</user><pool size='4'/></db>\n"
+		"\t<cache><![CDATA[<db>not a db</db>]]><entry>1</entry></cache>\n"
+		"\t<log level='debug' file='x.log'><target>stderr</target></log>\n"
+		"\t<servers><server>a</server><!-- <server>b</server> --><other/><server>c</server></servers>\n"
+		"\t<db host='remote'><user>guest</user></db>\n"
+		"</config>\n";
+
+	std::size_t count_nodes(const rapidxml::xml_node<>* node)
+	{
+		std::size_t count = 1;
+		for(auto* n = node->first_node(); n; n = n->next_sibling())
+			count += count_nodes(n);
+		return count;
+	}
+}
+
+struct ProjectionTestFixture
+{
+	ProjectionTestFixture(const std::vector<std::string>& paths)
+		: text(config_xml, config_xml + std::char_traits<char>::length(config_xml) + 1)
+		, copy(text)
+	{
+		doc.parse_projected<rapidxml::parse_default>(&text.front(), paths);
+		full.parse<rapidxml::parse_default>(&copy.front());
+	}
+
+	//#########################################################################################
+	void test_like_full(const std::string& path)
+	{
+		BOOST_CHECK_EQUAL(rxml::value(doc, path), rxml::value(full, path));
+	}
+
+	//#########################################################################################
+	void test_missing(const std::string& path)
+	{
+		BOOST_CHECK(!rxml::get(&doc, path));
+	}
+
+	//#########################################################################################
+	void test_node_count(std::size_t expected)
+	{
+		BOOST_CHECK_EQUAL(count_nodes(&doc), expected);
+	}
+
+	//#########################################################################################
+	void test_children(const std::string& path, const std::string& expected)
+	{
+		std::string names;
+		for(auto* n = rxml::getnode(doc, path).first_node(); n; n = n->next_sibling())
+			names.append(n->name(), n->name_size()).append(",");
+		BOOST_CHECK_EQUAL(names, expected);
+	}
+
+	std::vector<char> text;
+	std::vector<char> copy;
+	rxml::projected_document<> doc;
+	rapidxml::xml_document<> full;
+};
+
+
+
+
+RXML_START_FIXTURE_TEST(ProjectionTestFixture, std::vector<std::string>{ "config/db", "/config/log:level", "config/servers/server" })
+
+	RXML_FIXTURE_TEST(test_like_full, "config/db/user");
+	RXML_FIXTURE_TEST(test_like_full, "config/db/pool:size");
+	RXML_FIXTURE_TEST(test_like_full, "config/log:level");
+	RXML_FIXTURE_TEST(test_like_full, "config/log:file");
+	RXML_FIXTURE_TEST(test_like_full, "config:version");
+	RXML_FIXTURE_TEST(test_like_full, "config/servers/server");
+
+	RXML_FIXTURE_TEST(test_missing, "config/cache");
+	RXML_FIXTURE_TEST(test_missing, "config/log/target");
+	RXML_FIXTURE_TEST(test_missing, "config/servers/other");
+
+	// both db elements are kept, cdata and comments are not mistaken for elements
+	RXML_FIXTURE_TEST(test_children, "config", "db,log,servers,db,");
+	RXML_FIXTURE_TEST(test_children, "config/servers", "server,server,");
+
+	// document, config, db with user, data and pool, log, servers with 2 server and data, db with user and data
+	RXML_FIXTURE_TEST(test_node_count, 15);
+
+RXML_END_FIXTURE_TEST()
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_projected_file, const std::string& path, const std::string& expected)
+{
+	rapidxml::file<> file((get_rxml_test_path() / "node-test-1.xml").string().c_str());
+	rxml::projected_document<> doc;
+	doc.parse_projected<rapidxml::parse_default>(file.data(), { path });
+
+	BOOST_CHECK_EQUAL(rxml::value(doc, path), expected);
+}
+
+RXML_PARAM_TEST(test_projected_file, "node-test/info/author:nick", "SirTobi");
+RXML_PARAM_TEST(test_projected_file, "node-test/list/value", "hallo");
+RXML_PARAM_TEST(test_projected_file, "node-test/xxx/sample:value", "bla");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_projected_error, const char* xml)
+{
+	std::string text(xml);
+	rxml::projected_document<> doc;
+	BOOST_CHECK_THROW(doc.parse_projected<rapidxml::parse_default>(&text[0], { "a/b" }), rapidxml::parse_error);
+}
+
+RXML_PARAM_TEST(test_projected_error, "<a><b>");
+RXML_PARAM_TEST(test_projected_error, "<a><c><b/>");
+RXML_PARAM_TEST(test_projected_error, "</a>");
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_projected_namespaces)
+{
+	rxml::projected_document<> doc;
+	for(int round = 0; round < 2; ++round)
+	{
+		// declarations on elements on the way are in scope for the requested subtrees
+		std::string text = "<r xmlns:a='urn:a'><skip/><x><a:y>1</a:y></x></r>";
+		doc.parse_projected<rapidxml::parse_namespaces>(&text[0], { "r/x" });
+		BOOST_CHECK_EQUAL(rxml::value(doc, "{}r/{}x/{urn:a}y"), "1");
+		BOOST_CHECK_EQUAL(doc.namespace_count(), 1);
+	}
+
+	// and only there
+	std::string text = "<r><p xmlns:a='urn:a'><x/></p><q><a:y/></q></r>";
+	BOOST_CHECK_THROW(doc.parse_projected<rapidxml::parse_namespaces>(&text[0], { "r/p/x", "r/q" }), rapidxml::parse_error);
+}
@@ -0,0 +1,171 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <string>
+#include "rxml/reader.hpp"
+#include "rxml/value.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	// tokens of the reader as one string
+	std::string tokens(rxml::reader<>& r)
+	{
+		std::string result;
+		while(r.next())
+		{
+			result.append(r.depth(), ' ');
+			switch(r.type())
+			{
+			case rxml::reader<>::token_start_element:
+				result.append("<").append(r.name(), r.name_size());
+				for(auto& attr : r.attributes())
+					result.append(" ").append(attr.name(), attr.name_size()).append("=").append(attr.value());
+				result.append(">");
+				break;
+			case rxml::reader<>::token_end_element:
+				result.append("</").append(r.name(), r.name_size()).append(">");
+				break;
+			case rxml::reader<>::token_text:
+				result.append("[").append(r.value()).append("]");
+				break;
+			case rxml::reader<>::token_cdata:
+				result.append("{").append(r.value()).append("}");
+				break;
+			default:
+				break;
+			}
+		}
+		return result;
+	}
+}
+
+struct ReaderTestFixture
+{
+	ReaderTestFixture(const fs::path& xml_path)
+		: file(xml_path.string().c_str())
+	{
+		BOOST_REQUIRE(file.size());
+	}
+
+	//#########################################################################################
+	void test_tokens_unmodified()
+	{
+		const std::string before(file.data(), file.size());
+		rxml::reader<> r(file.data());
+		tokens(r);
+		BOOST_CHECK(before == std::string(file.data(), file.size()));
+	}
+
+	//#########################################################################################
+	void test_skip(const std::string& skipped, const std::string& expected_next)
+	{
+		rxml::reader<> r(file.data());
+		while(r.next())
+		{
+			if(r.type() == rxml::reader<>::token_start_element && std::string(r.name(), r.name_size()) == skipped)
+			{
+				const std::size_t depth = r.depth();
+				r.skip();
+				BOOST_CHECK_EQUAL(r.type(), rxml::reader<>::token_end_element);
+				BOOST_CHECK_EQUAL(std::string(r.name(), r.name_size()), skipped);
+				BOOST_CHECK_EQUAL(r.depth(), depth);
+
+				BOOST_REQUIRE(r.next());
+				BOOST_CHECK_EQUAL(std::string(r.name(), r.name_size()), expected_next);
+				return;
+			}
+		}
+		BOOST_ERROR("element not found");
+	}
+
+	//#########################################################################################
+	void test_materialize(const std::string& element, const std::string& path, const std::string& expected)
+	{
+		rxml::reader<> r(file.data());
+		rapidxml::xml_document<> doc;
+
+		while(r.next())
+		{
+			if(r.type() == rxml::reader<>::token_start_element && std::string(r.name(), r.name_size()) == element)
+			{
+				rapidxml::xml_node<>* node = r.materialize<rapidxml::parse_trim_whitespace>(doc);
+				BOOST_REQUIRE(node);
+				BOOST_CHECK_EQUAL(rxml::value(*node, path), expected);
+
+				// the cursor continues behind the element
+				BOOST_CHECK_EQUAL(r.type(), rxml::reader<>::token_end_element);
+				return;
+			}
+		}
+		BOOST_ERROR("element not found");
+	}
+
+	//#########################################################################################
+	void test_attribute(const std::string& element, const char* attr, const std::string& expected)
+	{
+		rxml::reader<> r(file.data());
+		while(r.next())
+		{
+			if(r.type() == rxml::reader<>::token_start_element && std::string(r.name(), r.name_size()) == element)
+			{
+				auto* a = r.attribute(attr);
+				BOOST_REQUIRE(a);
+				BOOST_CHECK_EQUAL(a->value(), expected);
+				BOOST_CHECK(!r.attribute("nonexisting"));
+				return;
+			}
+		}
+		BOOST_ERROR("element not found");
+	}
+
+	rapidxml::file<> file;
+};
+
+
+
+
+RXML_START_FIXTURE_TEST(ReaderTestFixture, get_rxml_test_path() / "node-test-1.xml")
+
+	RXML_FIXTURE_TEST(test_tokens_unmodified);
+
+	RXML_FIXTURE_TEST(test_skip, "info", "list");
+	RXML_FIXTURE_TEST(test_skip, "author", "version");
+	RXML_FIXTURE_TEST(test_skip, "list", "xxx");
+
+	RXML_FIXTURE_TEST(test_materialize, "list", "value", "hallo");
+	RXML_FIXTURE_TEST(test_materialize, "info", "text", "lalala");
+	RXML_FIXTURE_TEST(test_materialize, "xxx", "sample:value", "bla");
+
+	RXML_FIXTURE_TEST(test_attribute, "author", "nick", "SirTobi");
+	RXML_FIXTURE_TEST(test_attribute, "node-test", "name", "node-test");
+
+RXML_END_FIXTURE_TEST()
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_reader_tokens, const char* xml, const std::string& expected)
+{
+	rxml::reader<> r(xml);
+	BOOST_CHECK_EQUAL(tokens(r), expected);
+}
+
+RXML_PARAM_TEST(test_reader_tokens, "<a x='1 &amp; 2'>\n  <b/>\n  text &lt;<!-- c --><?pi?><![CDATA[<raw>]]></a>",
+					"<a x=1 & 2> <b> </b> [\n  text <] {<raw>}</a>");
+RXML_PARAM_TEST(test_reader_tokens, "\xef\xbb\xbf<?xml version='1.0'?><!DOCTYPE a [<!ENTITY e 'x'>]><a></a><!-- end -->",
+					"<a></a>");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_reader_error, const char* xml)
+{
+	rxml::reader<> r(xml);
+	BOOST_CHECK_THROW(while(r.next());, rapidxml::parse_error);
+}
+
+RXML_PARAM_TEST(test_reader_error, "<a><b></a>");
+RXML_PARAM_TEST(test_reader_error, "<a>");
+RXML_PARAM_TEST(test_reader_error, "<a x=1/>");
+RXML_PARAM_TEST(test_reader_error, "text<a/>");
@@ -0,0 +1,183 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/sax.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	// records events as one string, consecutive text events are merged
+	struct recording_handler
+		: public rxml::sax_handler<>
+	{
+		void start_element(const char* name, std::size_t name_size)
+		{
+			flush();
+			log.append("<").append(name, name_size);
+		}
+
+		void attribute(const char* name, std::size_t name_size, const char* value, std::size_t value_size)
+		{
+			flush();
+			log.append(" ").append(name, name_size).append("=").append(value, value_size);
+		}
+
+		void text(const char* text, std::size_t text_size)
+		{
+			pending.append(text, text_size);
+		}
+
+		void end_element(const char* name, std::size_t name_size)
+		{
+			flush();
+			log.append("</").append(name, name_size).append(">");
+		}
+
+		void flush()
+		{
+			if(!pending.empty())
+				log.append("[").append(pending).append("]");
+			pending.clear();
+		}
+
+		std::string log;
+		std::string pending;
+	};
+
+	std::string parse_in_chunks(const std::string& xml, std::size_t chunk_size)
+	{
+		recording_handler handler;
+		rxml::sax_parser<recording_handler> parser(handler);
+
+		for(std::size_t pos = 0; pos < xml.size(); pos += chunk_size)
+			parser.feed(xml.data() + pos, std::min(chunk_size, xml.size() - pos));
+		parser.finish();
+
+		handler.flush();
+		return handler.log;
+	}
+
+	const char* sample =
+		"<?xml version=\"1.0\"?>\n"
+		"<!DOCTYPE doc [ <!ENTITY e \"x\"> ]>\n"
+		"<doc a='1 &amp; 2' b=\"x > y\">"
+			"<!-- comment with <tags> -->"
+			"<item>A &lt;b&gt; &#65;&#x42; &unknown; &</item>"
+			"<empty/>"
+			"<data><![CDATA[<raw> ]] text]]></data>"
+			"<?pi stuff?>"
+		"</doc>";
+
+	const char* sample_events =
+		"[\n\n]<doc a=1 & 2 b=x > y<item[A <b> AB &unknown; &]</item><empty</empty><data[<raw> ]] text]</data></doc>";
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_sax_events, std::size_t chunk_size)
+{
+	BOOST_CHECK_EQUAL(parse_in_chunks(sample, chunk_size), sample_events);
+}
+
+RXML_PARAM_TEST(test_sax_events, 1);
+RXML_PARAM_TEST(test_sax_events, 2);
+RXML_PARAM_TEST(test_sax_events, 5);
+RXML_PARAM_TEST(test_sax_events, 13);
+RXML_PARAM_TEST(test_sax_events, 4096);
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_sax_matches_dom, const std::string& file_name)
+{
+	rapidxml::file<> file((get_rxml_test_path() / file_name).string().c_str());
+	const std::string xml(file.data(), file.size() - 1);
+
+	// dom of all elements and attributes in document order
+	rapidxml::xml_document<> doc;
+	doc.parse<rapidxml::parse_default>(file.data());
+
+	std::string expected;
+	struct walker
+	{
+		static void walk(const rapidxml::xml_node<>* node, std::string& out)
+		{
+			out.append("<").append(node->name(), node->name_size());
+			for(auto* a = node->first_attribute(); a; a = a->next_attribute())
+				out.append(" ").append(a->name(), a->name_size()).append("=").append(a->value(), a->value_size());
+			for(auto* n = node->first_node(); n; n = n->next_sibling())
+			{
+				if(n->type() == rapidxml::node_element)
+					walk(n, out);
+			}
+			out.append("</").append(node->name(), node->name_size()).append(">");
+		}
+	};
+	for(auto* n = doc.first_node(); n; n = n->next_sibling())
+	{
+		if(n->type() == rapidxml::node_element)
+			walker::walk(n, expected);
+	}
+
+	// drop text from the sax log
+	std::string actual;
+	const std::string log = parse_in_chunks(xml, 7);
+	for(std::size_t i = 0; i < log.size(); ++i)
+	{
+		if(log[i] == '[')
+			i = log.find(']', i);
+		else
+			actual.push_back(log[i]);
+	}
+
+	BOOST_CHECK_EQUAL(actual, expected);
+}
+
+RXML_PARAM_TEST(test_sax_matches_dom, "node-test-1.xml");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_sax_error, const std::string& xml, std::size_t offset)
+{
+	recording_handler handler;
+	rxml::sax_parser<recording_handler> parser(handler);
+
+	try
+	{
+		parser.feed(xml);
+		parser.finish();
+		BOOST_ERROR("no sax_error thrown");
+	}catch(const rxml::sax_error& e)
+	{
+		BOOST_CHECK_EQUAL(e.offset(), offset);
+	}
+}
+
+RXML_PARAM_TEST(test_sax_error, "<a><b></a>", 8);
+RXML_PARAM_TEST(test_sax_error, "<a></a></b>", 7);
+RXML_PARAM_TEST(test_sax_error, "<a><b>", 6);
+RXML_PARAM_TEST(test_sax_error, "<a><!-- open", 12);
+RXML_PARAM_TEST(test_sax_error, "<a x=1></a>", 5);
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_sax_bounded_buffer)
+{
+	recording_handler handler;
+	rxml::sax_parser<recording_handler> parser(handler);
+
+	parser.feed("<feed>");
+	for(int i = 0; i < 10000; ++i)
+	{
+		parser.feed("<entry id='1'>some text &amp; more</entry>\n");
+		BOOST_REQUIRE_EQUAL(parser.depth(), 1u);
+	}
+	parser.feed("</feed>");
+	parser.finish();
+
+	BOOST_CHECK_EQUAL(parser.depth(), 0u);
+}
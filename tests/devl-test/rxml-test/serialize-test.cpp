@@ -0,0 +1,103 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/serialize.hpp"
+#include "rapidxml_print.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace {
+
+	template<typename _Ch>
+	std::basic_string<_Ch> print_text(const rapidxml::xml_node<_Ch>& node, int flags)
+	{
+		std::basic_string<_Ch> result;
+		rapidxml::print(std::back_inserter(result), node, flags);
+		return result;
+	}
+
+	template<typename _Ch>
+	void check_like_print(const rapidxml::xml_node<_Ch>& node)
+	{
+		for(int flags : {0, rapidxml::print_no_indenting})
+		{
+			const std::basic_string<_Ch> expected = print_text(node, flags);
+			BOOST_CHECK_EQUAL(rxml::serialized_size(node, flags), expected.size());
+
+			// the guard characters must stay untouched
+			std::vector<_Ch> buffer(expected.size() + 2, _Ch('#'));
+			_Ch* end = rxml::serialize_to(&buffer[1], node, flags);
+			BOOST_CHECK(end == &buffer[1] + expected.size());
+			BOOST_CHECK(buffer.front() == _Ch('#') && buffer.back() == _Ch('#'));
+			BOOST_CHECK(std::basic_string<_Ch>(&buffer[1], end) == expected);
+
+			BOOST_CHECK(rxml::serialize(&node, flags) == expected);
+		}
+	}
+}
+
+
+RXML_PARAM_TEST_CASE(test_serialize_like_print, const std::string& text)
+{
+	std::vector<char> buffer(text.begin(), text.end());
+	buffer.push_back(0);
+
+	rapidxml::xml_document<> doc;
+	doc.parse<rapidxml::parse_full>(&buffer.front());
+	check_like_print<char>(doc);
+
+	for(rapidxml::xml_node<>* node = doc.first_node(); node; node = node->next_sibling())
+		check_like_print<char>(*node);
+}
+
+RXML_PARAM_TEST(test_serialize_like_print, "");
+RXML_PARAM_TEST(test_serialize_like_print, "<a/>");
+RXML_PARAM_TEST(test_serialize_like_print, "<a>text</a>");
+RXML_PARAM_TEST(test_serialize_like_print, "<a x='1' y=\"2\"><b/><c>v</c></a>");
+RXML_PARAM_TEST(test_serialize_like_print, "<a x='&quot;&apos;' y='&apos;&lt;&amp;&gt;'>&lt;&gt;&amp;&quot;&apos;</a>");
+RXML_PARAM_TEST(test_serialize_like_print, "<a>lead<b/>tail<c><d>deep</d></c></a>");
+RXML_PARAM_TEST(test_serialize_like_print, "<?xml version='1.0'?><!DOCTYPE a [ <!ELEMENT a ANY> ]><!-- c --><a><![CDATA[ <raw> & ]]><?pi data?></a>");
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_serialize_built_tree)
+{
+	// values set by hand are not limited to what the parser produces
+	rapidxml::xml_document<> doc;
+	rapidxml::xml_node<>* root = doc.allocate_node(rapidxml::node_element, "root", "value & <more>");
+	doc.append_node(root);
+	root->append_attribute(doc.allocate_attribute("empty", ""));
+	root->append_attribute(doc.allocate_attribute("both", "'\""));
+	check_like_print<char>(doc);
+
+	root->append_node(doc.allocate_node(rapidxml::node_data, nullptr, "\"quoted\""));
+	root->append_node(doc.allocate_node(rapidxml::node_element, "child"));
+	check_like_print<char>(doc);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_serialize_wide)
+{
+	std::wstring text = L"<a x='\x263A &amp;'><b>\x263A &lt;</b><c/></a>";
+	rapidxml::xml_document<wchar_t> doc;
+	doc.parse<0>(&text[0]);
+	check_like_print<wchar_t>(doc);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_serialize_file)
+{
+	rapidxml::file<> file((get_rxml_test_path() / "node-test-1.xml").string().c_str());
+	rapidxml::xml_document<> doc;
+	doc.parse<rapidxml::parse_full>(file.data());
+	check_like_print<char>(doc);
+
+	std::ostringstream stream;
+	static_cast<std::ostream&>(stream) << doc;
+	BOOST_CHECK(rxml::serialize(doc) == stream.str());
+}
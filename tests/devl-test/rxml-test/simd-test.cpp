@@ -0,0 +1,279 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "rapidxml_utils.hpp"
+#include "rapidxml_print.hpp"
+#include "rxml/serialize.hpp"
+
+#ifdef RAPIDXML_SIMD
+
+namespace {
+
+	typedef rapidxml::internal::lookup_tables<0> tables;
+
+	const unsigned char* lookup_table(const std::string& name)
+	{
+		if(name == "whitespace")			return tables::lookup_whitespace;
+		if(name == "node_name")				return tables::lookup_node_name;
+		if(name == "text")					return tables::lookup_text;
+		if(name == "text_pure_no_ws")		return tables::lookup_text_pure_no_ws;
+		if(name == "text_pure_with_ws")		return tables::lookup_text_pure_with_ws;
+		if(name == "attribute_name")		return tables::lookup_attribute_name;
+		if(name == "attribute_data_1")		return tables::lookup_attribute_data_1;
+		if(name == "attribute_data_1_pure")	return tables::lookup_attribute_data_1_pure;
+		if(name == "attribute_data_2")		return tables::lookup_attribute_data_2;
+		return tables::lookup_attribute_data_2_pure;
+	}
+
+	const char* scalar_scan(const char* text, const unsigned char* table)
+	{
+		while(table[static_cast<unsigned char>(*text)])
+			++text;
+		return text;
+	}
+
+	// random text, biased towards characters that continue the scan so that runs get long
+	std::vector<char> random_text(std::mt19937& rng, const unsigned char* table, std::size_t size)
+	{
+		std::vector<char> stops;
+		std::vector<char> runs;
+		for(int c = 1; c < 256; ++c)
+			(table[c]? runs : stops).push_back(static_cast<char>(c));
+
+		std::vector<char> text(size + 64, '\0');
+		for(std::size_t i = 0; i < size; ++i)
+			text[i] = (rng() % 64 || stops.empty())? runs[rng() % runs.size()] : stops[rng() % stops.size()];
+		return text;
+	}
+
+	std::string parse_and_print(const char* xml)
+	{
+		std::vector<char> buffer(xml, xml + std::strlen(xml) + 1);
+		rapidxml::xml_document<> doc;
+		doc.parse<rapidxml::parse_full | rapidxml::parse_trim_whitespace | rapidxml::parse_normalize_whitespace>(&buffer.front());
+
+		// dump names and values in document order
+		std::string result;
+		for(rapidxml::xml_node<>* n = doc.first_node(); n; )
+		{
+			result.append(n->name(), n->name_size()).append("|").append(n->value(), n->value_size()).append("|");
+			for(rapidxml::xml_attribute<>* a = n->first_attribute(); a; a = a->next_attribute())
+				result.append(a->name(), a->name_size()).append("=").append(a->value(), a->value_size()).append("|");
+
+			if(n->first_node())
+			{
+				n = n->first_node();
+				continue;
+			}
+			while(n != &doc && !n->next_sibling())
+				n = n->parent();
+			n = (n != &doc)? n->next_sibling() : nullptr;
+		}
+		return result;
+	}
+
+	const char* scalar_find(const char* text, const char* end, const unsigned char* table)
+	{
+		while(text < end && table[static_cast<unsigned char>(*text)])
+			++text;
+		return text;
+	}
+
+	std::string print_escaped(const std::string& text, char noexpand)
+	{
+		std::string result;
+		rapidxml::internal::copy_and_expand_chars(text.data(), text.data() + text.size(), noexpand, std::back_inserter(result));
+		return result;
+	}
+
+	struct restore_simd_level
+	{
+		~restore_simd_level()
+		{
+			rapidxml::internal::simd_select(rapidxml::internal::simd_avx2);
+		}
+	};
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_kernel_matches_scalar, rapidxml::internal::simd_level level, const std::string& table_name)
+{
+	if(!rapidxml::internal::simd_supported(level))
+		return;
+
+	const unsigned char* table = lookup_table(table_name);
+	rapidxml::internal::simd_charset set = rapidxml::internal::simd_charset::from_table(table);
+	rapidxml::internal::simd_scan_func* kernel = rapidxml::internal::simd_kernel(level);
+
+	std::mt19937 rng(29);
+	for(int round = 0; round < 200; ++round)
+	{
+		std::vector<char> text = random_text(rng, table, 1 + rng() % 300);
+
+		// the kernels start on aligned blocks
+		const char* begin = &text.front();
+		while(reinterpret_cast<std::size_t>(begin) & 15)
+			++begin;
+
+		BOOST_REQUIRE_EQUAL(kernel(begin, set) - begin, scalar_scan(begin, table) - begin);
+	}
+}
+
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_sse2, "whitespace");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_sse2, "text");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_sse2, "attribute_name");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_sse2, "attribute_data_2_pure");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_ssse3, "whitespace");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_ssse3, "node_name");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_ssse3, "text_pure_with_ws");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_ssse3, "attribute_data_1");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_avx2, "whitespace");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_avx2, "text_pure_no_ws");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_avx2, "attribute_name");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_avx2, "attribute_data_1_pure");
+RXML_PARAM_TEST(test_kernel_matches_scalar, rapidxml::internal::simd_avx2, "attribute_data_2");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_charset_usable, const std::string& members, bool usable)
+{
+	// the listed characters stop the scan
+	unsigned char table[256];
+	for(int c = 0; c < 256; ++c)
+		table[c] = members.find(static_cast<char>(c)) == std::string::npos;
+
+	rapidxml::internal::simd_charset set = rapidxml::internal::simd_charset::from_table(table);
+	BOOST_CHECK_EQUAL(set.usable, usable);
+	if(usable)
+		BOOST_CHECK_EQUAL(set.count, static_cast<int>(members.size()));
+	else
+		BOOST_CHECK(set.count <= 16);
+}
+
+RXML_PARAM_TEST(test_charset_usable, "<&", true);
+RXML_PARAM_TEST(test_charset_usable, "0123456789abcdef", true);
+RXML_PARAM_TEST(test_charset_usable, "0123456789abcdefg", false);
+RXML_PARAM_TEST(test_charset_usable, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ", false);
+RXML_PARAM_TEST(test_charset_usable, "<\xE9", false);
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_parse_matches_across_levels, const char* xml)
+{
+	restore_simd_level restore;
+
+	rapidxml::internal::simd_select(rapidxml::internal::simd_sse2);
+	const std::string expected = parse_and_print(xml);
+
+	rapidxml::internal::simd_select(rapidxml::internal::simd_ssse3);
+	BOOST_CHECK_EQUAL(parse_and_print(xml), expected);
+
+	rapidxml::internal::simd_select(rapidxml::internal::simd_avx2);
+	BOOST_CHECK_EQUAL(parse_and_print(xml), expected);
+}
+
+RXML_PARAM_TEST(test_parse_matches_across_levels, "<root a='1' bb=\"two &amp; three\"><item>some text that is longer than a single block of sixteen bytes</item><!-- c --><x/></root>");
+RXML_PARAM_TEST(test_parse_matches_across_levels, "<?xml version=\"1.0\"?>\n<root>\n\t<name-with-long-identifier attribute-with-long-name='  spaced   value  '>  &lt;escaped&gt;  \xc3\xa4\xc3\xb6\xc3\xbc  </name-with-long-identifier>\n</root>");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_find_kernel_matches_scalar, rapidxml::internal::simd_level level, const std::string& table_name)
+{
+	if(!rapidxml::internal::simd_supported(level))
+		return;
+
+	const unsigned char* table = lookup_table(table_name);
+	rapidxml::internal::simd_charset set = rapidxml::internal::simd_charset::from_table(table);
+	rapidxml::internal::simd_find_func* kernel = rapidxml::internal::simd_find_kernel(level);
+
+	std::mt19937 rng(47);
+	for(int round = 0; round < 500; ++round)
+	{
+		const std::size_t size = 1 + rng() % 300;
+		std::vector<char> text = random_text(rng, table, size + 32);
+
+		// any start and end, the bytes past the end must be ignored
+		const char* begin = &text.front() + rng() % 32;
+		const char* end = begin + rng() % (size + 1);
+		BOOST_REQUIRE_EQUAL(kernel(begin, end, set) - begin, scalar_find(begin, end, table) - begin);
+	}
+}
+
+RXML_PARAM_TEST(test_find_kernel_matches_scalar, rapidxml::internal::simd_sse2, "text");
+RXML_PARAM_TEST(test_find_kernel_matches_scalar, rapidxml::internal::simd_sse2, "attribute_data_1");
+RXML_PARAM_TEST(test_find_kernel_matches_scalar, rapidxml::internal::simd_ssse3, "whitespace");
+RXML_PARAM_TEST(test_find_kernel_matches_scalar, rapidxml::internal::simd_ssse3, "attribute_data_2_pure");
+RXML_PARAM_TEST(test_find_kernel_matches_scalar, rapidxml::internal::simd_avx2, "text_pure_no_ws");
+RXML_PARAM_TEST(test_find_kernel_matches_scalar, rapidxml::internal::simd_avx2, "attribute_name");
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_escaping_matches_across_levels)
+{
+	restore_simd_level restore;
+
+	const std::string specials = "<>'\"&";
+	std::mt19937 rng(7);
+	std::vector<std::string> texts;
+	for(int round = 0; round < 300; ++round)
+	{
+		std::string text(rng() % 200, 'x');
+		for(auto& ch : text)
+		{
+			if(rng() % 24 == 0)
+				ch = specials[rng() % specials.size()];
+			else if(rng() % 8 == 0)
+				ch = static_cast<char>(rng() % 256);
+		}
+		texts.push_back(text);
+	}
+
+	rapidxml::internal::simd_select(rapidxml::internal::simd_sse2);
+	std::vector<std::string> expected;
+	for(auto& text : texts)
+	{
+		for(char noexpand : {'\0', '"', '\'', '<'})
+		{
+			// what the character by character printer wrote
+			std::string plain;
+			for(char ch : text)
+			{
+				if(ch == noexpand)						plain += ch;
+				else if(ch == '<')						plain += "&lt;";
+				else if(ch == '>')						plain += "&gt;";
+				else if(ch == '\'')						plain += "&apos;";
+				else if(ch == '"')						plain += "&quot;";
+				else if(ch == '&')						plain += "&amp;";
+				else									plain += ch;
+			}
+			BOOST_REQUIRE_EQUAL(print_escaped(text, noexpand), plain);
+			expected.push_back(plain);
+		}
+	}
+
+	for(auto level : {rapidxml::internal::simd_ssse3, rapidxml::internal::simd_avx2})
+	{
+		rapidxml::internal::simd_select(level);
+		std::size_t i = 0;
+		for(auto& text : texts)
+		{
+			for(char noexpand : {'\0', '"', '\'', '<'})
+				BOOST_REQUIRE_EQUAL(print_escaped(text, noexpand), expected[i++]);
+		}
+	}
+
+	// the serializer escapes the same way
+	std::string xml = "<a x='" + std::string(40, 'v') + "&quot;&apos;&lt;'>" + std::string(40, 't') + "&amp;&gt;</a>";
+	rapidxml::xml_document<> doc;
+	doc.parse<0>(&xml[0]);
+	std::string printed;
+	rapidxml::print(std::back_inserter(printed), doc);
+	BOOST_CHECK_EQUAL(rxml::serialize(doc), printed);
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "rxml/slices.hpp"
+#include "rapidxml_print.hpp"
+
+namespace {
+
+	template<typename _Ch>
+	void check_like_print(const rapidxml::xml_node<_Ch>& node, std::size_t min_reference)
+	{
+		for(int flags : {0, rapidxml::print_no_indenting})
+		{
+			std::basic_string<_Ch> expected;
+			rapidxml::print(std::back_inserter(expected), node, flags);
+
+			const rxml::slice_list<_Ch> slices = rxml::serialize_slices(node, flags, min_reference);
+			BOOST_CHECK_EQUAL(slices.total_size(), expected.size());
+			BOOST_CHECK(slices.str() == expected);
+
+			for(auto& s : slices)
+				BOOST_CHECK(s.size > 0);
+		}
+	}
+
+	bool points_into(const rxml::slice<>& s, const std::vector<char>& buffer)
+	{
+		return s.data >= buffer.data() && s.data + s.size <= buffer.data() + buffer.size();
+	}
+}
+
+
+RXML_PARAM_TEST_CASE(test_slices_like_print, const std::string& text)
+{
+	std::vector<char> buffer(text.begin(), text.end());
+	buffer.push_back(0);
+
+	rapidxml::xml_document<> doc;
+	doc.parse<rapidxml::parse_full>(&buffer.front());
+	for(std::size_t min_reference : {0, 1, 4, 16})
+	{
+		check_like_print<char>(doc, min_reference);
+		for(rapidxml::xml_node<>* node = doc.first_node(); node; node = node->next_sibling())
+			check_like_print<char>(*node, min_reference);
+	}
+}
+
+RXML_PARAM_TEST(test_slices_like_print, "");
+RXML_PARAM_TEST(test_slices_like_print, "<a/>");
+RXML_PARAM_TEST(test_slices_like_print, "<a>text</a>");
+RXML_PARAM_TEST(test_slices_like_print, "<a x='1' y=\"2\"><b/><c>v</c></a>");
+RXML_PARAM_TEST(test_slices_like_print, "<a x='&quot;&apos;' y='&apos;&lt;&amp;&gt;'>&lt;&gt;&amp;&quot;&apos;</a>");
+RXML_PARAM_TEST(test_slices_like_print, "<a>lead<b/>tail<c><d>a rather long text &lt;with&gt; escapes</d></c></a>");
+RXML_PARAM_TEST(test_slices_like_print, "<?xml version='1.0'?><!DOCTYPE a [ <!ELEMENT a ANY> ]><!-- c --><a><![CDATA[ <raw> & ]]><?pi data?></a>");
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_slices_reference_document)
+{
+	const std::string text =
+		"<root>"
+		"<first>a value long enough to be referenced</first>"
+		"<second>another long value &amp; an escaped one after it</second>"
+		"</root>";
+	std::vector<char> buffer(text.begin(), text.end());
+	buffer.push_back(0);
+
+	rapidxml::xml_document<> doc;
+	doc.parse<0>(&buffer.front());
+	const rxml::slice_list<> slices = rxml::serialize_slices(doc, rapidxml::print_no_indenting);
+
+	// both long values and the run in front of the reference come from the parsed text
+	std::vector<std::string> referenced;
+	for(auto& s : slices)
+	{
+		if(points_into(s, buffer))
+			referenced.push_back(std::string(s.data, s.size));
+	}
+	BOOST_REQUIRE_EQUAL(referenced.size(), 3u);
+	BOOST_CHECK_EQUAL(referenced[0], "a value long enough to be referenced");
+	BOOST_CHECK_EQUAL(referenced[1], "another long value ");
+	BOOST_CHECK_EQUAL(referenced[2], " an escaped one after it");
+
+	// markup between them is merged into single slices
+	BOOST_CHECK_EQUAL(slices.size(), 7u);
+	BOOST_CHECK_EQUAL(std::string(slices[0].data, slices[0].size), "<root><first>");
+	BOOST_CHECK_EQUAL(std::string(slices[4].data, slices[4].size), "&amp;");
+	BOOST_CHECK_EQUAL(slices.generated_size() + 19 + 36 + 24, slices.total_size());
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_slices_deep_indent)
+{
+	// indentation deeper than a block of generated text
+	rapidxml::xml_document<> doc;
+	rapidxml::xml_node<>* parent = &doc;
+	for(int i = 0; i < 5000; ++i)
+	{
+		rapidxml::xml_node<>* child = doc.allocate_node(rapidxml::node_element, "e");
+		parent->append_node(child);
+		parent = child;
+	}
+	check_like_print<char>(doc, 16);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_slices_wide)
+{
+	std::wstring text = L"<a x='\x263A &amp;'><b>\x263A &lt;</b><c/></a>";
+	rapidxml::xml_document<wchar_t> doc;
+	doc.parse<0>(&text[0]);
+	check_like_print<wchar_t>(doc, 0);
+	check_like_print<wchar_t>(doc, 16);
+}
+
+
+#ifdef RXML_SLICES_WRITEV
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_slices_write_to)
+{
+	// more slices than a single writev takes
+	rapidxml::xml_document<> doc;
+	rapidxml::xml_node<>* root = doc.allocate_node(rapidxml::node_element, "root");
+	doc.append_node(root);
+	for(int i = 0; i < 3000; ++i)
+		root->append_node(doc.allocate_node(rapidxml::node_element, "item", "a value referenced by a slice"));
+
+	const rxml::slice_list<> slices = rxml::serialize_slices(doc);
+	BOOST_CHECK(slices.size() > IOV_MAX);
+
+	std::string expected;
+	rapidxml::print(std::back_inserter(expected), doc);
+
+	std::FILE* out = std::tmpfile();
+	BOOST_REQUIRE(out);
+	BOOST_CHECK_EQUAL(slices.write_to(fileno(out)), expected.size());
+
+	std::rewind(out);
+	std::string result;
+	for(int ch; (ch = std::fgetc(out)) != EOF; )
+		result += static_cast<char>(ch);
+	std::fclose(out);
+	BOOST_CHECK(result == expected);
+}
+#endif
@@ -0,0 +1,234 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <boost/filesystem.hpp>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "rxml/locate.hpp"
+#include "rxml/snapshot.hpp"
+#include "rxml/value.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	struct temp_path
+	{
+		explicit temp_path(const char* pattern)
+			: path(fs::temp_directory_path() / fs::unique_path(pattern))
+		{
+		}
+
+		~temp_path()
+		{
+			fs::remove(path);
+			fs::remove(path.string() + ".tmp");
+		}
+
+		void write(const std::string& content) const
+		{
+			std::ofstream out(path.string().c_str(), std::ios::binary | std::ios::trunc);
+			out << content;
+		}
+
+		std::string string() const
+		{
+			return path.string();
+		}
+
+		fs::path path;
+	};
+}
+
+struct SnapshotTestFixture
+{
+	SnapshotTestFixture(const fs::path& xml_path)
+		: file(xml_path.string().c_str())
+		, snapshot("rxml-%%%%-%%%%.snap")
+	{
+		const rxml::snapshot_source source = rxml::describe_snapshot_source(file.data(), file.size() - 1);
+		full.parse<rapidxml::parse_full>(file.data());
+		rxml::save_snapshot(snapshot.string(), full, source);
+
+		doc.load(snapshot.string());
+		BOOST_CHECK(doc.source() == source);
+	}
+
+	//#########################################################################################
+	void test_value(const std::string& path)
+	{
+		BOOST_CHECK_EQUAL(rxml::value(doc, path), rxml::value(full, path));
+	}
+
+	//#########################################################################################
+	void test_locate(const std::string& path, const std::string& expected)
+	{
+		BOOST_CHECK_EQUAL(rxml::locate(rxml::get(doc, path)), expected);
+	}
+
+	//#########################################################################################
+	void test_children(const std::string& path)
+	{
+		std::string expected, names;
+		for(auto& child : rxml::children(rxml::getnode(full, path)))
+			expected += std::to_string(child.type()) + rxml::name(child) + ",";
+		for(auto& child : rxml::children(rxml::getnode(doc, path)))
+			names += std::to_string(child.type()) + rxml::name(child) + ",";
+		BOOST_CHECK_EQUAL(names, expected);
+	}
+
+	rapidxml::file<> file;
+	rapidxml::xml_document<> full;
+	temp_path snapshot;
+	rxml::snapshot_document<> doc;
+};
+
+
+RXML_START_FIXTURE_TEST(SnapshotTestFixture, get_rxml_test_path() / "node-test-1.xml")
+
+	RXML_FIXTURE_TEST(test_value, "node-test:name");
+	RXML_FIXTURE_TEST(test_value, "node-test/info");
+	RXML_FIXTURE_TEST(test_value, "node-test/info/author:nick");
+	RXML_FIXTURE_TEST(test_value, "node-test/list/value");
+	RXML_FIXTURE_TEST(test_value, "/node-test/xxx/../xxx/sample:value");
+
+	RXML_FIXTURE_TEST(test_locate, "node-test/info/author:nick", "/node-test/info/author:nick");
+	RXML_FIXTURE_TEST(test_locate, "node-test/list", "/node-test/list");
+
+	// parse_full keeps the declaration and data nodes, the snapshot keeps them too
+	RXML_FIXTURE_TEST(test_children, "");
+	RXML_FIXTURE_TEST(test_children, "node-test/info");
+
+RXML_END_FIXTURE_TEST()
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_snapshot_entities)
+{
+	std::string text = "<a x='1 &amp;lt; 2'>&amp;amp;<b>&lt;</b></a>";
+	std::string raw = text;
+	temp_path decoded_snapshot("rxml-%%%%-%%%%.snap"), raw_snapshot("rxml-%%%%-%%%%.snap");
+
+	// entities are decoded by the parser in one case and by rxml::value in the other
+	rapidxml::xml_document<> decoded;
+	decoded.parse<rapidxml::parse_default>(&text[0]);
+	rxml::save_snapshot(decoded_snapshot.string(), decoded, rxml::snapshot_source());
+
+	rxml::compact_document<> compact;
+	compact.parse(raw.c_str());
+	rxml::save_snapshot(raw_snapshot.string(), compact, rxml::snapshot_source());
+
+	for(auto* snapshot : { &decoded_snapshot, &raw_snapshot })
+	{
+		rxml::snapshot_document<> doc;
+		doc.load(snapshot->string());
+		BOOST_CHECK_EQUAL(rxml::value(doc, "a:x"), "1 &lt; 2");
+		BOOST_CHECK_EQUAL(rxml::value(doc, "a"), "&amp;");
+		BOOST_CHECK_EQUAL(rxml::value(doc, "a/b"), "<");
+	}
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_snapshot_load_or_build)
+{
+	temp_path source("rxml-%%%%-%%%%.xml"), snapshot("rxml-%%%%-%%%%.snap");
+	source.write("<config><db host='one'/></config>");
+
+	rxml::snapshot_document<> doc;
+	BOOST_CHECK(doc.load_or_build(snapshot.string(), source.string()));
+	BOOST_CHECK_EQUAL(rxml::value(doc, "config/db:host"), "one");
+
+	BOOST_CHECK(!doc.load_or_build(snapshot.string(), source.string()));
+	BOOST_CHECK_EQUAL(rxml::value(doc, "config/db:host"), "one");
+
+	// a changed source makes the snapshot stale
+	source.write("<config><db host='two'/></config>");
+	BOOST_CHECK(doc.load_or_build(snapshot.string(), source.string()));
+	BOOST_CHECK_EQUAL(rxml::value(doc, "config/db:host"), "two");
+	BOOST_CHECK(!fs::exists(snapshot.string() + ".tmp"));
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_snapshot_invalid, std::size_t truncate, std::size_t corrupt)
+{
+	temp_path source("rxml-%%%%-%%%%.xml"), snapshot("rxml-%%%%-%%%%.snap");
+	source.write("<a><b/></a>");
+
+	rxml::snapshot_document<> doc;
+	doc.load_or_build(snapshot.string(), source.string());
+	doc.clear();
+
+	std::string bytes;
+	{
+		std::ifstream in(snapshot.string().c_str(), std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	bytes.resize(bytes.size() - truncate);
+	if(corrupt < bytes.size())
+		bytes[corrupt] ^= 0x40;
+	snapshot.write(bytes);
+
+	BOOST_CHECK(!doc.try_load(snapshot.string()));
+	BOOST_CHECK_THROW(doc.load(snapshot.string()), std::runtime_error);
+	BOOST_CHECK(!doc.first_node());
+
+	// and is rebuilt
+	BOOST_CHECK(doc.load_or_build(snapshot.string(), source.string()));
+	BOOST_CHECK(rxml::getnode(&doc, "a/b"));
+}
+
+RXML_PARAM_TEST(test_snapshot_invalid, 1, std::size_t(-1));		// truncated
+RXML_PARAM_TEST(test_snapshot_invalid, 0, 0);					// magic
+RXML_PARAM_TEST(test_snapshot_invalid, 0, 8);					// version
+RXML_PARAM_TEST(test_snapshot_invalid, 0, sizeof(rxml::detail::snapshot_header) + 20);	// node record
+RXML_PARAM_TEST(test_snapshot_invalid, 0, sizeof(rxml::detail::snapshot_header) + 3 * sizeof(rxml::detail::compact_node_record) + 1);	// pool
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_snapshot_out_of_bounds, std::size_t field, std::uint32_t value)
+{
+	typedef rxml::detail::snapshot_header header_type;
+	typedef rxml::detail::compact_node_record node_record;
+
+	temp_path source("rxml-%%%%-%%%%.xml"), snapshot("rxml-%%%%-%%%%.snap");
+	source.write("<a x='1'><b/></a>");
+
+	rxml::snapshot_document<> doc;
+	doc.load_or_build(snapshot.string(), source.string());
+	doc.clear();
+
+	std::string bytes;
+	{
+		std::ifstream in(snapshot.string().c_str(), std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	// a record of the element <a> points elsewhere, but the checksum matches
+	std::memcpy(&bytes[sizeof(header_type) + sizeof(node_record) + field], &value, sizeof(value));
+	header_type header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	const char* nodes = bytes.data() + sizeof(header);
+	const char* attributes = nodes + header.node_count * sizeof(node_record);
+	const char* pool = attributes + header.attribute_count * sizeof(rxml::detail::compact_attribute_record);
+	header.body_checksum = rxml::snapshot_checksum(nodes, attributes - nodes);
+	header.body_checksum = rxml::snapshot_checksum(attributes, pool - attributes, header.body_checksum);
+	header.body_checksum = rxml::snapshot_checksum(pool, bytes.data() + bytes.size() - pool, header.body_checksum);
+	std::memcpy(&bytes[0], &header, sizeof(header));
+	snapshot.write(bytes);
+
+	BOOST_CHECK(!doc.try_load(snapshot.string()));
+	BOOST_CHECK(doc.load_or_build(snapshot.string(), source.string()));
+	BOOST_CHECK_EQUAL(rxml::value(doc, "a:x"), "1");
+}
+
+RXML_PARAM_TEST(test_snapshot_out_of_bounds, offsetof(rxml::detail::compact_node_record, name), 1000);
+RXML_PARAM_TEST(test_snapshot_out_of_bounds, offsetof(rxml::detail::compact_node_record, value_size), 1000);
+RXML_PARAM_TEST(test_snapshot_out_of_bounds, offsetof(rxml::detail::compact_node_record, parent), 5);
+RXML_PARAM_TEST(test_snapshot_out_of_bounds, offsetof(rxml::detail::compact_node_record, first_child), 0);
+RXML_PARAM_TEST(test_snapshot_out_of_bounds, offsetof(rxml::detail::compact_node_record, next_sibling), 3);
+RXML_PARAM_TEST(test_snapshot_out_of_bounds, offsetof(rxml::detail::compact_node_record, first_attribute), 1);
@@ -0,0 +1,119 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rapidxml_utils.hpp"
+
+#ifdef RAPIDXML_PARSE_STATISTICS
+
+namespace {
+
+	std::map<std::string, unsigned long long> export_metrics(const rapidxml::parse_statistics& statistics)
+	{
+		std::map<std::string, unsigned long long> metrics;
+		statistics.visit([&](const char* name, unsigned long long value) { metrics[name] = value; });
+		return metrics;
+	}
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_statistics_counts)
+{
+	std::string text = "<?xml version='1.0'?><!-- c --><a x='1&amp;2' y='&#65;'>t &lt;<b><c/></b><![CDATA[d]]><?pi e?></a>";
+	std::vector<char> buffer(text.begin(), text.end());
+	buffer.push_back(0);
+
+	rapidxml::parse_statistics statistics;
+	rapidxml::xml_document<> doc;
+	doc.collect_statistics(&statistics);
+	doc.parse<rapidxml::parse_full>(&buffer.front());
+
+	BOOST_CHECK_EQUAL(statistics.bytes_scanned, text.size());
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_document], 0);
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_element], 3);
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_data], 1);
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_cdata], 1);
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_comment], 1);
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_declaration], 1);
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_pi], 1);
+	BOOST_CHECK_EQUAL(statistics.pool.attributes, 3);
+	BOOST_CHECK_EQUAL(statistics.entity_expansions, 3);
+	BOOST_CHECK_EQUAL(statistics.max_depth, 3);
+
+	// everything fits into the static block of the pool
+	BOOST_CHECK_EQUAL(statistics.pool.blocks, 0);
+	BOOST_CHECK(statistics.pool.allocated_bytes >= 8 * sizeof(rapidxml::xml_node<>) + 3 * sizeof(rapidxml::xml_attribute<>));
+	BOOST_CHECK(statistics.total_ns >= statistics.attribute_ns + statistics.data_ns);
+
+	// a second parse describes only itself
+	std::vector<char> small = {'<', 'r', '/', '>', 0};
+	doc.parse<0>(&small.front());
+	BOOST_CHECK_EQUAL(statistics.bytes_scanned, 4);
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_element], 1);
+	BOOST_CHECK_EQUAL(statistics.pool.attributes, 0);
+	BOOST_CHECK_EQUAL(statistics.entity_expansions, 0);
+	BOOST_CHECK_EQUAL(statistics.max_depth, 1);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_statistics_pool)
+{
+	std::ostringstream xml;
+	xml << "<list>";
+	for(std::size_t i = 0; i < 5000; ++i)
+		xml << "<item id='" << i << "'>value</item>";
+	xml << "</list>";
+	std::string text = xml.str();
+
+	rapidxml::parse_statistics statistics;
+	rapidxml::xml_document<> doc;
+	doc.collect_statistics(&statistics);
+	doc.parse<rapidxml::parse_no_data_nodes>(&text[0]);
+
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_element], 5001);
+	BOOST_CHECK_EQUAL(statistics.pool.attributes, 5000);
+	BOOST_CHECK(statistics.pool.blocks > 0);
+	BOOST_CHECK(statistics.pool.block_bytes >= statistics.pool.blocks * RAPIDXML_DYNAMIC_POOL_SIZE);
+	BOOST_CHECK_EQUAL(statistics.pool.blocks, doc.allocation_statistics().blocks);
+
+	// the pool counters keep growing, the parse statistics do not
+	doc.allocate_string("padding", 3);
+	BOOST_CHECK_EQUAL(doc.allocation_statistics().allocated_bytes, statistics.pool.allocated_bytes + 3);
+
+	doc.collect_statistics(0);
+	std::string again = xml.str();
+	doc.parse<0>(&again[0]);
+	BOOST_CHECK_EQUAL(statistics.pool.attributes, 5000);
+	BOOST_CHECK_EQUAL(doc.allocation_statistics().attributes, 10000);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_statistics_error_and_export)
+{
+	std::string text = "<a><b>&amp;</b><c></a>";
+
+	rapidxml::parse_statistics statistics;
+	rapidxml::xml_document<> doc;
+	doc.collect_statistics(&statistics);
+	BOOST_CHECK_THROW(doc.parse<0>(&text[0]), rapidxml::parse_error);
+
+	// counts up to the error
+	BOOST_CHECK_EQUAL(statistics.pool.nodes[rapidxml::node_element], 3);
+	BOOST_CHECK_EQUAL(statistics.entity_expansions, 1);
+
+	const std::map<std::string, unsigned long long> metrics = export_metrics(statistics);
+	BOOST_CHECK_EQUAL(metrics.size(), 19);
+	BOOST_CHECK_EQUAL(metrics.at("nodes.element"), 3);
+	BOOST_CHECK_EQUAL(metrics.at("entity_expansions"), 1);
+	BOOST_CHECK_EQUAL(metrics.at("max_depth"), 2);
+	BOOST_CHECK(metrics.count("time.total_ns"));
+	BOOST_CHECK(metrics.count("pool.padding_bytes"));
+}
+
+#endif
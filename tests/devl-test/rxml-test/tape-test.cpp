@@ -0,0 +1,166 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "rxml/tape.hpp"
+#include "rxml/locate.hpp"
+#include "rxml/value.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+	// compares names, values and structure of both trees
+	void check_equal(const rxml::tape_node<>& tape, const rapidxml::xml_node<>* node)
+	{
+		BOOST_REQUIRE_EQUAL(tape.type(), node->type());
+		BOOST_CHECK_EQUAL(rxml::name(tape), rxml::name(node));
+		BOOST_CHECK_EQUAL(rxml::value(tape), rxml::value(node));
+
+		auto attr = tape.first_attribute();
+		for(auto* a = node->first_attribute(); a; a = a->next_attribute(), attr = attr.next_attribute())
+		{
+			BOOST_REQUIRE(attr);
+			BOOST_CHECK_EQUAL(rxml::name(attr), rxml::name(a));
+			BOOST_CHECK_EQUAL(rxml::value(attr), rxml::value(a));
+			BOOST_CHECK(attr.parent() == tape);
+		}
+		BOOST_CHECK(!attr);
+
+		auto child = tape.first_node();
+		for(auto* n = node->first_node(); n; n = n->next_sibling(), child = child.next_sibling())
+		{
+			BOOST_REQUIRE(child);
+			BOOST_CHECK(child.parent() == tape);
+			check_equal(child, n);
+		}
+		BOOST_CHECK(!child);
+	}
+}
+
+struct TapeTestFixture
+{
+	TapeTestFixture(const fs::path& xml_path)
+		: file(xml_path.string().c_str())
+		, copy(file.data(), file.data() + file.size() + 1)
+	{
+		doc.parse(file.data());
+		full.parse<rapidxml::parse_default>(&copy.front());
+	}
+
+	//#########################################################################################
+	void test_like_full()
+	{
+		BOOST_CHECK_EQUAL(doc.type(), rapidxml::node_document);
+		check_equal(doc, &full);
+	}
+
+	//#########################################################################################
+	void test_value(const std::string& path, const std::string& expected)
+	{
+		BOOST_CHECK_EQUAL(rxml::value(doc, path), expected);
+		BOOST_CHECK_EQUAL(rxml::value(rxml::get(doc, path)), expected);
+	}
+
+	//#########################################################################################
+	void test_has(const std::string& path, bool has = true)
+	{
+		BOOST_CHECK_EQUAL(static_cast<bool>(rxml::get(&doc, path)), has);
+		if(!has)
+			BOOST_CHECK_THROW(rxml::get(doc, path), rxml::notfound_error);
+	}
+
+	//#########################################################################################
+	void test_locate(const std::string& path, const std::string& expected)
+	{
+		BOOST_CHECK_EQUAL(rxml::locate(rxml::get(doc, path)), expected);
+	}
+
+	//#########################################################################################
+	void test_element_iteration(const std::string& path, const std::string& expected)
+	{
+		std::string names;
+		for(auto& child : rxml::elements(rxml::getnode(doc, path)))
+			names += rxml::name(child) + ",";
+		BOOST_CHECK_EQUAL(names, expected);
+	}
+
+	rapidxml::file<> file;
+	std::vector<char> copy;
+	rxml::tape_document<> doc;
+	rapidxml::xml_document<> full;
+};
+
+
+RXML_START_FIXTURE_TEST(TapeTestFixture, get_rxml_test_path() / "node-test-1.xml")
+
+	RXML_FIXTURE_TEST(test_like_full);
+
+	RXML_FIXTURE_TEST(test_value, "node-test:name", "node-test");
+	RXML_FIXTURE_TEST(test_value, "node-test/info", "\n\t\t\tTest Info\n\t\t\t");
+	RXML_FIXTURE_TEST(test_value, "node-test/info/author:nick", "SirTobi");
+	RXML_FIXTURE_TEST(test_value, "/node-test/info/../list/value", "hallo");
+	RXML_FIXTURE_TEST(test_value, "node-test/xxx/sample:value", "bla");
+
+	RXML_FIXTURE_TEST(test_has, "node-test/xxx/sample");
+	RXML_FIXTURE_TEST(test_has, "node-test/xxxx/sample", false);
+	RXML_FIXTURE_TEST(test_has, "node-test/info:nope", false);
+
+	RXML_FIXTURE_TEST(test_locate, "node-test/info/author:nick", "/node-test/info/author:nick");
+	RXML_FIXTURE_TEST(test_locate, "node-test/xxx", "/node-test/xxx");
+
+	RXML_FIXTURE_TEST(test_element_iteration, "node-test", "info,list,xxx,");
+	RXML_FIXTURE_TEST(test_element_iteration, "node-test/xxx", "sample,");
+
+RXML_END_FIXTURE_TEST()
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_tape_generated)
+{
+	std::ostringstream xml;
+	xml << "\xEF\xBB\xBF<?xml version='1.0'?><!-- <list> --><list>";
+	for(std::size_t i = 0; i < 1000; ++i)
+		xml << "<item id='" << i << "' kind=\"a&amp;b\">item &lt;" << i << "&gt;<![CDATA[<raw/>]]><!-- <x> --><sub/></item>";
+	xml << "</list>";
+	const std::string text = xml.str();
+	std::string copy = text;
+
+	rxml::tape_document<> doc;
+	doc.parse(text.c_str());
+	rapidxml::xml_document<> full;
+	full.parse<rapidxml::parse_default>(&copy[0]);
+
+	check_equal(doc, &full);
+	BOOST_CHECK_EQUAL(rxml::value(doc, "list/item:kind"), "a&b");
+	BOOST_CHECK_EQUAL(rxml::value(doc, "list/item"), "item <0>");
+
+	// document and list open and close, per item open, 2 * 2 attribute entries, data, cdata, sub open and close, close
+	BOOST_CHECK_EQUAL(doc.size(), 4 + 10 * 1000);
+
+	std::size_t count = 0;
+	for(auto& item : rxml::elements(rxml::getnode(doc, "list")))
+	{
+		BOOST_CHECK_EQUAL(rxml::value(item.first_attribute("id")), std::to_string(count));
+		++count;
+	}
+	BOOST_CHECK_EQUAL(count, 1000);
+}
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_tape_error, const char* xml)
+{
+	rxml::tape_document<> doc;
+	BOOST_CHECK_THROW(doc.parse(xml), rapidxml::parse_error);
+}
+
+RXML_PARAM_TEST(test_tape_error, "<a><b></a>");
+RXML_PARAM_TEST(test_tape_error, "<a>");
+RXML_PARAM_TEST(test_tape_error, "</a>");
+RXML_PARAM_TEST(test_tape_error, "<a x=1/>");
+RXML_PARAM_TEST(test_tape_error, "text<a/>");
+RXML_PARAM_TEST(test_tape_error, "<a><!-- </a>");
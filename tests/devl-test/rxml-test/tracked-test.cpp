@@ -0,0 +1,242 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <iterator>
+#include <string>
+#include <vector>
+#include "rxml/tracked.hpp"
+#include "rapidxml_print.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace {
+
+	const char* const sample =
+		"<?xml version='1.0'?>\n"
+		"<!-- settings -->\n"
+		"<config version = '2'>\n"
+		"\t<name>first &amp; only</name>\n"
+		"\t<empty/>\n"
+		"\t<list>\n"
+		"\t\t<item id='1'>one</item>\n"
+		"\t\t<item id='2'>two</item>\n"
+		"\t\t<item id='3'>three</item>\n"
+		"\t</list>\n"
+		"\t<open></open>\n"
+		"</config>\n";
+
+	void erase(std::string& text, const std::string& part)
+	{
+		text.erase(text.find(part), part.size());
+	}
+
+	struct tracked_fixture
+	{
+		tracked_fixture()
+		{
+			doc.parse<0>(sample);
+			config = doc.document().first_node("config");
+			list = config->first_node("list");
+		}
+
+		std::string printed(const rapidxml::xml_node<>& node) const
+		{
+			std::string result;
+			rapidxml::print(std::back_inserter(result), node);
+			return result;
+		}
+
+		// the written text parses into the edited tree
+		void check_reparse() const
+		{
+			std::string text = doc.serialize();
+			BOOST_CHECK_EQUAL(doc.serialized_size(), text.size());
+
+			rapidxml::xml_document<> reparsed;
+			reparsed.parse<rxml::tracked_document<>::required_flags>(&text[0]);
+			BOOST_CHECK_EQUAL(printed(reparsed), printed(doc.document()));
+		}
+
+		rxml::tracked_document<> doc;
+		rapidxml::xml_node<>* config;
+		rapidxml::xml_node<>* list;
+	};
+}
+
+
+//#########################################################################################
+BOOST_FIXTURE_TEST_CASE(test_tracked_unmodified, tracked_fixture)
+{
+	BOOST_CHECK(!doc.modified());
+	BOOST_CHECK_EQUAL(doc.serialize(), sample);
+	BOOST_CHECK_EQUAL(doc.serialized_size(), std::string(sample).size());
+}
+
+
+//#########################################################################################
+BOOST_FIXTURE_TEST_CASE(test_tracked_values, tracked_fixture)
+{
+	doc.value(list->first_node("item")->next_sibling(), "2 < 3");
+	doc.value(config->first_node("name"), "renamed");
+	doc.value(config->first_node("open"), "now & then");
+	doc.value(config->first_attribute("version"), "3\"");
+	BOOST_CHECK(doc.modified());
+
+	std::string expected = sample;
+	expected.replace(expected.find("first &amp; only"), 16, "renamed");
+	expected.replace(expected.find("two"), 3, "2 &lt; 3");
+	expected.replace(expected.find("<open></open>"), 13, "<open>now &amp; then</open>");
+	expected.replace(expected.find("<config version = '2'>"), 22, "<config version='3\"'>");
+	BOOST_CHECK_EQUAL(doc.serialize(), expected);
+	check_reparse();
+}
+
+
+//#########################################################################################
+BOOST_FIXTURE_TEST_CASE(test_tracked_names, tracked_fixture)
+{
+	doc.name(list, "entries");
+	doc.name(config->first_node("empty"), "blank");
+	doc.name(list->first_node()->first_attribute(), "key");
+	doc.value(list->first_node(), "uno");
+
+	std::string expected = sample;
+	expected.replace(expected.find("<list>"), 6, "<entries>");
+	expected.replace(expected.find("</list>"), 7, "</entries>");
+	expected.replace(expected.find("<empty/>"), 8, "<blank/>");
+	expected.replace(expected.find("<item id='1'>one"), 16, "<item key=\"1\">uno");
+	BOOST_CHECK_EQUAL(doc.serialize(), expected);
+	check_reparse();
+}
+
+
+//#########################################################################################
+BOOST_FIXTURE_TEST_CASE(test_tracked_structure, tracked_fixture)
+{
+	rapidxml::xml_document<>& dom = doc.document();
+
+	doc.remove_node(list->first_node());
+	rapidxml::xml_node<>* added = dom.allocate_node(rapidxml::node_element, "item", "four");
+	added->append_attribute(dom.allocate_attribute("id", "4"));
+	doc.append_node(list, added);
+	doc.insert_node(config, config->first_node(), dom.allocate_node(rapidxml::node_comment, nullptr, "first"));
+	doc.append_node(config->first_node("empty"), dom.allocate_node(rapidxml::node_element, "child"));
+	doc.remove_node(config->first_node("open"));
+
+	std::string expected = sample;
+	erase(expected, "\n\t\t<item id='1'>one</item>");
+	expected.replace(expected.find("three</item>") + 12, 0, "\n\t\t<item id=\"4\">four</item>");
+	expected.replace(expected.find("\n\t<name>"), 0, "\n\t<!--first-->");
+	expected.replace(expected.find("<empty/>"), 8, "<empty><child/></empty>");
+	erase(expected, "\n\t<open></open>");
+	BOOST_CHECK_EQUAL(doc.serialize(), expected);
+	check_reparse();
+
+	// edits inside a removed node are gone with it
+	rapidxml::xml_node<>* item = list->first_node();
+	doc.value(item, "changed");
+	doc.remove_node(list);
+	expected.replace(expected.find("\n\t<list>"), expected.find("</list>") + 7 - expected.find("\n\t<list>"), "");
+	BOOST_CHECK_EQUAL(doc.serialize(), expected);
+	check_reparse();
+}
+
+
+//#########################################################################################
+BOOST_FIXTURE_TEST_CASE(test_tracked_moves_and_inserted_edits, tracked_fixture)
+{
+	// a moved node is written like a new one
+	rapidxml::xml_node<>* last = list->last_node();
+	doc.remove_node(last);
+	doc.insert_node(list, list->first_node(), last);
+
+	// edits of inserted nodes need no tracking
+	rapidxml::xml_node<>* added = doc.document().allocate_node(rapidxml::node_element, "note");
+	doc.append_node(config, added);
+	doc.value(added, "a & b");
+	doc.remove_node(config->first_node("name"));
+
+	std::string expected = sample;
+	erase(expected, "\n\t\t<item id='3'>three</item>");
+	expected.replace(expected.find("\t\t<item id='1'>"), 0, "\t\t<item id=\"3\">three</item>\n");
+	expected.replace(expected.find("<open></open>") + 13, 0, "\n\t<note>a &amp; b</note>");
+	expected.replace(expected.find("\n\t<name>"), expected.find("</name>") + 7 - expected.find("\n\t<name>"), "");
+	BOOST_CHECK_EQUAL(doc.serialize(), expected);
+	check_reparse();
+}
+
+
+//#########################################################################################
+BOOST_FIXTURE_TEST_CASE(test_tracked_declaration, tracked_fixture)
+{
+	rapidxml::xml_node<>* decl = doc.document().first_node();
+	BOOST_REQUIRE(decl->type() == rapidxml::node_declaration);
+
+	doc.value(decl->first_attribute("version"), "1.1");
+	doc.append_attribute(decl, doc.document().allocate_attribute("encoding", "utf-8"));
+
+	std::string expected = sample;
+	expected.replace(expected.find("<?xml version='1.0'?>"), 21, "<?xml version=\"1.1\" encoding=\"utf-8\"?>");
+	BOOST_CHECK_EQUAL(doc.serialize(), expected);
+	check_reparse();
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_tracked_trimmed_data)
+{
+	const std::string text = "<a>\n\t<b>  text  </b>\n\t<c>\n\t\tlead\n\t\t<d/>\n\t\ttail\n\t</c>\n</a>";
+	rxml::tracked_document<> doc;
+	doc.parse<rapidxml::parse_trim_whitespace>(text);
+	BOOST_CHECK_EQUAL(doc.serialize(), text);
+
+	// the whitespace around trimmed values stays on both sides
+	rapidxml::xml_node<>* a = doc.document().first_node();
+	rapidxml::xml_node<>* c = a->first_node("c");
+	doc.value(a->first_node("b"), "T");
+	doc.value(c->first_node(), "first");
+	doc.remove_node(c->last_node());
+	doc.append_node(c, doc.document().allocate_node(rapidxml::node_data, nullptr, "end"));
+
+	BOOST_CHECK_EQUAL(doc.serialize(), "<a>\n\t<b>  T  </b>\n\t<c>\n\t\tfirst\n\t\t<d/>\n\t\tend\n\t</c>\n</a>");
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_tracked_file)
+{
+	rapidxml::file<> file((get_rxml_test_path() / "node-test-1.xml").string().c_str());
+	const std::string text(file.data(), file.size() - 1);
+
+	rxml::tracked_document<> doc;
+	doc.parse<rapidxml::parse_trim_whitespace>(text);
+	BOOST_CHECK_EQUAL(doc.serialize(), text);
+
+	// edit every element a little
+	std::vector<rapidxml::xml_node<>*> elements;
+	for(rapidxml::xml_node<>* node = doc.document().first_node(); node; )
+	{
+		if(node->type() == rapidxml::node_element)
+			elements.push_back(node);
+		if(node->first_node())
+		{
+			node = node->first_node();
+			continue;
+		}
+		while(node != &doc.document() && !node->next_sibling())
+			node = node->parent();
+		node = (node != &doc.document())? node->next_sibling() : nullptr;
+	}
+	BOOST_REQUIRE(!elements.empty());
+
+	for(std::size_t i = 0; i < elements.size(); i += 3)
+		doc.append_attribute(elements[i], doc.document().allocate_attribute("edited", "yes"));
+
+	std::string written = doc.serialize();
+	rapidxml::xml_document<> reparsed;
+	reparsed.parse<rxml::tracked_document<>::required_flags | rapidxml::parse_trim_whitespace>(&written[0]);
+
+	std::string expected, result;
+	rapidxml::print(std::back_inserter(expected), doc.document());
+	rapidxml::print(std::back_inserter(result), reparsed);
+	BOOST_CHECK_EQUAL(result, expected);
+}
@@ -0,0 +1,196 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+#include "rxml/validate.hpp"
+#include "rapidxml_utils.hpp"
+
+namespace {
+
+	const char* const sample =
+		"\xEF\xBB\xBF<?xml version='1.0' encoding='utf-8'?>\n"
+		"<!DOCTYPE root [ <!ENTITY e 'x'> ]>\n"
+		"<!-- comment -->\n"
+		"<root a='1 &amp; 2' b=\"&#x41;&#66;\">\n"
+		"\t<?pi target?>\n"
+		"\t<child>text &lt;&gt; &#169;</child>\n"
+		"\t<![CDATA[ <raw> ]]>\n"
+		"\t<empty/><other  x = 'y' />\n"
+		"\t<!unknown decl>\n"
+		"</root>\n";
+
+	// parses a copy of text and returns the result validate should give
+	template<int _Flags>
+	rxml::validation_result parse_result(const std::string& text)
+	{
+		std::vector<char> copy(text.begin(), text.end());
+		copy.push_back(0);
+
+		rxml::validation_result result;
+		rapidxml::xml_document<> doc;
+		try
+		{
+			doc.parse<_Flags>(&copy.front());
+		}catch(const rapidxml::parse_error& e)
+		{
+			result.what = e.what();
+			result.offset = e.where<char>() - &copy.front();
+		}
+		return result;
+	}
+
+	template<int _Flags>
+	void check_like_parser(const std::string& text)
+	{
+		const rxml::validation_result expected = parse_result<_Flags>(text);
+		const rxml::validation_result result = rxml::validate<_Flags>(text);
+
+		BOOST_CHECK_MESSAGE(static_cast<bool>(result) == static_cast<bool>(expected), "validating: " << text);
+		if(!result && !expected)
+		{
+			BOOST_CHECK_EQUAL(std::string(result.what), std::string(expected.what));
+			BOOST_CHECK_EQUAL(result.offset, expected.offset);
+		}
+	}
+
+	void check_all_flags(const std::string& text)
+	{
+		check_like_parser<rapidxml::parse_default>(text);
+		check_like_parser<rapidxml::parse_validate_closing_tags>(text);
+		check_like_parser<rapidxml::parse_full>(text);
+		check_like_parser<rapidxml::parse_no_entity_translation>(text);
+	}
+}
+
+
+RXML_PARAM_TEST_CASE(test_validate_like_parser, const std::string& text)
+{
+	check_all_flags(text);
+}
+
+RXML_PARAM_TEST(test_validate_like_parser, "");
+RXML_PARAM_TEST(test_validate_like_parser, "<a/>");
+RXML_PARAM_TEST(test_validate_like_parser, "  <a></a>  ");
+RXML_PARAM_TEST(test_validate_like_parser, "text");
+RXML_PARAM_TEST(test_validate_like_parser, "<a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a><b></a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a></b>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a></a >");
+RXML_PARAM_TEST(test_validate_like_parser, "<a></a x>");
+RXML_PARAM_TEST(test_validate_like_parser, "<>");
+RXML_PARAM_TEST(test_validate_like_parser, "</a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a/ >");
+RXML_PARAM_TEST(test_validate_like_parser, "<a x></a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a x=1></a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a x='1></a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a x='&#65'/>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a>&bogus; &amp</a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a><!-- x -- </a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a><![CDATA[ x ]></a>");
+RXML_PARAM_TEST(test_validate_like_parser, "<?xml version='1.0'?><a/>");
+RXML_PARAM_TEST(test_validate_like_parser, "<?xml version='1.0' ><a/>");
+RXML_PARAM_TEST(test_validate_like_parser, "<? ?><a/>");
+RXML_PARAM_TEST(test_validate_like_parser, "<!DOCTYPE a [ <!ELEMENT a ANY> <a/>");
+RXML_PARAM_TEST(test_validate_like_parser, "<!bogus <a/>");
+RXML_PARAM_TEST(test_validate_like_parser, "<a/><b/>x");
+
+
+//#########################################################################################
+RXML_PARAM_TEST_CASE(test_validate_namespaces, const std::string& text)
+{
+	check_like_parser<rapidxml::parse_namespaces>(text);
+	check_like_parser<rapidxml::parse_namespaces | rapidxml::parse_validate_closing_tags>(text);
+	check_like_parser<rapidxml::parse_default>(text);
+}
+
+RXML_PARAM_TEST(test_validate_namespaces, "<a:x/>");
+RXML_PARAM_TEST(test_validate_namespaces, "<a:x></a:x>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r xmlns:a='urn:a'><a:x/><b:y/></r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<a:r xmlns:a='urn:a'><a:x>text</a:x></a:r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r><p xmlns:a='urn:a'/><a:x/></r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r><p xmlns:a='urn:a'></p><a:x/></r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r xmlns:a=''><a:x/></r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r xmlns='urn:d'><x/><:y/></r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r><:y/></r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<xml:x/>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r xmlnsa:b='u' xmlns:='v'><b:x/></r>");
+RXML_PARAM_TEST(test_validate_namespaces, "<r a:id='1'/>");
+RXML_PARAM_TEST(test_validate_namespaces, "<a:x y='1>");
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_validate_prefixes)
+{
+	const std::string text = sample;
+	BOOST_CHECK(rxml::validate<rapidxml::parse_full>(text));
+
+	for(std::size_t size = 0; size < text.size(); ++size)
+		check_all_flags(text.substr(0, size));
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_validate_mutations)
+{
+	const std::string text = sample;
+	const std::string replacements = "<>/='\"&#;![]-? x\t";
+	std::mt19937 rng(42);
+
+	for(std::size_t i = 0; i < 2000; ++i)
+	{
+		std::string mutated = text;
+		mutated[rng() % mutated.size()] = replacements[rng() % replacements.size()];
+		if(rng() % 2)
+			mutated[rng() % mutated.size()] = replacements[rng() % replacements.size()];
+		check_all_flags(mutated);
+	}
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_validate_reference_range)
+{
+	// the parser reports where it would have written the character, validate reports the reference
+	const rxml::validation_result result = rxml::validate<rapidxml::parse_default>("<a>&#x41;&#1114112;</a>");
+	BOOST_REQUIRE(!result);
+	BOOST_CHECK_EQUAL(std::string(result.what), "invalid numeric character entity");
+	BOOST_CHECK_EQUAL(result.offset, 9);
+
+	BOOST_CHECK(!parse_result<rapidxml::parse_default>("<a>&#x110000;</a>"));
+	BOOST_CHECK(rxml::validate<rapidxml::parse_no_utf8>("<a>&#x110000;</a>"));
+	BOOST_CHECK(rxml::validate<rapidxml::parse_no_entity_translation>("<a>&#x110000;</a>"));
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_validate_depth)
+{
+	std::string text;
+	for(std::size_t i = 0; i < 10; ++i)
+		text += "<e>";
+	for(std::size_t i = 0; i < 10; ++i)
+		text += "</e>";
+
+	BOOST_CHECK((rxml::validate<rapidxml::parse_validate_closing_tags, 10>(text)));
+
+	const rxml::validation_result result = rxml::validate<rapidxml::parse_validate_closing_tags, 9>(text);
+	BOOST_REQUIRE(!result);
+	BOOST_CHECK_EQUAL(std::string(result.what), "element nesting too deep");
+	BOOST_CHECK_EQUAL(result.offset, 9 * 3 + 1);
+
+	// without name checks there is no stack to overflow
+	BOOST_CHECK((rxml::validate<rapidxml::parse_default, 1>(text)));
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_validate_file)
+{
+	rapidxml::file<> file((get_rxml_test_path() / "node-test-1.xml").string().c_str());
+	const std::string text(file.data(), file.size());
+
+	BOOST_CHECK(rxml::validate<rapidxml::parse_validate_closing_tags>(text));
+	BOOST_CHECK(rxml::validate<rapidxml::parse_full>(file.data()));
+}
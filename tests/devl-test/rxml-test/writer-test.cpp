@@ -0,0 +1,139 @@
+#include "test_settings.hpp"
+#include "test_config.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "rxml/writer.hpp"
+#include "rapidxml_print.hpp"
+
+namespace {
+
+	// describes the tree to the writer in document order
+	void replay(rxml::writer<>& out, const rapidxml::xml_node<>* node)
+	{
+		switch(node->type())
+		{
+		case rapidxml::node_element:
+			out.start_element(node->name(), node->name_size());
+			for(const rapidxml::xml_attribute<>* attr = node->first_attribute(); attr; attr = attr->next_attribute())
+				out.attribute(std::string(attr->name(), attr->name_size()), std::string(attr->value(), attr->value_size()));
+			for(const rapidxml::xml_node<>* child = node->first_node(); child; child = child->next_sibling())
+				replay(out, child);
+			out.end_element();
+			break;
+
+		case rapidxml::node_data:
+			out.text(node->value(), node->value_size());
+			break;
+
+		case rapidxml::node_cdata:
+			out.cdata(node->value(), node->value_size());
+			break;
+
+		case rapidxml::node_comment:
+			out.comment(node->value(), node->value_size());
+			break;
+
+		default:
+			for(const rapidxml::xml_node<>* child = node->first_node(); child; child = child->next_sibling())
+				replay(out, child);
+			break;
+		}
+	}
+}
+
+
+RXML_PARAM_TEST_CASE(test_writer_like_print, const std::string& text)
+{
+	std::vector<char> buffer(text.begin(), text.end());
+	buffer.push_back(0);
+	rapidxml::xml_document<> doc;
+	doc.parse<rapidxml::parse_comment_nodes>(&buffer.front());
+
+	for(int flags : {0, rapidxml::print_no_indenting})
+	{
+		// print adds a line break after the document itself, the writer does not know where the document ends
+		std::string expected;
+		for(const rapidxml::xml_node<>* node = doc.first_node(); node; node = node->next_sibling())
+			rapidxml::print(std::back_inserter(expected), *node, flags);
+
+		for(std::size_t buffer_size : {16, 23, 4096})
+		{
+			std::string result;
+			{
+				rxml::writer<> out([&](const char* data, std::size_t size) { result.append(data, size); }, flags, buffer_size);
+				replay(out, &doc);
+				BOOST_CHECK_EQUAL(out.depth(), 0);
+			}
+			BOOST_CHECK_EQUAL(result, expected);
+		}
+	}
+}
+
+RXML_PARAM_TEST(test_writer_like_print, "<a/>");
+RXML_PARAM_TEST(test_writer_like_print, "<a>text</a>");
+RXML_PARAM_TEST(test_writer_like_print, "<a x='1' y='say \"hi\"' z=\"it's\"><b/><c>v &amp; w</c></a>");
+RXML_PARAM_TEST(test_writer_like_print, "<a>lead<b/>tail<c><d>a rather long text &lt;with&gt; escapes</d></c></a>");
+RXML_PARAM_TEST(test_writer_like_print, "<a>one<!-- two --><![CDATA[ <three> ]]></a><b>two<c/></b>");
+RXML_PARAM_TEST(test_writer_like_print, "<!-- top --><a><b><c><d/></c></b></a>");
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_writer_bounded_buffer)
+{
+	const std::size_t buffer_size = 64;
+	std::string result;
+	std::vector<std::size_t> calls;
+	{
+		rxml::writer<> out([&](const char* data, std::size_t size) { result.append(data, size); calls.push_back(size); }, 0, buffer_size);
+		out.start_element("list");
+		for(int i = 0; i < 10000; ++i)
+		{
+			out.start_element("item");
+			out.attribute("id", std::to_string(i).c_str());
+			out.text("value & more");
+			out.end_element();
+		}
+
+		// runs longer than the buffer go to the sink directly
+		out.start_element("big");
+		out.text(std::string(1000, 'x'));
+		out.end_element();
+		out.end_element();
+	}
+
+	BOOST_CHECK(calls.size() > 1000);
+	BOOST_CHECK_EQUAL(std::count(calls.begin(), calls.end(), 1000), 1);
+	BOOST_CHECK(std::count_if(calls.begin(), calls.end(), [&](std::size_t size) { return size > buffer_size; }) == 1);
+
+	const std::string head = "<list>\n\t<item id=\"0\">value &amp; more</item>\n";
+	const std::string tail = "x</big>\n</list>\n";
+	BOOST_CHECK_EQUAL(result.substr(0, head.size()), head);
+	BOOST_CHECK_EQUAL(result.substr(result.size() - tail.size()), tail);
+}
+
+
+//#########################################################################################
+BOOST_AUTO_TEST_CASE(test_writer_file_descriptor)
+{
+	std::FILE* file = std::tmpfile();
+	BOOST_REQUIRE(file);
+	{
+		rxml::writer<> out(fileno(file), rapidxml::print_no_indenting, 16);
+		out.start_element("root");
+		out.attribute("a", "<&>");
+		out.text("some text that does not fit into the buffer");
+		out.end_element();
+	}
+
+	std::rewind(file);
+	std::string result;
+	for(int ch; (ch = std::fgetc(file)) != EOF; )
+		result += static_cast<char>(ch);
+	std::fclose(file);
+
+	BOOST_CHECK_EQUAL(result, "<root a=\"&lt;&amp;&gt;\">some text that does not fit into the buffer</root>");
+}
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef TEST_HELPERS_HPP
+#define TEST_HELPERS_HPP
+/*
+ * =====================================================================================
+ *
+ *       Filename:  test_helpers.hpp
+ *
+ *    Description:  Helpers shared by the tests of several documents
+ *
+ * =====================================================================================
+ */
+
+#include <rapidxml.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// appends type, name, value, attributes and children of node and its subtree to result
+inline void dump_tree(const rapidxml::xml_node<>* node, std::string& result)
+{
+	result.append(1, char('0' + node->type())).append(node->name(), node->name_size())
+		.append("|").append(node->value(), node->value_size()).append("|");
+	for(auto* a = node->first_attribute(); a; a = a->next_attribute())
+		result.append(a->name(), a->name_size()).append("=").append(a->value(), a->value_size()).append("|");
+
+	result.append("(");
+	for(auto* n = node->first_node(); n; n = n->next_sibling())
+		dump_tree(n, result);
+	result.append(")");
+}
+
+
+// arena recording the blocks a memory pool allocates; may be shared by pools on several threads
+struct counting_arena
+	: public rapidxml::memory_arena
+{
+	virtual void* allocate(std::size_t size) override
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++allocations;
+		sizes.push_back(size);
+		live += size;
+		return new char[size];
+	}
+
+	virtual void deallocate(void* memory, std::size_t size) override
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		live -= size;
+		delete[] static_cast<char*>(memory);
+	}
+
+	std::atomic<std::size_t> allocations{0};
+	std::vector<std::size_t> sizes;		// of every allocated block
+	std::size_t live = 0;				// bytes not yet deallocated
+	std::mutex mutex;
+};
+
+
+
+#endif